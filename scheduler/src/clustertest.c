@@ -0,0 +1,168 @@
+/** @file clustertest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "libcluster/libcluster.h"
+
+#define JOBS 400
+
+
+/*
+ * Builds a cluster of four nodes of different sizes and schemes with the
+ * jobs, runs it and returns it.
+ */
+cluster_t *run(simulator_job_t *jobs, dispatch_t dispatch, int threads, int window)
+{
+	const char *specs[] = { "rr2@2", "psjf@1", "fcfs@3", "cfs@2" };
+	cluster_t *c = cluster_create(dispatch, 7);
+	int i;
+
+	for (i = 0; i < 4; i++)
+	{
+		scheme_t scheme;
+		scheduler_options_t options;
+		int cores, *speeds;
+
+		cluster_parse_node(specs[i], &cores, &speeds, &scheme, &options);
+		cluster_add_node(c, cores, scheme, &options);
+	}
+
+	for (i = 0; i < JOBS; i++)
+		cluster_add_job(c, &jobs[i]);
+
+	if (cluster_run(c, threads, window) != 0)
+		printf("Cluster run failed.\n");
+
+	return c;
+}
+
+char *summary(cluster_t *c)
+{
+	char *text = NULL;
+	size_t size = 0;
+	FILE *out = open_memstream(&text, &size);
+
+	cluster_print_summary(c, out);
+	fclose(out);
+	return text;
+}
+
+int main()
+{
+	simulator_job_t *jobs = calloc(JOBS, sizeof(simulator_job_t));
+	int failures = 0;
+	int i;
+
+	/*
+	 * Populate some jobs, a few with I/O bursts... No two arrive together:
+	 * the simulator breaks such ties by where the jobs sit in its job list,
+	 * which depends on when they were added.
+	 */
+	srand(241);
+	for (i = 0; i < JOBS; i++)
+	{
+		jobs[i].arrival_time = (i > 0 ? jobs[i - 1].arrival_time : 0) + 1 + rand() % 2;
+		jobs[i].run_time = 1 + rand() % 12;
+		jobs[i].priority = rand() % 5;
+		jobs[i].burst_ct = 1;
+
+		if (i % 10 == 0)
+		{
+			jobs[i].burst_ct = 3;
+			jobs[i].bursts = malloc(3 * sizeof(int));
+			jobs[i].bursts[0] = jobs[i].run_time;
+			jobs[i].bursts[1] = 1 + rand() % 8;
+			jobs[i].bursts[2] = 1 + rand() % 6;
+		}
+	}
+
+	/* Round robin sends the jobs to the nodes in turn, in order of arrival. */
+	cluster_t *c = run(jobs, DISPATCH_RR, 1, 1);
+	int routed = 1, total = 0;
+	for (i = 0; i < cluster_nodes(c); i++)
+	{
+		int finished = scheduler_average_turnaround_time_r(simulator_scheduler(cluster_node(c, i))) > 0;
+
+		total += cluster_node_jobs(c, i);
+		if (!finished || simulator_active_jobs(cluster_node(c, i)) != 0)
+			routed = 0;
+	}
+	printf("Jobs routed: %d, all finished: %s (expected %d yes).\n", total, routed ? "yes" : "no", JOBS);
+	if (!routed || total != JOBS)
+		failures++;
+
+	int turns = 1;
+	for (i = 0; i < cluster_nodes(c); i++)
+		if (cluster_node_jobs(c, i) != JOBS / 4)
+			turns = 0;
+	printf("Round robin spreads the jobs evenly: %s (expected yes).\n", turns ? "yes" : "no");
+	if (!turns)
+		failures++;
+	cluster_destroy(c);
+
+	/* The results do not depend on the number of threads. */
+	for (dispatch_t d = DISPATCH_RR; d <= DISPATCH_JSQ; d++)
+	{
+		cluster_t *single = run(jobs, d, 1, 3);
+		char *expected = summary(single);
+		int same = 1;
+
+		for (int threads = 2; threads <= 4; threads += 2)
+		{
+			cluster_t *parallel = run(jobs, d, threads, 3);
+			char *actual = summary(parallel);
+
+			if (strcmp(expected, actual) != 0)
+				same = 0;
+			for (i = 0; i < JOBS; i++)
+				if (cluster_job_node(single, i) != cluster_job_node(parallel, i))
+					same = 0;
+
+			free(actual);
+			cluster_destroy(parallel);
+		}
+
+		printf("Dispatching by %s gives the same results on 1, 2 and 4 threads: %s (expected yes).\n", cluster_dispatch_name(d), same ? "yes" : "no");
+		if (!same)
+			failures++;
+
+		free(expected);
+		cluster_destroy(single);
+	}
+
+	/* A cluster of one node is a plain simulation. */
+	scheme_t scheme;
+	scheduler_options_t options;
+	int cores, *speeds;
+	cluster_parse_node("ppri@3", &cores, &speeds, &scheme, &options);
+
+	c = cluster_create(DISPATCH_JSQ, 1);
+	cluster_add_node(c, cores, scheme, &options);
+	simulator_t *sim = simulator_create(cores, scheme, &options);
+	for (i = 0; i < JOBS; i++)
+	{
+		cluster_add_job(c, &jobs[i]);
+		simulator_add_job(sim, &jobs[i]);
+	}
+	cluster_run(c, 1, 1);
+	simulator_run(sim);
+
+	scheduler_t *node = simulator_scheduler(cluster_node(c, 0));
+	scheduler_t *plain = simulator_scheduler(sim);
+	int equal = scheduler_average_waiting_time_r(node) == scheduler_average_waiting_time_r(plain)
+		&& scheduler_average_response_time_r(node) == scheduler_average_response_time_r(plain)
+		&& simulator_time(cluster_node(c, 0)) == simulator_time(sim);
+	printf("A single node matches a plain simulation: %s (expected yes).\n", equal ? "yes" : "no");
+	if (!equal)
+		failures++;
+
+	cluster_destroy(c);
+	simulator_destroy(sim);
+	simulator_free_jobs(jobs, JOBS);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
@@ -0,0 +1,184 @@
+/** @file cpriqueuebench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "libcpriqueue/libcpriqueue.h"
+
+/* Shards of the sharded runs for each producer or consumer thread, as cpriqueue_init() suggests */
+#define SHARDS_PER_THREAD 2
+
+
+/**
+  One run of the benchmark: a fixed number of elements pushed through the
+  queue by a number of producers and as many consumers.
+*/
+typedef struct _bench_t
+{
+	cpriqueue_t queue;
+	int *values;
+	int count;
+	int threads;
+	atomic_int polled;
+	pthread_barrier_t start;
+} bench_t;
+
+typedef struct _bench_thread_t
+{
+	bench_t *bench;
+	int index;
+} bench_thread_t;
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-n <elements>] [-t <max threads>]\n", program_name);
+	fprintf(stderr, "       %s -n 1000000 -t 64\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Pushes the elements through the queue with 1, 2, 4, ... producers and as many\n");
+	fprintf(stderr, "consumers, once with a single shard (a heap behind one lock) and once with\n");
+	fprintf(stderr, "two shards per thread.\n");
+}
+
+
+int compare1(const void * a, const void * b)
+{
+	// The values reach RAND_MAX, so a difference could overflow.
+	int x = *(const int *)a, y = *(const int *)b;
+
+	return (x > y) - (x < y);
+}
+
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static void *producer(void *arg)
+{
+	bench_thread_t *t = arg;
+	bench_t *b = t->bench;
+
+	pthread_barrier_wait(&b->start);
+	for (int i = t->index; i < b->count; i += b->threads)
+		cpriqueue_offer(&b->queue, &b->values[i]);
+	return NULL;
+}
+
+
+static void *consumer(void *arg)
+{
+	bench_thread_t *t = arg;
+	bench_t *b = t->bench;
+
+	pthread_barrier_wait(&b->start);
+	while (atomic_load_explicit(&b->polled, memory_order_relaxed) < b->count)
+		if (cpriqueue_poll(&b->queue) != NULL)
+			atomic_fetch_add_explicit(&b->polled, 1, memory_order_relaxed);
+	return NULL;
+}
+
+
+/*
+ * Returns the seconds it takes the producers and consumers to push every
+ * element through a queue of the given number of shards.
+ */
+static double run(int *values, int count, int threads, int shards)
+{
+	bench_t b;
+	pthread_t ids[2 * threads];
+	bench_thread_t args[threads];
+
+	cpriqueue_init(&b.queue, shards, compare1);
+	b.values = values;
+	b.count = count;
+	b.threads = threads;
+	atomic_init(&b.polled, 0);
+	pthread_barrier_init(&b.start, NULL, 2 * threads + 1);
+
+	for (int i = 0; i < threads; i++)
+	{
+		args[i].bench = &b;
+		args[i].index = i;
+		pthread_create(&ids[i], NULL, producer, &args[i]);
+		pthread_create(&ids[threads + i], NULL, consumer, &args[i]);
+	}
+
+	pthread_barrier_wait(&b.start);
+	double start = now();
+	for (int i = 0; i < 2 * threads; i++)
+		pthread_join(ids[i], NULL);
+	double elapsed = now() - start;
+
+	pthread_barrier_destroy(&b.start);
+	cpriqueue_destroy(&b.queue);
+	return elapsed;
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	int count = 1000000, max_threads = 64;
+
+	while ((c = getopt(argc, argv, "n:t:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n':
+				count = atoi(optarg);
+
+				if (count <= 0)
+				{
+					fprintf(stderr, "Option -n <elements> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 't':
+				max_threads = atoi(optarg);
+
+				if (max_threads <= 0)
+				{
+					fprintf(stderr, "Option -t <max threads> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	int *values = malloc(count * sizeof(int));
+	srand(241);
+	for (int i = 0; i < count; i++)
+		values[i] = rand();
+
+	printf("%d element(s) on %ld hardware thread(s).\n\n", count, sysconf(_SC_NPROCESSORS_ONLN));
+	printf("Producers  Consumers  One lock (Mops/s)  Sharded (Mops/s)  Shards\n");
+	for (int threads = 1; threads <= max_threads; threads *= 2)
+	{
+		double locked = run(values, count, threads, 1);
+		double sharded = run(values, count, threads, SHARDS_PER_THREAD * threads);
+
+		// Every element is offered and polled once: two operations each.
+		printf("%9d  %9d  %17.2f  %16.2f  %6d\n", threads, threads,
+				2 * count / locked / 1e6, 2 * count / sharded / 1e6, SHARDS_PER_THREAD * threads);
+	}
+
+	free(values);
+	return 0;
+}
@@ -0,0 +1,137 @@
+/** @file cpriqueuetest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "libcpriqueue/libcpriqueue.h"
+
+#define THREADS 8
+#define PER_THREAD 20000
+
+int compare1(const void * a, const void * b)
+{
+	return ( *(int*)a - *(int*)b );
+}
+
+cpriqueue_t shared;
+int *values;
+atomic_int *seen;
+atomic_int polled;
+
+void *producer(void *arg)
+{
+	int first = *(int *)arg * PER_THREAD;
+
+	for (int i = first; i < first + PER_THREAD; i++)
+		cpriqueue_offer(&shared, &values[i]);
+	return NULL;
+}
+
+void *consumer(void *arg)
+{
+	while (atomic_load(&polled) < THREADS * PER_THREAD)
+	{
+		int *value = cpriqueue_poll(&shared);
+
+		if (value != NULL)
+		{
+			atomic_fetch_add(&seen[*value], 1);
+			atomic_fetch_add(&polled, 1);
+		}
+	}
+	return NULL;
+}
+
+int main()
+{
+	cpriqueue_t q;
+	int failures = 0;
+	int n = THREADS * PER_THREAD;
+	int i;
+
+	/* Pupulate some data... */
+	values = malloc(n * sizeof(int));
+	for (i = 0; i < n; i++)
+		values[i] = i;
+
+	/* One shard is an exact priority queue. */
+	cpriqueue_init(&q, 1, compare1);
+	srand(241);
+	for (i = 0; i < 1000; i++)
+		cpriqueue_offer(&q, &values[rand() % n]);
+	printf("Total elements: %d (expected 1000).\n", cpriqueue_size(&q));
+	if (cpriqueue_size(&q) != 1000)
+		failures++;
+
+	int last = -1, sorted = 1;
+	for (i = 0; i < 1000; i++)
+	{
+		int value = *(int *)cpriqueue_poll(&q);
+
+		if (value < last)
+			sorted = 0;
+		last = value;
+	}
+	printf("Elements polled in order: %s (expected yes).\n", sorted ? "yes" : "no");
+	printf("Polling an empty queue: %s (expected NULL).\n", cpriqueue_poll(&q) == NULL ? "NULL" : "not NULL");
+	if (!sorted || cpriqueue_poll(&q) != NULL)
+		failures++;
+	cpriqueue_destroy(&q);
+
+	/* Many shards: every element still comes out once, roughly in order. */
+	cpriqueue_init(&q, 16, compare1);
+	for (i = 0; i < 1000; i++)
+		cpriqueue_offer(&q, &values[i]);
+
+	int count = 0, early = 0;
+	for (i = 0; i < 1000; i++)
+	{
+		int *value = cpriqueue_poll(&q);
+
+		if (value != NULL)
+			count++;
+		if (i < 100 && value != NULL && *value >= 500)
+			early++;
+	}
+	printf("Elements polled from 16 shards: %d, late ones among the first 100: %d (expected 1000 0).\n", count, early);
+	if (count != 1000 || early != 0 || cpriqueue_poll(&q) != NULL)
+		failures++;
+	cpriqueue_destroy(&q);
+
+	/* Concurrent producers and consumers: nothing is lost or duplicated. */
+	cpriqueue_init(&shared, 2 * THREADS, compare1);
+	seen = calloc(n, sizeof(atomic_int));
+	atomic_init(&polled, 0);
+
+	pthread_t producers[THREADS], consumers[THREADS];
+	int ids[THREADS];
+	for (i = 0; i < THREADS; i++)
+	{
+		ids[i] = i;
+		pthread_create(&producers[i], NULL, producer, &ids[i]);
+		pthread_create(&consumers[i], NULL, consumer, NULL);
+	}
+	for (i = 0; i < THREADS; i++)
+	{
+		pthread_join(producers[i], NULL);
+		pthread_join(consumers[i], NULL);
+	}
+
+	int once = 1;
+	for (i = 0; i < n; i++)
+		if (atomic_load(&seen[i]) != 1)
+			once = 0;
+	printf("Every element polled exactly once by %d consumers: %s (expected yes).\n", THREADS, once ? "yes" : "no");
+	if (!once || cpriqueue_size(&shared) != 0)
+		failures++;
+	cpriqueue_destroy(&shared);
+
+	free(seen);
+	free(values);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
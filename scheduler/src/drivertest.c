@@ -0,0 +1,188 @@
+/** @file drivertest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "libdriver/libdriver.h"
+
+#define MAX_JOBS 2000
+#define MAX_CORES 4
+
+
+/*
+ * Jobs handed to the driver one at a time, and what it reported of them.
+ */
+typedef struct _feed_t
+{
+	driver_job_t jobs[MAX_JOBS];
+	int count;
+	int next;
+	int arrived;
+	int ahead;                  ///< Most jobs handed over beyond those due by an arrival
+	int core_job[MAX_CORES];
+	int came[MAX_JOBS];
+	int ran[MAX_JOBS];          ///< Time units each job spent on a core
+	int since[MAX_JOBS];
+	int finished[MAX_JOBS];
+	int errors;
+} feed_t;
+
+int next_job(void *context, driver_job_t *job)
+{
+	feed_t *f = context;
+
+	if (f->next == f->count)
+		return 0;
+	*job = f->jobs[f->next++];
+	return 1;
+}
+
+/*
+ * Jobs that arrive together may arrive in any order, but each arrives once
+ * and only once it is due. By then, the driver should have taken no more
+ * than one job beyond those due.
+ */
+void arrived(void *context, int time, int job)
+{
+	feed_t *f = context;
+	int due = f->arrived;
+
+	if (job >= f->next || f->came[job] || time < f->jobs[job].arrival_time)
+		f->errors++;
+	f->came[job] = 1;
+	f->arrived++;
+
+	while (due < f->count && f->jobs[due].arrival_time <= time)
+		due++;
+	if (f->next - due > f->ahead)
+		f->ahead = f->next - due;
+}
+
+void assigned(void *context, int time, int job, int core)
+{
+	feed_t *f = context;
+
+	if (f->core_job[core] != -1 || !f->came[job] || f->finished[job])
+		f->errors++;
+	f->core_job[core] = job;
+	f->since[job] = time;
+}
+
+void released(void *context, int time, int job, int core, driver_release_t why)
+{
+	feed_t *f = context;
+
+	if (f->core_job[core] != job)
+		f->errors++;
+	f->core_job[core] = -1;
+	f->ran[job] += time - f->since[job];
+	if (why == DRIVER_FINISHED)
+		f->finished[job]++;
+}
+
+/*
+ * Runs the jobs of the feed, checking that no core runs two jobs at once,
+ * that every job ran for exactly its running time and finished once, and
+ * that the jobs were taken no sooner than needed.
+ */
+int check(feed_t *f, int cores, const char *scheme, driver_result_t *result)
+{
+	driver_callbacks_t callbacks = { arrived, assigned, released, f };
+
+	f->next = f->arrived = f->ahead = f->errors = 0;
+	memset(f->came, 0, sizeof(f->came));
+	memset(f->ran, 0, sizeof(f->ran));
+	memset(f->finished, 0, sizeof(f->finished));
+	for (int i = 0; i < MAX_CORES; i++)
+		f->core_job[i] = -1;
+
+	if (driver_run(cores, scheme, next_job, f, &callbacks, result) != 0)
+		return 0;
+
+	int ok = (f->errors == 0 && f->ahead <= 1 && result->jobs == f->count);
+	for (int i = 0; i < f->count; i++)
+		if (f->ran[i] != f->jobs[i].run_time || f->finished[i] != 1)
+			ok = 0;
+	return ok;
+}
+
+int main()
+{
+	feed_t *f = calloc(1, sizeof(feed_t));
+	driver_result_t result;
+	int failures = 0;
+	int i;
+
+	/* The jobs of examples/proc1.csv, with the averages of the expected outputs. */
+	driver_job_t proc1[] = { { 0, 8, 4, 0 }, { 4, 6, 1, 0 }, { 20, 7, 3, 0 }, { 22, 3, 2, 0 } };
+	memcpy(f->jobs, proc1, sizeof(proc1));
+	f->count = 4;
+
+	int ok = check(f, 1, "fcfs", &result);
+	printf("fcfs on 1 core: waiting %.2f, turnaround %.2f, response %.2f, consistent: %s (expected 2.25 8.25 2.25 yes).\n",
+			result.average_waiting_time, result.average_turnaround_time, result.average_response_time, ok ? "yes" : "no");
+	if (!ok || fabs(result.average_turnaround_time - 8.25) > 0.001 || fabs(result.average_waiting_time - 2.25) > 0.001)
+		failures++;
+
+	/* 24 time units of work, with the core idle from 14 to 20. */
+	printf("fcfs on 1 core: done by time %d, utilization %.2f (expected 30, 0.80).\n", result.end_time, result.utilization);
+	if (result.end_time != 30 || fabs(result.utilization - 0.8) > 0.001)
+		failures++;
+
+	ok = check(f, 1, "rr2", &result);
+	printf("rr2 on 1 core: waiting %.2f, turnaround %.2f, response %.2f, consistent: %s (expected 3.25 9.25 1.00 yes).\n",
+			result.average_waiting_time, result.average_turnaround_time, result.average_response_time, ok ? "yes" : "no");
+	if (!ok || fabs(result.average_turnaround_time - 9.25) > 0.001 || fabs(result.average_response_time - 1.0) > 0.001)
+		failures++;
+
+	/*
+	 * Populate many jobs with a long idle stretch in the middle, which is
+	 * skipped, and check every scheme against the callbacks.
+	 */
+	srand(49);
+	f->count = MAX_JOBS;
+	for (i = 0; i < MAX_JOBS; i++)
+	{
+		f->jobs[i].arrival_time = (i > 0 ? f->jobs[i - 1].arrival_time : 0) + rand() % 4 + (i == MAX_JOBS / 2 ? 1000000 : 0);
+		f->jobs[i].run_time = 1 + rand() % 9;
+		f->jobs[i].priority = rand() % 5;
+		f->jobs[i].deadline = f->jobs[i].arrival_time + 20 + rand() % 40;
+	}
+
+	const char *schemes[] = { "fcfs", "sjf", "psjf", "pri", "ppri", "edf", "pedf", "rr3", "mlfq", "cfs", "stride", "lottery" };
+	int consistent = 0;
+	for (i = 0; i < 12; i++)
+		consistent += check(f, 3, schemes[i], &result);
+	printf("Schemes run consistently with the callbacks: %d of 12 (expected 12).\n", consistent);
+	if (consistent != 12)
+		failures++;
+
+	/* The cores were busy for the running times of the jobs, out of every core's time from the first arrival. */
+	long long work = 0;
+	for (i = 0; i < MAX_JOBS; i++)
+		work += f->jobs[i].run_time;
+	double utilization = work / ((double)(result.end_time - f->jobs[0].arrival_time) * 3);
+
+	printf("Last job done by time %d, utilization %.5f (expected under %d, %.5f).\n", result.end_time, result.utilization,
+			f->jobs[MAX_JOBS - 1].arrival_time + 1000, utilization);
+	if (result.end_time >= f->jobs[MAX_JOBS - 1].arrival_time + 1000 || fabs(result.utilization - utilization) > 0.00001)
+		failures++;
+
+	/* Jobs out of order, and an unknown scheme, are refused. */
+	f->jobs[10].arrival_time = f->jobs[9].arrival_time - 1;
+	f->next = 0;
+	int refused = (driver_run(2, "fcfs", next_job, f, NULL, &result) != 0);
+	f->next = 0;
+	refused += (driver_run(2, "sjn", next_job, f, NULL, &result) != 0);
+	printf("Runs refused: %d of 2 (expected 2).\n", refused);
+	if (refused != 2)
+		failures++;
+
+	free(f);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
@@ -0,0 +1,220 @@
+/** @file eventlog2json.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "libeventlog/libeventlog.h"
+
+#define BATCH 4096
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-u <unit>] <event log> [output file]\n", program_name);
+	fprintf(stderr, "       %s -u 1000 run.events run.json\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Converts an event log written by the simulator with --events to the Chrome\n");
+	fprintf(stderr, "trace event format, for timeline viewers such as Perfetto or about:tracing:\n");
+	fprintf(stderr, "a track per core showing the jobs it ran, and one for arrivals and wakeups.\n");
+	fprintf(stderr, "Writes to standard output when no output file is given.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -u  microseconds per time unit (default 1000)\n");
+}
+
+
+/*
+ * Where the events of the log go: every core is a thread of one process,
+ * and arrivals and wakeups are on a thread of their own after the cores.
+ */
+static int first = 1;
+
+static void begin_event(FILE *out)
+{
+	fprintf(out, (first ? "\n" : ",\n"));
+	first = 0;
+}
+
+
+static void print_slice(FILE *out, int job, int core, int start, int end, int unit, const char *why)
+{
+	// A job preempted the moment it was dispatched never ran.
+	if (end == start)
+		return;
+
+	begin_event(out);
+	fprintf(out, "{\"name\":\"job %d\",\"cat\":\"job\",\"ph\":\"X\",\"pid\":0,\"tid\":%d,\"ts\":%lld,\"dur\":%lld,\"args\":{\"job\":%d,\"until\":\"%s\"}}",
+			job, core, (long long)start * unit, (long long)(end - start) * unit, job, why);
+}
+
+
+static void print_instant(FILE *out, int job, int track, int time, int unit, const char *what)
+{
+	begin_event(out);
+	fprintf(out, "{\"name\":\"%s %d\",\"cat\":\"%s\",\"ph\":\"i\",\"s\":\"t\",\"pid\":0,\"tid\":%d,\"ts\":%lld,\"args\":{\"job\":%d}}",
+			what, job, what, track, (long long)time * unit, job);
+}
+
+
+static void print_thread_name(FILE *out, int track, const char *name, int index)
+{
+	begin_event(out);
+	fprintf(out, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%d,\"args\":{\"name\":\"", track);
+	fprintf(out, name, index);
+	fprintf(out, "\"}}");
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	int unit = 1000;
+
+	while ((c = getopt(argc, argv, "u:")) != -1)
+	{
+		switch (c)
+		{
+			case 'u':
+				unit = atoi(optarg);
+
+				if (unit <= 0)
+				{
+					fprintf(stderr, "Option -u <unit> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (optind != argc - 1 && optind != argc - 2)
+	{
+		fprintf(stderr, "An event log and at most one output file are required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	FILE *in = fopen(argv[optind], "rb");
+	if (in == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", argv[optind]);
+		return 2;
+	}
+
+	int cores;
+	if (eventlog_read_header(in, &cores) != 0)
+	{
+		fprintf(stderr, "\"%s\" is not an event log.\n", argv[optind]);
+		fclose(in);
+		return 2;
+	}
+
+	FILE *out = stdout;
+	if (optind == argc - 2 && (out = fopen(argv[optind + 1], "w")) == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", argv[optind + 1]);
+		fclose(in);
+		return 2;
+	}
+
+
+	/*
+	 * Stream the log through, remembering only which job each core runs
+	 * and since when: a slice is written once its job leaves the core.
+	 */
+	int *running = malloc(cores * sizeof(int));
+	int *since = malloc(cores * sizeof(int));
+	eventlog_event_t *events = malloc(BATCH * sizeof(eventlog_event_t));
+	long long count = 0;
+	int n, last = 0;
+
+	for (int i = 0; i < cores; i++)
+		running[i] = -1;
+
+	fprintf(out, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+	for (int i = 0; i < cores; i++)
+		print_thread_name(out, i, "Core %d", i);
+	print_thread_name(out, cores, "Arrivals", 0);
+
+	while ((n = eventlog_read(in, events, BATCH)) > 0)
+	{
+		for (int k = 0; k < n; k++)
+		{
+			eventlog_event_t *e = &events[k];
+
+			// Only a dispatch must name a core; other events may be on none, as -1.
+			if (e->core < -1 || e->core >= cores || (e->type == EVENT_DISPATCH && e->core < 0))
+			{
+				fprintf(stderr, "Event %lld is on core %d, which the log does not have.\n", count + k, e->core);
+				free(events);
+				free(since);
+				free(running);
+				fclose(in);
+				if (out != stdout)
+					fclose(out);
+				return 2;
+			}
+			last = e->time;
+
+			switch (e->type)
+			{
+				case EVENT_ARRIVE:
+				case EVENT_WAKE:
+					print_instant(out, e->job, cores, e->time, unit, (e->type == EVENT_ARRIVE ? "arrive" : "wake"));
+					break;
+
+				case EVENT_DISPATCH:
+					// A job stolen by another core leaves its old one without an event of its own.
+					for (int i = 0; i < cores; i++)
+					{
+						if (running[i] == e->job && i != e->core)
+						{
+							print_slice(out, running[i], i, since[i], e->time, unit, "migrate");
+							running[i] = -1;
+						}
+					}
+					if (running[e->core] != e->job)
+					{
+						if (running[e->core] != -1)
+							print_slice(out, running[e->core], e->core, since[e->core], e->time, unit, "preempt");
+						running[e->core] = e->job;
+						since[e->core] = e->time;
+					}
+					break;
+
+				default:
+					if (e->core >= 0 && running[e->core] == e->job)
+					{
+						print_slice(out, e->job, e->core, since[e->core], e->time, unit, eventlog_type_name(e->type));
+						running[e->core] = -1;
+					}
+					if (e->type == EVENT_FINISH)
+						print_instant(out, e->job, e->core, e->time, unit, "finish");
+					break;
+			}
+		}
+		count += n;
+	}
+
+	// A log cut short leaves jobs running; their slices end with the last event.
+	for (int i = 0; i < cores; i++)
+		if (running[i] != -1)
+			print_slice(out, running[i], i, since[i], last, unit, "end of log");
+
+	fprintf(out, "\n]}\n");
+
+	fprintf(stderr, "Converted %lld event(s) on %d core(s).\n", count, cores);
+
+	free(events);
+	free(since);
+	free(running);
+	fclose(in);
+	if (out != stdout)
+		fclose(out);
+	return 0;
+}
@@ -0,0 +1,107 @@
+/** @file eventlogtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libeventlog/libeventlog.h"
+#include "libsimulator/libsimulator.h"
+
+#define EVENTS 1000
+
+int main()
+{
+	int failures = 0;
+	int i, cores;
+
+	/* A batch smaller than the log: the events reach the file in several writes. */
+	FILE *file = tmpfile();
+	eventlog_t *log = eventlog_open(file, 4, 64);
+
+	for (i = 0; i < EVENTS; i++)
+		eventlog_write(log, i % (EVENT_FINISH + 1), i / 2, i, i % 4);
+	printf("Events logged: %lld (expected %d).\n", eventlog_count(log), EVENTS);
+	if (eventlog_count(log) != EVENTS || eventlog_close(log) != 0)
+		failures++;
+
+	rewind(file);
+	eventlog_event_t events[EVENTS + 1];
+	int header = eventlog_read_header(file, &cores);
+	int read = eventlog_read(file, events, EVENTS + 1);
+	int same = 1;
+	for (i = 0; i < read; i++)
+		if (events[i].time != i / 2 || events[i].type != i % (EVENT_FINISH + 1) || events[i].job != i || events[i].core != i % 4)
+			same = 0;
+	printf("Events read back: %d on %d core(s), all as written: %s (expected %d on 4 core(s), yes).\n", read, cores, same ? "yes" : "no", EVENTS);
+	if (header != 0 || cores != 4 || read != EVENTS || !same)
+		failures++;
+	fclose(file);
+
+	/* Anything else is not an event log. */
+	file = tmpfile();
+	fprintf(file, "arrival,run,priority\n");
+	rewind(file);
+	printf("Reading a workload as an event log: %d (expected -1).\n", eventlog_read_header(file, &cores));
+	rewind(file);
+	if (eventlog_read_header(file, &cores) != -1)
+		failures++;
+	fclose(file);
+
+	/* A simulation logs every arrival and finish, and a dispatch for each job. */
+	simulator_job_t jobs[] = {
+		{ 0, 4, 1, 0, 0, 1, NULL },
+		{ 1, 3, 2, 0, 0, 1, NULL },
+		{ 2, 6, 0, 0, 0, 1, NULL },
+		{ 2, 2, 3, 0, 0, 1, NULL },
+		{ 5, 1, 1, 0, 0, 1, NULL },
+	};
+	int jobs_ct = sizeof(jobs) / sizeof(jobs[0]);
+	scheme_t scheme;
+	scheduler_options_t options;
+
+	simulator_parse_scheme("rr2", &scheme, &options);
+	file = tmpfile();
+	log = eventlog_open(file, 2, 4);
+
+	simulator_t *sim = simulator_create(2, scheme, &options);
+	simulator_set_eventlog(sim, log);
+	for (i = 0; i < jobs_ct; i++)
+		simulator_add_job(sim, &jobs[i]);
+	int status = simulator_run(sim);
+	simulator_destroy(sim);
+	eventlog_close(log);
+
+	int arrived[5] = { 0 }, dispatched[5] = { 0 }, finished[5] = { 0 }, expired = 0, ordered = 1, last = 0;
+	rewind(file);
+	eventlog_read_header(file, &cores);
+	read = eventlog_read(file, events, EVENTS);
+	for (i = 0; i < read; i++)
+	{
+		if (events[i].time < last)
+			ordered = 0;
+		last = events[i].time;
+
+		if (events[i].type == EVENT_ARRIVE)
+			arrived[events[i].job]++;
+		else if (events[i].type == EVENT_DISPATCH)
+			dispatched[events[i].job]++;
+		else if (events[i].type == EVENT_FINISH)
+			finished[events[i].job]++;
+		else if (events[i].type == EVENT_QUANTUM_EXPIRE)
+			expired++;
+	}
+
+	int complete = 1;
+	for (i = 0; i < jobs_ct; i++)
+		if (arrived[i] != 1 || finished[i] != 1 || dispatched[i] < 1)
+			complete = 0;
+	printf("Every job arrived, was dispatched and finished once: %s, in time order: %s (expected yes, yes).\n",
+			complete ? "yes" : "no", ordered ? "yes" : "no");
+	printf("Quantum expiries logged: %s (expected some).\n", expired > 0 ? "some" : "none");
+	if (status != 0 || !complete || !ordered || expired == 0)
+		failures++;
+	fclose(file);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
@@ -0,0 +1,198 @@
+/** @file executorbench.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <time.h>
+
+#include "libexecutor/libexecutor.h"
+#include "libsimulator/libsimulator.h"
+
+
+/**
+  CPU-bound work standing in for a job: spinning for its running time.
+*/
+typedef struct _spin_t
+{
+	long long remaining;
+	long long piece;
+} spin_t;
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> [-u <unit>] <input file>\n", program_name);
+	fprintf(stderr, "       %s -c 2 -s rr2 -u 2000 examples/proc1.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Runs every job of the workload as real CPU-bound work on one thread per core,\n");
+	fprintf(stderr, "submitted when it arrives, and compares the latencies measured with those the\n");
+	fprintf(stderr, "scheduler saw and those the simulator predicts for the same workload.\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -u  microseconds per time unit (default 1000)\n");
+}
+
+
+static long long thread_cpu_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/*
+ * Spins for a piece of the job, a quarter of a time unit, and yields.
+ */
+static int spin(void *arg)
+{
+	spin_t *work = arg;
+	long long piece = (work->remaining < work->piece ? work->remaining : work->piece);
+	long long end = thread_cpu_ns() + piece;
+
+	while (thread_cpu_ns() < end)
+		;
+
+	work->remaining -= piece;
+	return work->remaining > 0;
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	int cores = 0, unit = 1000;
+	int scheme = -1;
+	scheme_t parsed_scheme;
+	scheduler_options_t options;
+
+	while ((c = getopt(argc, argv, "c:s:u:")) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				cores = atoi(optarg);
+
+				if (cores <= 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 's':
+				if (simulator_parse_scheme(optarg, &parsed_scheme, &options) != 0)
+				{
+					fprintf(stderr, "Option -s <scheme> requires a scheme the simulator accepts.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				scheme = parsed_scheme;
+				break;
+
+			case 'u':
+				unit = atoi(optarg);
+
+				if (unit <= 0)
+				{
+					fprintf(stderr, "Option -u <unit> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (cores == 0 || scheme == -1 || optind != argc - 1)
+	{
+		fprintf(stderr, "Options -c <cores> and -s <scheme> and a single input file are required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	FILE *file = fopen(argv[optind], "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", argv[optind]);
+		return 2;
+	}
+
+	int jobs_ct;
+	simulator_job_t *jobs = simulator_read_jobs(file, &jobs_ct);
+	fclose(file);
+
+	if (jobs == NULL)
+	{
+		fprintf(stderr, (jobs_ct == -1 ? "Illegal file format.\n" : "Out of memory.\n"));
+		return 2;
+	}
+
+	for (int i = 0; i < jobs_ct; i++)
+	{
+		if (jobs[i].burst_ct > 1)
+		{
+			fprintf(stderr, "Job %d does I/O, which the executor does not model.\n", i);
+			return 2;
+		}
+	}
+
+
+	/*
+	 * Run the jobs for real, each submitted once its arrival time has come
+	 * with its running time as the estimated cost.
+	 */
+	spin_t *work = malloc(jobs_ct * sizeof(spin_t));
+	executor_t *ex = executor_create(cores, scheme, &options, unit);
+
+	if (ex == NULL)
+	{
+		fprintf(stderr, "Unable to start the workers.\n");
+		return 2;
+	}
+
+	for (int i = 0; i < jobs_ct; i++)
+	{
+		int now;
+
+		while ((now = executor_now(ex)) < jobs[i].arrival_time)
+			usleep((jobs[i].arrival_time - now) * unit);
+
+		work[i].remaining = jobs[i].run_time * unit * 1000LL;
+		work[i].piece = unit * 250LL;
+		executor_submit(ex, spin, &work[i], jobs[i].priority, jobs[i].run_time);
+	}
+	executor_wait(ex);
+
+
+	/*
+	 * Simulate the same workload.
+	 */
+	simulator_t *sim = simulator_create(cores, scheme, &options);
+	for (int i = 0; i < jobs_ct; i++)
+		simulator_add_job(sim, &jobs[i]);
+	int status = simulator_run(sim);
+
+	scheduler_t *seen = executor_scheduler(ex);
+	scheduler_t *simulated = simulator_scheduler(sim);
+
+	printf("Ran %d job(s) on %d worker(s) using %s, %d us per time unit.\n\n", jobs_ct, cores, simulator_scheme_name(scheme), unit);
+	printf("                          Measured  Scheduler  Simulated\n");
+	printf("Average Waiting Time:     %8.2f   %8.2f   %8.2f\n", executor_average_waiting_time(ex),
+			scheduler_average_waiting_time_r(seen), scheduler_average_waiting_time_r(simulated));
+	printf("Average Turnaround Time:  %8.2f   %8.2f   %8.2f\n", executor_average_turnaround_time(ex),
+			scheduler_average_turnaround_time_r(seen), scheduler_average_turnaround_time_r(simulated));
+	printf("Average Response Time:    %8.2f   %8.2f   %8.2f\n", executor_average_response_time(ex),
+			scheduler_average_response_time_r(seen), scheduler_average_response_time_r(simulated));
+
+	simulator_destroy(sim);
+	executor_destroy(ex);
+	free(work);
+	simulator_free_jobs(jobs, jobs_ct);
+
+	return status;
+}
@@ -0,0 +1,150 @@
+/** @file executortest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <stdatomic.h>
+
+#include "libexecutor/libexecutor.h"
+
+#define TASKS 8
+
+
+typedef struct _task_t
+{
+	int id;
+	int pieces;
+	long long piece_ns;
+	atomic_int *hold;
+	atomic_int *order;
+	int finished_at;
+	int started_at;
+} task_t;
+
+atomic_int sequence;
+
+
+static long long clock_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+/*
+ * Spins for a piece of work at a time. A task with a hold flag keeps
+ * yielding without finishing until the flag is cleared.
+ */
+int work(void *arg)
+{
+	task_t *t = arg;
+	long long end = clock_ns() + t->piece_ns;
+
+	if (t->started_at < 0)
+		t->started_at = atomic_fetch_add(&sequence, 1);
+	while (clock_ns() < end)
+		;
+
+	if (t->hold != NULL && atomic_load(t->hold))
+		return 1;
+	if (--t->pieces > 0)
+		return 1;
+
+	t->finished_at = atomic_fetch_add(&sequence, 1);
+	return 0;
+}
+
+void init(task_t *t, int id, int pieces, atomic_int *hold)
+{
+	t->id = id;
+	t->pieces = pieces;
+	t->piece_ns = 100000;
+	t->hold = hold;
+	t->started_at = -1;
+	t->finished_at = -1;
+}
+
+int main()
+{
+	scheduler_options_t options;
+	task_t tasks[TASKS];
+	atomic_int hold;
+	int failures = 0;
+	int i;
+
+	/*
+	 * One core, priorities: the first task holds the core until every other
+	 * one is queued, and they then run by priority.
+	 */
+	scheduler_options_init(&options);
+	executor_t *ex = executor_create(1, PRI, &options, 1000);
+
+	atomic_init(&hold, 1);
+	atomic_init(&sequence, 0);
+	init(&tasks[0], 0, 1, &hold);
+	executor_submit(ex, work, &tasks[0], 0, 1);
+	for (i = 1; i < TASKS; i++)
+	{
+		init(&tasks[i], i, 2, NULL);
+		executor_submit(ex, work, &tasks[i], TASKS - i, 1);
+	}
+	atomic_store(&hold, 0);
+	executor_wait(ex);
+
+	int ordered = 1;
+	for (i = 2; i < TASKS; i++)
+		if (tasks[i].finished_at > tasks[i - 1].finished_at)
+			ordered = 0;
+	printf("Tasks finished: %d, by priority: %s (expected %d yes).\n", executor_tasks(ex), ordered ? "yes" : "no", TASKS);
+	if (!ordered || executor_tasks(ex) != TASKS)
+		failures++;
+
+	int valid = (executor_average_turnaround_time(ex) >= executor_average_waiting_time(ex) && executor_average_waiting_time(ex) >= 0);
+	printf("Measured turnaround covers waiting: %s (expected yes).\n", valid ? "yes" : "no");
+	if (!valid)
+		failures++;
+	executor_destroy(ex);
+
+	/*
+	 * One core, round robin with a quantum of one unit: two long tasks take
+	 * turns, so the second starts long before the first finishes.
+	 */
+	options.quantum = 1;
+	ex = executor_create(1, RR, &options, 1000);
+	atomic_init(&sequence, 0);
+	init(&tasks[0], 0, 40, NULL);
+	init(&tasks[1], 1, 40, NULL);
+	executor_submit(ex, work, &tasks[0], 0, 4);
+	executor_submit(ex, work, &tasks[1], 0, 4);
+	executor_wait(ex);
+
+	int shared = (tasks[1].started_at < tasks[0].finished_at);
+	printf("Round robin interleaves long tasks: %s (expected yes).\n", shared ? "yes" : "no");
+	if (!shared)
+		failures++;
+	executor_destroy(ex);
+
+	/* Several cores, many tasks: every one of them finishes. */
+	ex = executor_create(4, PSJF, &options, 1000);
+	task_t *many = malloc(200 * sizeof(task_t));
+	for (i = 0; i < 200; i++)
+	{
+		init(&many[i], i, 1 + i % 5, NULL);
+		many[i].piece_ns = 20000;
+		executor_submit(ex, work, &many[i], 0, 1 + i % 5);
+	}
+	executor_wait(ex);
+
+	int done = 0;
+	for (i = 0; i < 200; i++)
+		done += (many[i].finished_at >= 0);
+	printf("Tasks finished on 4 cores: %d (expected 200).\n", done);
+	if (done != 200)
+		failures++;
+	executor_destroy(ex);
+	free(many);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
@@ -0,0 +1,235 @@
+/** @file gangtest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "libgang/libgang.h"
+
+#define JOBS 300
+#define LARGE_JOBS 20000
+
+
+/*
+ * Counts the jobs that started before they arrived, and the times some
+ * job started at with more cores busy than there are.
+ */
+int check_capacity(const simulator_job_t *jobs, int count, int cores, const int *starts)
+{
+	int errors = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		int busy = 0;
+
+		if (starts[i] < jobs[i].arrival_time)
+			errors++;
+		for (int j = 0; j < count; j++)
+			if (starts[j] <= starts[i] && starts[i] < starts[j] + jobs[j].run_time)
+				busy += (jobs[j].cores > 1 ? jobs[j].cores : 1);
+		if (busy > cores)
+			errors++;
+	}
+	return errors;
+}
+
+/*
+ * Counts the jobs that started after the reservation EASY gives the head
+ * of the queue, for jobs given in order of arrival. A job becomes the head
+ * once every job before it has started, and is reserved the earliest time
+ * enough cores are free, going by the jobs running then, including those
+ * before it that started at that very time. As running times are exact,
+ * nothing backfilled may push its start past that.
+ */
+int check_reservations(const simulator_job_t *jobs, int count, int cores, const int *starts)
+{
+	int errors = 0;
+	int head_time = 0;
+
+	for (int j = 0; j < count; j++)
+	{
+		if (jobs[j].arrival_time > head_time)
+			head_time = jobs[j].arrival_time;
+
+		// Walk the cores freed as the running jobs end, in order of time.
+		int free = cores, shadow = head_time;
+		for (int i = 0; i < count; i++)
+			if (i != j && (starts[i] < head_time || (i < j && starts[i] == head_time)) && starts[i] + jobs[i].run_time > head_time)
+				free -= jobs[i].cores;
+		while (free < jobs[j].cores)
+		{
+			int next = -1;
+			for (int i = 0; i < count; i++)
+			{
+				int end = starts[i] + jobs[i].run_time;
+				if (end > shadow && (next == -1 || end < next)
+						&& (starts[i] < head_time || (i < j && starts[i] == head_time)))
+					next = end;
+			}
+			if (next == -1)
+				break;
+			shadow = next;
+			for (int i = 0; i < count; i++)
+				if (starts[i] + jobs[i].run_time == shadow && (starts[i] < head_time || (i < j && starts[i] == head_time)))
+					free += jobs[i].cores;
+		}
+
+		if (starts[j] > shadow)
+			errors++;
+		if (starts[j] > head_time)
+			head_time = starts[j];
+	}
+	return errors;
+}
+
+int main()
+{
+	simulator_job_t *jobs = calloc(LARGE_JOBS, sizeof(simulator_job_t));
+	int *starts = malloc(LARGE_JOBS * sizeof(int));
+	gang_result_t fcfs, easy;
+	gang_policy_t policy;
+	int failures = 0;
+	int i;
+
+	/* Policies are parsed by name. */
+	int parsed = (gang_parse_policy("EASY", &policy) == 0 && policy == GANG_EASY);
+	printf("Policy EASY parsed: %s, conservative rejected: %s (expected yes yes).\n",
+			parsed ? "yes" : "no", gang_parse_policy("conservative", &policy) != 0 ? "yes" : "no");
+	if (!parsed || gang_parse_policy("conservative", &policy) == 0)
+		failures++;
+
+	/*
+	 * The jobs of examples/proc7.csv on 4 cores. Job 1 needs every core and
+	 * waits for job 0 until time 10. Under EASY, job 2 fits in the hole and
+	 * ends by then, as does job 4; job 3 would delay job 1, so it waits.
+	 */
+	simulator_job_t example[] = {
+		{ 0, 10, 1, 0, 0, 1, NULL, 2 }, { 1, 5, 1, 0, 0, 1, NULL, 4 }, { 2, 3, 1, 0, 0, 1, NULL, 2 },
+		{ 2, 20, 1, 0, 0, 1, NULL, 1 }, { 6, 4, 1, 0, 0, 1, NULL, 1 }
+	};
+	int fcfs_starts[] = { 0, 10, 15, 15, 15 }, easy_starts[] = { 0, 10, 2, 15, 6 };
+
+	gang_simulate(example, 5, 4, GANG_FCFS, NULL, starts, &fcfs);
+	int same = (memcmp(starts, fcfs_starts, sizeof(fcfs_starts)) == 0);
+	printf("FCFS starts %d %d %d %d %d, waiting %.2f, backfilled %d (expected 0 10 15 15 15, 8.80, 0).\n",
+			starts[0], starts[1], starts[2], starts[3], starts[4], fcfs.average_waiting_time, fcfs.backfilled);
+	if (!same || fabs(fcfs.average_waiting_time - 8.8) > 0.001 || fcfs.backfilled != 0)
+		failures++;
+
+	gang_simulate(example, 5, 4, GANG_EASY, NULL, starts, &easy);
+	same = (memcmp(starts, easy_starts, sizeof(easy_starts)) == 0);
+	printf("EASY starts %d %d %d %d %d, waiting %.2f, backfilled %d (expected 0 10 2 15 6, 4.40, 2).\n",
+			starts[0], starts[1], starts[2], starts[3], starts[4], easy.average_waiting_time, easy.backfilled);
+	if (!same || fabs(easy.average_waiting_time - 4.4) > 0.001 || easy.backfilled != 2)
+		failures++;
+
+	/*
+	 * 70 of the 140 core time units to time 35 are busy. While job 1 waits,
+	 * 2 cores are idle from 1 to 2 and from 5 to 6, and 1 from 6 to 10.
+	 */
+	printf("EASY makespan %d, utilization %.2f, fragmentation %.4f (expected 35, 0.50, 0.0571).\n",
+			easy.makespan, easy.utilization, easy.fragmentation);
+	if (easy.makespan != 35 || fabs(easy.utilization - 0.5) > 0.001 || fabs(easy.fragmentation - 8 / 140.0) > 0.0001)
+		failures++;
+
+	/* A job needing more cores than there are is refused. */
+	example[1].cores = 5;
+	printf("Job needing 5 of 4 cores refused: %s (expected yes).\n",
+			gang_simulate(example, 5, 4, GANG_EASY, NULL, NULL, &easy) != 0 ? "yes" : "no");
+	if (gang_simulate(example, 5, 4, GANG_EASY, NULL, NULL, &easy) == 0)
+		failures++;
+
+	/*
+	 * Populate jobs each needing one core, no two arriving together. Gang
+	 * FCFS is then the simulator's FCFS, and EASY has nothing to backfill,
+	 * as the head only waits while every core is busy.
+	 */
+	srand(50);
+	for (i = 0; i < JOBS; i++)
+	{
+		jobs[i].arrival_time = (i > 0 ? jobs[i - 1].arrival_time : 0) + 1 + rand() % 4;
+		jobs[i].run_time = 1 + rand() % 12;
+		jobs[i].priority = rand() % 5;
+		jobs[i].burst_ct = 1;
+		jobs[i].cores = 1;
+	}
+
+	scheme_t scheme;
+	scheduler_options_t options;
+	simulator_parse_scheme("fcfs", &scheme, &options);
+	simulator_t *sim = simulator_create(3, scheme, &options);
+	for (i = 0; i < JOBS; i++)
+		simulator_add_job(sim, &jobs[i]);
+	simulator_run(sim);
+	float waiting = scheduler_average_waiting_time_r(simulator_scheduler(sim));
+	float turnaround = scheduler_average_turnaround_time_r(simulator_scheduler(sim));
+	simulator_destroy(sim);
+
+	gang_simulate(jobs, JOBS, 3, GANG_FCFS, NULL, NULL, &fcfs);
+	gang_simulate(jobs, JOBS, 3, GANG_EASY, NULL, NULL, &easy);
+	printf("Single-core jobs: fcfs %.2f/%.2f, gang fcfs %.2f/%.2f, easy %.2f/%.2f, backfilled %d (expected the same, 0).\n",
+			waiting, turnaround, fcfs.average_waiting_time, fcfs.average_turnaround_time,
+			easy.average_waiting_time, easy.average_turnaround_time, easy.backfilled);
+	if (fabs(fcfs.average_waiting_time - waiting) > 0.01 || fabs(fcfs.average_turnaround_time - turnaround) > 0.01
+			|| memcmp(&fcfs, &easy, sizeof(gang_result_t)) != 0)
+		failures++;
+
+	/*
+	 * Jobs of 1 to 8 cores on 8, some arriving together. No core runs two
+	 * jobs at once under either policy, and FCFS starts jobs in order.
+	 */
+	for (i = 0; i < JOBS; i++)
+	{
+		jobs[i].arrival_time = (i > 0 ? jobs[i - 1].arrival_time : 0) + rand() % 6;
+		jobs[i].run_time = 1 + rand() % 30;
+		jobs[i].cores = 1 + rand() % 8;
+	}
+
+	gang_simulate(jobs, JOBS, 8, GANG_FCFS, NULL, starts, &fcfs);
+	int errors = check_capacity(jobs, JOBS, 8, starts);
+	for (i = 1; i < JOBS; i++)
+		if (starts[i] < starts[i - 1])
+			errors++;
+	gang_simulate(jobs, JOBS, 8, GANG_EASY, NULL, starts, &easy);
+	errors += check_capacity(jobs, JOBS, 8, starts);
+	printf("Overcommitted or out-of-order starts: %d, EASY backfilled some: %s (expected 0 yes).\n",
+			errors, easy.backfilled > 0 ? "yes" : "no");
+	if (errors != 0 || easy.backfilled == 0)
+		failures++;
+
+	errors = check_reservations(jobs, JOBS, 8, starts);
+	printf("Heads of the queue started after their reservation under EASY: %d (expected 0).\n", errors);
+	if (errors != 0)
+		failures++;
+
+	printf("Utilization fcfs %.2f, easy %.2f; fragmentation fcfs %.2f, easy %.2f (expected easy higher, then lower).\n",
+			fcfs.utilization, easy.utilization, fcfs.fragmentation, easy.fragmentation);
+	if (easy.utilization <= fcfs.utilization || easy.fragmentation >= fcfs.fragmentation
+			|| fcfs.utilization + fcfs.fragmentation > 1 || easy.utilization + easy.fragmentation > 1)
+		failures++;
+
+	/* Thousands of jobs queue up on an overloaded machine, and every one still runs. */
+	for (i = 0; i < LARGE_JOBS; i++)
+	{
+		jobs[i].arrival_time = i / 4;
+		jobs[i].run_time = 1 + rand() % 40;
+		jobs[i].cores = 1 + rand() % 64;
+	}
+	int status = gang_simulate(jobs, LARGE_JOBS, 64, GANG_EASY, NULL, starts, &easy);
+	errors = 0;
+	for (i = 0; i < LARGE_JOBS; i++)
+		if (starts[i] < jobs[i].arrival_time)
+			errors++;
+	printf("Large run: %d job(s), most waiting %s 1000, early starts %d (expected %d, over, 0).\n",
+			easy.jobs, easy.max_queue > 1000 ? "over" : "under", errors, LARGE_JOBS);
+	if (status != 0 || easy.jobs != LARGE_JOBS || easy.max_queue <= 1000 || errors != 0)
+		failures++;
+
+	free(jobs);
+	free(starts);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
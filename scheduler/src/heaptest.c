@@ -0,0 +1,94 @@
+/** @file heaptest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "libheap/libheap.h"
+
+int compare1(const void * a, const void * b)
+{
+	return ( *(int*)a - *(int*)b );
+}
+
+/*
+ * Returns 1 if every element of the heap is no smaller than its parent.
+ */
+int check(heap_t *h)
+{
+	int i;
+	for (i = 1; i < heap_size(h); i++)
+		if (h->comparer(heap_at(h, (i - 1) / 2), heap_at(h, i)) > 0)
+			return 0;
+	return 1;
+}
+
+int main()
+{
+	heap_t h;
+	int failures = 0;
+
+	heap_init(&h, compare1);
+
+	/* Pupulate some data... */
+	int n = 100000;
+	int *values = malloc(n * sizeof(int));
+
+	int i;
+	srand(678);
+	for (i = 0; i < n; i++)
+		values[i] = rand() % (n / 4);
+
+	for (i = 0; i < n; i++)
+		heap_offer(&h, &values[i]);
+	printf("Total elements: %d (expected %d).\n", heap_size(&h), n);
+	if (heap_size(&h) != n)
+		failures++;
+
+	int valid = check(&h);
+	printf("Heap is ordered: %s (expected yes).\n", valid ? "yes" : "no");
+	if (!valid)
+		failures++;
+
+	/* Poll half, interleaving offers, then make sure the rest come out in order. */
+	for (i = 0; i < n / 2; i++)
+	{
+		heap_poll(&h);
+		if (i % 4 == 0)
+			heap_offer(&h, &values[i]);
+	}
+	valid = check(&h);
+	printf("Heap is ordered: %s (expected yes).\n", valid ? "yes" : "no");
+	if (!valid)
+		failures++;
+
+	int last = -1, sorted = 1, polled = 0, expected = heap_size(&h);
+	while (heap_size(&h) > 0)
+	{
+		int min = *(int *)heap_peek(&h);
+		int val = *(int *)heap_poll(&h);
+
+		if (val != min || val < last)
+			sorted = 0;
+		last = val;
+		polled++;
+	}
+	printf("Elements polled in order: %d %s (expected %d yes).\n", polled, sorted ? "yes" : "no", expected);
+	if (!sorted || polled != expected)
+		failures++;
+
+	printf("Smallest element of an empty heap: %s (expected NULL).\n", heap_peek(&h) == NULL ? "NULL" : "not NULL");
+	if (heap_peek(&h) != NULL || heap_poll(&h) != NULL)
+		failures++;
+
+	for (i = 0; i < n; i++)
+		heap_offer(&h, &values[i]);
+	heap_destroy(&h);
+	printf("Total elements after destroy: %d (expected 0).\n", heap_size(&h));
+	if (heap_size(&h) != 0)
+		failures++;
+
+	free(values);
+
+	return (failures == 0 ? 0 : 1);
+}
@@ -0,0 +1,629 @@
+/** @file libcluster.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+#include <strings.h>
+#include <pthread.h>
+
+#include "libcluster.h"
+
+
+typedef struct _cluster_node_t
+{
+	simulator_t *sim;
+	scheme_t scheme;
+	int cores;
+	int jobs;
+	int failed;
+} cluster_node_t;
+
+typedef struct _cluster_order_t
+{
+	int key, job;
+} cluster_order_t;
+
+/**
+  Stores the complete state of a cluster.
+*/
+struct _cluster_t
+{
+	dispatch_t dispatch;
+	uint64_t rng;
+	int next_rr;
+
+	cluster_node_t *nodes;
+	int nodes_ct;
+	int nodes_size;
+
+	simulator_job_t *jobs;
+	int *job_node;
+	int jobs_ct;
+	int jobs_size;
+
+	/*
+	 * Lockstep: the dispatcher routes the jobs arriving in a window, then
+	 * every thread advances its share of the nodes to the end of the
+	 * window, and all wait for each other before the next one. The gate
+	 * is held while the threads are started, so that none waits on a
+	 * barrier before it is set up.
+	 */
+	int threads;
+	int window_end;
+	int done;
+	pthread_barrier_t start;
+	pthread_barrier_t end;
+	pthread_mutex_t gate;
+};
+
+typedef struct _cluster_worker_t
+{
+	cluster_t *cluster;
+	int index;
+} cluster_worker_t;
+
+
+/**
+  Parses a dispatcher name as given to the simulator's -D option: rr,
+  least, jsq, or p2 optionally followed by the seed of its random choices,
+  as in p2:7.
+
+  @param name the name of the dispatcher
+  @param dispatch receives the dispatcher
+  @param seed receives the seed, 1 unless given
+  @return 0 on success
+  @return -1 if the name is not a dispatcher
+ */
+int cluster_parse_dispatch(const char *name, dispatch_t *dispatch, unsigned int *seed)
+{
+	*seed = 1;
+
+	if (strcasecmp(name, "rr") == 0)
+		*dispatch = DISPATCH_RR;
+	else if (strcasecmp(name, "least") == 0)
+		*dispatch = DISPATCH_LEAST_LOADED;
+	else if (strcasecmp(name, "jsq") == 0)
+		*dispatch = DISPATCH_JSQ;
+	else if (strncasecmp(name, "p2", 2) == 0 && (name[2] == '\0' || name[2] == ':'))
+	{
+		*dispatch = DISPATCH_POWER_OF_TWO;
+		if (name[2] == ':')
+		{
+			char *end;
+			*seed = strtoul(name + 3, &end, 10);
+			if (end == name + 3 || *end != '\0')
+				return -1;
+		}
+	}
+	else
+		return -1;
+
+	return 0;
+}
+
+
+/**
+  Parses a node as given to the simulator's -N option: a scheme as taken by
+  simulator_parse_scheme(), then @ and the cores as taken by
+  simulator_parse_cores(), as in rr2@4 or psjf@2:2.0,2.
+
+  @param spec the node
+  @param cores receives the number of cores
+  @param speeds receives the speed of each core, which the caller must free,
+  or NULL if no speed was given
+  @param scheme receives the scheme
+  @param options receives the parameters of the scheme, on top of the defaults
+  @return 0 on success
+  @return -1 if the node is not valid
+ */
+int cluster_parse_node(const char *spec, int *cores, int **speeds, scheme_t *scheme, scheduler_options_t *options)
+{
+	const char *at = strchr(spec, '@');
+	char name[64];
+
+	if (at == NULL || at == spec || at - spec >= (long)sizeof(name))
+		return -1;
+
+	memcpy(name, spec, at - spec);
+	name[at - spec] = '\0';
+
+	if (simulator_parse_scheme(name, scheme, options) != 0)
+		return -1;
+	return simulator_parse_cores(at + 1, cores, speeds);
+}
+
+
+/**
+  Returns the descriptive name of a dispatcher.
+
+  @param dispatch the dispatcher
+ */
+const char *cluster_dispatch_name(dispatch_t dispatch)
+{
+	switch (dispatch)
+	{
+		case DISPATCH_RR: return "round robin";
+		case DISPATCH_LEAST_LOADED: return "least loaded";
+		case DISPATCH_POWER_OF_TWO: return "power of two choices";
+		case DISPATCH_JSQ: return "join the shortest queue";
+	}
+	return "";
+}
+
+
+/**
+  Creates a cluster with no nodes and no jobs.
+
+  @param dispatch how arriving jobs are routed to the nodes
+  @param seed the seed of the random choices of DISPATCH_POWER_OF_TWO
+  @return the new cluster
+ */
+cluster_t *cluster_create(dispatch_t dispatch, unsigned int seed)
+{
+	cluster_t *c = calloc(1, sizeof(cluster_t));
+
+	c->dispatch = dispatch;
+	c->rng = seed;
+	c->threads = 1;
+
+	return c;
+}
+
+
+/**
+  Adds a node to the cluster. Nodes are numbered in the order they are
+  added, starting at 0.
+
+  @param c the cluster
+  @param cores the number of cores of the node
+  @param scheme the scheduling scheme of the node
+  @param options parameters of the scheme, or NULL for the defaults
+  @return the node number
+  @return -1 if memory ran out or the node could not be created
+ */
+int cluster_add_node(cluster_t *c, int cores, scheme_t scheme, const scheduler_options_t *options)
+{
+	if (c->nodes_ct == c->nodes_size)
+	{
+		int size = (c->nodes_size > 0 ? 2 * c->nodes_size : 4);
+		cluster_node_t *grown = realloc(c->nodes, size * sizeof(cluster_node_t));
+
+		if (grown == NULL)
+			return -1;
+		c->nodes = grown;
+		c->nodes_size = size;
+	}
+
+	cluster_node_t *node = &c->nodes[c->nodes_ct];
+	node->sim = simulator_create(cores, scheme, options);
+	if (node->sim == NULL)
+		return -1;
+	node->scheme = scheme;
+	node->cores = cores;
+	node->jobs = 0;
+	node->failed = 0;
+
+	return c->nodes_ct++;
+}
+
+
+/**
+  Adds a job to the cluster. The dispatcher only routes it to a node when
+  it arrives. Jobs are numbered in the order they are added, starting at 0.
+
+  @param c the cluster
+  @param job the job to add
+  @return the job number
+  @return -1 if memory ran out
+ */
+int cluster_add_job(cluster_t *c, const simulator_job_t *job)
+{
+	if (c->jobs_ct == c->jobs_size)
+	{
+		int size = (c->jobs_size > 0 ? 2 * c->jobs_size : 64);
+		simulator_job_t *grown = realloc(c->jobs, size * sizeof(simulator_job_t));
+
+		if (grown == NULL)
+			return -1;
+		c->jobs = grown;
+
+		int *grown_node = realloc(c->job_node, size * sizeof(int));
+
+		if (grown_node == NULL)
+			return -1;
+		c->job_node = grown_node;
+		c->jobs_size = size;
+	}
+
+	simulator_job_t *copy = &c->jobs[c->jobs_ct];
+	*copy = *job;
+	copy->bursts = NULL;
+	if (job->burst_ct > 1 && job->bursts != NULL)
+	{
+		copy->bursts = malloc(job->burst_ct * sizeof(int));
+		if (copy->bursts == NULL)
+			return -1;
+		memcpy(copy->bursts, job->bursts, job->burst_ct * sizeof(int));
+	}
+	else
+		copy->burst_ct = 1;
+	c->job_node[c->jobs_ct] = -1;
+
+	return c->jobs_ct++;
+}
+
+
+static uint64_t next_random(cluster_t *c)
+{
+	uint64_t z = (c->rng += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	return z ^ (z >> 31);
+}
+
+
+/*
+ * Whether node a has fewer jobs left per core than node b.
+ */
+static int fewer_jobs(cluster_t *c, int a, int b)
+{
+	return (long long)simulator_active_jobs(c->nodes[a].sim) * c->nodes[b].cores
+		< (long long)simulator_active_jobs(c->nodes[b].sim) * c->nodes[a].cores;
+}
+
+
+/*
+ * Whether node a has less work left per core than node b.
+ */
+static int less_work(cluster_t *c, int a, int b)
+{
+	return simulator_backlog(c->nodes[a].sim) * c->nodes[b].cores
+		< simulator_backlog(c->nodes[b].sim) * c->nodes[a].cores;
+}
+
+
+/*
+ * Picks the node the next arriving job goes to. Round robin ignores the
+ * nodes' state; least loaded takes the node with the least work left per
+ * core, and join the shortest queue the one with the fewest jobs left per
+ * core, the lowest node among equals. Power of two choices compares the
+ * jobs of two distinct nodes drawn at random, so it only looks at two
+ * nodes however many there are.
+ */
+static int pick_node(cluster_t *c)
+{
+	int best = 0;
+
+	switch (c->dispatch)
+	{
+		case DISPATCH_RR:
+			best = c->next_rr;
+			c->next_rr = (c->next_rr + 1) % c->nodes_ct;
+			break;
+
+		case DISPATCH_LEAST_LOADED:
+			for (int n = 1; n < c->nodes_ct; n++)
+				if (less_work(c, n, best))
+					best = n;
+			break;
+
+		case DISPATCH_JSQ:
+			for (int n = 1; n < c->nodes_ct; n++)
+				if (fewer_jobs(c, n, best))
+					best = n;
+			break;
+
+		case DISPATCH_POWER_OF_TWO:
+			if (c->nodes_ct > 1)
+			{
+				int a = next_random(c) % c->nodes_ct;
+				int b = next_random(c) % (c->nodes_ct - 1);
+
+				if (b >= a)
+					b++;
+				best = (fewer_jobs(c, b, a) ? b : a);
+			}
+			break;
+	}
+
+	return best;
+}
+
+
+static int compare_order(const void *a, const void *b)
+{
+	const cluster_order_t *order_a = a;
+	const cluster_order_t *order_b = b;
+
+	if (order_a->key != order_b->key)
+		return (order_a->key < order_b->key ? -1 : 1);
+	return order_a->job - order_b->job;
+}
+
+
+/*
+ * Advances every node that falls to a thread to the end of the window.
+ */
+static void step_nodes(cluster_t *c, int index)
+{
+	for (int n = index; n < c->nodes_ct; n += c->threads)
+		if (simulator_run_until(c->nodes[n].sim, c->window_end) < 0)
+			c->nodes[n].failed = 1;
+}
+
+
+static void *worker(void *arg)
+{
+	cluster_worker_t *w = arg;
+	cluster_t *c = w->cluster;
+
+	pthread_mutex_lock(&c->gate);
+	pthread_mutex_unlock(&c->gate);
+
+	for (;;)
+	{
+		pthread_barrier_wait(&c->start);
+		if (c->done)
+			break;
+		step_nodes(c, w->index);
+		pthread_barrier_wait(&c->end);
+	}
+
+	return NULL;
+}
+
+
+/**
+  Runs the cluster until every job has finished. Time advances in windows:
+  at the start of each, the dispatcher routes the jobs arriving in it, in
+  order of arrival and then of number, to nodes as they stand, and then
+  every node is simulated to the end of the window. A window of 1 routes
+  every job with the nodes exactly as they are when it arrives; longer ones
+  model a dispatcher that learns the state of the nodes less often. Every
+  node is simulated by one thread, and the result does not depend on how
+  many threads there are.
+
+  @param c the cluster
+  @param threads the number of threads to simulate the nodes with
+  @param window the time units per window
+  @return 0 if every job finished
+  @return 2 if memory ran out
+  @return 3 if a scheduler made an invalid decision
+ */
+int cluster_run(cluster_t *c, int threads, int window)
+{
+	int status = 0;
+
+	if (c->nodes_ct == 0)
+		return (c->jobs_ct == 0 ? 0 : 3);
+
+	c->threads = (threads < 1 ? 1 : (threads > c->nodes_ct ? c->nodes_ct : threads));
+	if (window < 1)
+		window = 1;
+
+	cluster_order_t *order = malloc((c->jobs_ct + 1) * sizeof(cluster_order_t));
+	if (order == NULL)
+		return 2;
+	for (int i = 0; i < c->jobs_ct; i++)
+	{
+		order[i].key = c->jobs[i].arrival_time;
+		order[i].job = i;
+	}
+	qsort(order, c->jobs_ct, sizeof(cluster_order_t), compare_order);
+
+	/*
+	 * The barriers count the threads that did start: should one fail to,
+	 * the nodes are shared among those that did.
+	 */
+	c->done = 0;
+	pthread_mutex_init(&c->gate, NULL);
+	pthread_mutex_lock(&c->gate);
+
+	pthread_t workers[c->threads];
+	cluster_worker_t args[c->threads];
+	int started = 1;
+	while (started < c->threads)
+	{
+		args[started].cluster = c;
+		args[started].index = started;
+		if (pthread_create(&workers[started], NULL, worker, &args[started]) != 0)
+			break;
+		started++;
+	}
+	c->threads = started;
+
+	pthread_barrier_init(&c->start, NULL, c->threads);
+	pthread_barrier_init(&c->end, NULL, c->threads);
+	pthread_mutex_unlock(&c->gate);
+
+	int next = 0;
+	int time = (c->jobs_ct > 0 ? order[0].key : 0);
+
+	for (;;)
+	{
+		c->window_end = time + window;
+
+		while (status == 0 && next < c->jobs_ct && order[next].key < c->window_end)
+		{
+			int job = order[next++].job;
+			int node = pick_node(c);
+
+			if (simulator_add_job(c->nodes[node].sim, &c->jobs[job]) < 0)
+			{
+				status = 2;
+				break;
+			}
+			c->job_node[job] = node;
+			c->nodes[node].jobs++;
+		}
+
+		int active = 0;
+		for (int n = 0; n < c->nodes_ct; n++)
+		{
+			active += simulator_active_jobs(c->nodes[n].sim);
+			if (c->nodes[n].failed)
+				status = 3;
+		}
+
+		c->done = (status != 0 || (active == 0 && next == c->jobs_ct));
+		if (c->threads > 1)
+			pthread_barrier_wait(&c->start);
+		if (c->done)
+			break;
+
+		step_nodes(c, 0);
+		if (c->threads > 1)
+			pthread_barrier_wait(&c->end);
+
+		// With every node idle, go straight to the next arrival.
+		time = c->window_end;
+		if (active == 0 || next < c->jobs_ct)
+		{
+			int idle = 1;
+			for (int n = 0; n < c->nodes_ct && idle; n++)
+				idle = (simulator_active_jobs(c->nodes[n].sim) == 0);
+			if (idle && next < c->jobs_ct && order[next].key > time)
+				time = order[next].key;
+		}
+	}
+
+	for (int i = 1; i < c->threads; i++)
+		pthread_join(workers[i], NULL);
+	pthread_barrier_destroy(&c->start);
+	pthread_barrier_destroy(&c->end);
+	pthread_mutex_destroy(&c->gate);
+	free(order);
+
+	return status;
+}
+
+
+/**
+  Returns the number of nodes of the cluster.
+
+  @param c the cluster
+ */
+int cluster_nodes(cluster_t *c)
+{
+	return c->nodes_ct;
+}
+
+
+/**
+  Returns the simulation of a node, for example to read the averages of its
+  scheduler once the cluster has run.
+
+  @param c the cluster
+  @param node the node, from 0
+ */
+simulator_t *cluster_node(cluster_t *c, int node)
+{
+	return c->nodes[node].sim;
+}
+
+
+/**
+  Returns the number of jobs the dispatcher routed to a node.
+
+  @param c the cluster
+  @param node the node, from 0
+ */
+int cluster_node_jobs(cluster_t *c, int node)
+{
+	return c->nodes[node].jobs;
+}
+
+
+/**
+  Returns the node the dispatcher routed a job to.
+
+  @param c the cluster
+  @param job the job number
+  @return the node, from 0
+  @return -1 if the job has not arrived yet
+ */
+int cluster_job_node(cluster_t *c, int job)
+{
+	return c->job_node[job];
+}
+
+
+static void print_averages(FILE *out, float waiting, float turnaround, float response, int max_waiting, float utilization, int finish)
+{
+	fprintf(out, "  Average Waiting Time: %.2f\n", waiting);
+	fprintf(out, "  Average Turnaround Time: %.2f\n", turnaround);
+	fprintf(out, "  Average Response Time: %.2f\n", response);
+	fprintf(out, "  Maximum Waiting Time: %d\n", max_waiting);
+	fprintf(out, "  CPU Utilization: %.2f%%\n", 100 * utilization);
+	fprintf(out, "  Finish Time: %d\n", finish);
+}
+
+
+/**
+  Writes the statistics of every node and of the cluster as a whole. The
+  cluster's averages are over all of its jobs, and its utilization is the
+  share of all of its cores' time, from the first arrival to the last job
+  finishing, spent running jobs.
+
+  @param c the cluster
+  @param out the stream to write to
+ */
+void cluster_print_summary(cluster_t *c, FILE *out)
+{
+	double waiting = 0, turnaround = 0, response = 0;
+	long long busy = 0;
+	int cores = 0, jobs = 0, max_waiting = 0, finish = 0;
+
+	for (int n = 0; n < c->nodes_ct; n++)
+	{
+		cluster_node_t *node = &c->nodes[n];
+		scheduler_t *s = simulator_scheduler(node->sim);
+		int time = (node->jobs > 0 ? simulator_time(node->sim) : 0);
+
+		fprintf(out, "Node %d: %d core(s) using %s, %d job(s)\n", n, node->cores, simulator_scheme_name(node->scheme), node->jobs);
+		print_averages(out, scheduler_average_waiting_time_r(s), scheduler_average_turnaround_time_r(s), scheduler_average_response_time_r(s),
+				scheduler_max_waiting_time_r(s), scheduler_cpu_utilization_r(s), time);
+		fprintf(out, "\n");
+
+		waiting += (double)scheduler_average_waiting_time_r(s) * node->jobs;
+		turnaround += (double)scheduler_average_turnaround_time_r(s) * node->jobs;
+		response += (double)scheduler_average_response_time_r(s) * node->jobs;
+		if (scheduler_max_waiting_time_r(s) > max_waiting)
+			max_waiting = scheduler_max_waiting_time_r(s);
+		if (time > finish)
+			finish = time;
+		busy += scheduler_busy_time_r(s);
+		cores += node->cores;
+		jobs += node->jobs;
+	}
+
+	int first = -1;
+	for (int i = 0; i < c->jobs_ct; i++)
+		if (first == -1 || c->jobs[i].arrival_time < first)
+			first = c->jobs[i].arrival_time;
+	long long span = (long long)(finish - first) * cores;
+
+	fprintf(out, "Cluster: %d node(s), %d core(s), %d job(s) dispatched by %s\n", c->nodes_ct, cores, jobs, cluster_dispatch_name(c->dispatch));
+	print_averages(out, (jobs > 0 ? waiting / jobs : 0), (jobs > 0 ? turnaround / jobs : 0), (jobs > 0 ? response / jobs : 0),
+			max_waiting, (span > 0 ? busy / (float)span : 0), finish);
+}
+
+
+/**
+  Frees a cluster, its nodes and its jobs.
+
+  @param c the cluster
+ */
+void cluster_destroy(cluster_t *c)
+{
+	for (int n = 0; n < c->nodes_ct; n++)
+		simulator_destroy(c->nodes[n].sim);
+	for (int i = 0; i < c->jobs_ct; i++)
+		free(c->jobs[i].bursts);
+	free(c->nodes);
+	free(c->jobs);
+	free(c->job_node);
+	free(c);
+}
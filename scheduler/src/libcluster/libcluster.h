@@ -0,0 +1,38 @@
+/** @file libcluster.h
+ */
+
+#ifndef LIBCLUSTER_H_
+#define LIBCLUSTER_H_
+
+#include <stdio.h>
+
+#include "../libsimulator/libsimulator.h"
+
+/**
+  How the dispatcher picks the node an arriving job goes to
+*/
+typedef enum {DISPATCH_RR = 0, DISPATCH_LEAST_LOADED, DISPATCH_POWER_OF_TWO, DISPATCH_JSQ} dispatch_t;
+
+/**
+  A cluster of nodes, each a simulation with its own cores, scheme and
+  scheduler instance, behind a dispatcher that sends every arriving job to
+  one of them. Nodes share no state, so they are simulated in parallel.
+*/
+typedef struct _cluster_t cluster_t;
+
+int          cluster_parse_dispatch(const char *name, dispatch_t *dispatch, unsigned int *seed);
+int          cluster_parse_node    (const char *spec, int *cores, int **speeds, scheme_t *scheme, scheduler_options_t *options);
+const char  *cluster_dispatch_name (dispatch_t dispatch);
+
+cluster_t   *cluster_create        (dispatch_t dispatch, unsigned int seed);
+int          cluster_add_node      (cluster_t *c, int cores, scheme_t scheme, const scheduler_options_t *options);
+int          cluster_add_job       (cluster_t *c, const simulator_job_t *job);
+int          cluster_run           (cluster_t *c, int threads, int window);
+int          cluster_nodes         (cluster_t *c);
+simulator_t *cluster_node          (cluster_t *c, int node);
+int          cluster_node_jobs     (cluster_t *c, int node);
+int          cluster_job_node      (cluster_t *c, int job);
+void         cluster_print_summary (cluster_t *c, FILE *out);
+void         cluster_destroy       (cluster_t *c);
+
+#endif /* LIBCLUSTER_H_ */
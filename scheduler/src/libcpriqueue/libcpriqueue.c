@@ -0,0 +1,203 @@
+/** @file libcpriqueue.c
+ */
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "libcpriqueue.h"
+
+
+/*
+ * Every thread draws its shards from its own generator, so picking a shard
+ * never touches memory shared with other threads.
+ */
+static __thread uint64_t rng_state;
+
+static unsigned int next_random()
+{
+	if (rng_state == 0)
+		rng_state = (uintptr_t)&rng_state | 1;
+
+	rng_state ^= rng_state << 13;
+	rng_state ^= rng_state >> 7;
+	rng_state ^= rng_state << 17;
+	return rng_state >> 32;
+}
+
+
+/**
+  Initializes the cpriqueue_t data structure. Twice as many shards as
+  threads using the queue is a good balance: fewer and the threads contend
+  for the locks, more and polls stray further from the best element.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @param shards the number of shards, 1 for exact polls
+  @param comparer a function pointer that compares two elements, in the same
+  way as the comparer of a priqueue_t
+ */
+void cpriqueue_init(cpriqueue_t *q, int shards, int(*comparer)(const void *, const void *))
+{
+	if (shards < 1)
+		shards = 1;
+
+	q->m_shards = aligned_alloc(_Alignof(cpriqueue_shard_t), shards * sizeof(cpriqueue_shard_t));
+	q->m_shard_ct = shards;
+	atomic_init(&q->m_size, 0);
+	q->comparer = comparer;
+
+	for (int i = 0; i < shards; i++)
+	{
+		pthread_mutex_init(&q->m_shards[i].lock, NULL);
+		heap_init(&q->m_shards[i].heap, comparer);
+	}
+}
+
+
+/**
+  Inserts the specified element into a shard picked at random, moving on to
+  another whenever the one picked is locked.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @param ptr a pointer to the data to be inserted into the priority queue
+ */
+void cpriqueue_offer(cpriqueue_t *q, void *ptr)
+{
+	cpriqueue_shard_t *shard = &q->m_shards[next_random() % q->m_shard_ct];
+
+	for (int tries = 1; pthread_mutex_trylock(&shard->lock) != 0; tries++)
+	{
+		shard = &q->m_shards[next_random() % q->m_shard_ct];
+		if (tries == q->m_shard_ct)
+		{
+			pthread_mutex_lock(&shard->lock);
+			break;
+		}
+	}
+
+	heap_offer(&shard->heap, ptr);
+	pthread_mutex_unlock(&shard->lock);
+
+	atomic_fetch_add(&q->m_size, 1);
+}
+
+
+/*
+ * Polls the first shard that has anything, taking every lock in turn. Only
+ * reached when two random shards came up empty, which is rare unless the
+ * queue is nearly empty.
+ */
+static void *poll_any(cpriqueue_t *q)
+{
+	for (int i = 0; i < q->m_shard_ct; i++)
+	{
+		cpriqueue_shard_t *shard = &q->m_shards[i];
+
+		pthread_mutex_lock(&shard->lock);
+		void *ptr = heap_poll(&shard->heap);
+		pthread_mutex_unlock(&shard->lock);
+
+		if (ptr != NULL)
+			return ptr;
+	}
+
+	return NULL;
+}
+
+
+/**
+  Retrieves and removes an element at or near the head of this queue: the
+  better of the heads of two shards picked at random, both locked while
+  they are compared. With one shard this is always the head.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @return an element at or near the head of this queue
+  @return NULL if every shard was empty when it was looked at
+ */
+void *cpriqueue_poll(cpriqueue_t *q)
+{
+	void *ptr;
+
+	if (q->m_shard_ct == 1)
+	{
+		pthread_mutex_lock(&q->m_shards[0].lock);
+		ptr = heap_poll(&q->m_shards[0].heap);
+		pthread_mutex_unlock(&q->m_shards[0].lock);
+	}
+	else
+	{
+		for (;;)
+		{
+			if (atomic_load(&q->m_size) <= 0)
+				return NULL;
+
+			int i = next_random() % q->m_shard_ct;
+			int j = next_random() % (q->m_shard_ct - 1);
+			if (j >= i)
+				j++;
+
+			cpriqueue_shard_t *a = &q->m_shards[i];
+			cpriqueue_shard_t *b = &q->m_shards[j];
+
+			if (pthread_mutex_trylock(&a->lock) != 0)
+				continue;
+			if (pthread_mutex_trylock(&b->lock) != 0)
+			{
+				pthread_mutex_unlock(&a->lock);
+				continue;
+			}
+
+			void *head_a = heap_peek(&a->heap);
+			void *head_b = heap_peek(&b->heap);
+
+			if (head_a == NULL && head_b == NULL)
+				ptr = NULL;
+			else if (head_b == NULL || (head_a != NULL && q->comparer(head_a, head_b) <= 0))
+				ptr = heap_poll(&a->heap);
+			else
+				ptr = heap_poll(&b->heap);
+
+			pthread_mutex_unlock(&b->lock);
+			pthread_mutex_unlock(&a->lock);
+
+			if (ptr == NULL)
+				ptr = poll_any(q);
+			break;
+		}
+	}
+
+	if (ptr != NULL)
+		atomic_fetch_sub(&q->m_size, 1);
+	return ptr;
+}
+
+
+/**
+  Returns the number of elements in the queue. While other threads offer
+  and poll, this is only a snapshot.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+  @return the number of elements in the queue
+ */
+int cpriqueue_size(cpriqueue_t *q)
+{
+	int size = atomic_load(&q->m_size);
+
+	return (size > 0 ? size : 0);
+}
+
+
+/**
+  Destroys and frees all the memory associated with q. No other thread may
+  be using the queue.
+
+  @param q a pointer to an instance of the cpriqueue_t data structure
+ */
+void cpriqueue_destroy(cpriqueue_t *q)
+{
+	for (int i = 0; i < q->m_shard_ct; i++)
+	{
+		pthread_mutex_destroy(&q->m_shards[i].lock);
+		heap_destroy(&q->m_shards[i].heap);
+	}
+	free(q->m_shards);
+}
@@ -0,0 +1,48 @@
+/** @file libcpriqueue.h
+ */
+
+#ifndef LIBCPRIQUEUE_H_
+#define LIBCPRIQUEUE_H_
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "../libheap/libheap.h"
+
+/**
+  One shard of a cpriqueue_t: a binary heap behind its own lock, alone on
+  its cache lines so that threads working on different shards do not slow
+  each other down.
+*/
+typedef struct _cpriqueue_shard_t
+{
+  _Alignas(64) pthread_mutex_t lock;
+  heap_t heap;
+} cpriqueue_shard_t;
+
+/**
+  Concurrent priority queue, safe to offer to and poll from any number of
+  threads at once. It is a multiqueue: the elements are spread over several
+  shards, each a heap with its own lock. With one shard it is a heap behind
+  a single lock, and polls are exact. With more, polls are relaxed: each
+  takes the better head of two shards picked at random, which is usually
+  among the first few elements of the whole queue but need not be the
+  first.
+*/
+typedef struct _cpriqueue_t
+{
+  cpriqueue_shard_t *m_shards;
+  int m_shard_ct;
+  atomic_int m_size;
+  int (*comparer)(const void *a, const void *b);
+} cpriqueue_t;
+
+void   cpriqueue_init   (cpriqueue_t *q, int shards, int(*comparer)(const void *, const void *));
+
+void   cpriqueue_offer  (cpriqueue_t *q, void *ptr);
+void * cpriqueue_poll   (cpriqueue_t *q);
+int    cpriqueue_size   (cpriqueue_t *q);
+
+void   cpriqueue_destroy(cpriqueue_t *q);
+
+#endif /* LIBCPRIQUEUE_H_ */
@@ -0,0 +1,132 @@
+/** @file libdriver.c
+ */
+
+#include <stdlib.h>
+#include <limits.h>
+
+#include "libdriver.h"
+#include "../libsimulator/libsimulator.h"
+
+
+/*
+ * Passes the events of the simulation that concern the caller on to its
+ * callbacks. Without I/O, no job blocks or wakes.
+ */
+static void forward_event(void *context, event_type_t type, int time, int job, int core)
+{
+	const driver_callbacks_t *callbacks = context;
+
+	switch (type)
+	{
+		case EVENT_ARRIVE:
+			if (callbacks->arrived != NULL)
+				callbacks->arrived(callbacks->context, time, job);
+			break;
+
+		case EVENT_DISPATCH:
+			if (callbacks->assigned != NULL)
+				callbacks->assigned(callbacks->context, time, job, core);
+			break;
+
+		case EVENT_PREEMPT:
+		case EVENT_QUANTUM_EXPIRE:
+		case EVENT_FINISH:
+			if (callbacks->released != NULL)
+				callbacks->released(callbacks->context, time, job, core,
+						(type == EVENT_PREEMPT ? DRIVER_PREEMPTED : type == EVENT_QUANTUM_EXPIRE ? DRIVER_QUANTUM_EXPIRED : DRIVER_FINISHED));
+			break;
+
+		default:
+			break;
+	}
+}
+
+
+/**
+  Schedules jobs on cores under a scheme, taking the jobs from an iterator
+  and reporting what happens to them through callbacks. Nothing is
+  printed. Jobs are taken as the simulated time reaches their arrival, and
+  stretches with nothing to run are skipped in one go. The record of a job
+  is freed once it finishes, though a few words per job are kept until the
+  run ends.
+
+  Jobs that arrive, or finish, in the same time unit are handed to the
+  scheduler in the order the simulation holds them, as in the simulator.
+  As the driver holds fewer jobs at a time, that order, and so the
+  schedule, may differ from the simulator's run of the same trace where
+  such ties occur.
+
+  @param cores the number of cores
+  @param scheme the scheme, as the simulator's -s option takes it, such as
+  fcfs, rr4 or mlfq:2,4,8
+  @param next_job hands over the next job, in order of arrival time
+  @param job_context passed to next_job
+  @param callbacks what to report events to, or NULL
+  @param result receives the averages once every job has finished, or NULL
+  @return 0 on success
+  @return -1 if the cores or scheme are invalid, the jobs are not in order
+  of arrival time, next_job failed, memory ran out or the scheduler made
+  an invalid decision
+ */
+int driver_run(int cores, const char *scheme, driver_next_job_t next_job, void *job_context,
+		const driver_callbacks_t *callbacks, driver_result_t *result)
+{
+	scheme_t parsed;
+	scheduler_options_t options;
+	driver_callbacks_t none = { NULL, NULL, NULL, NULL };
+	driver_job_t pending;
+	int last_arrival = INT_MIN;
+	int jobs = 0, status = 0;
+
+	if (cores < 1 || scheme == NULL || next_job == NULL || simulator_parse_scheme(scheme, &parsed, &options) != 0)
+		return -1;
+
+	simulator_t *sim = simulator_create(cores, parsed, &options);
+	if (sim == NULL)
+		return -1;
+	simulator_set_listener(sim, forward_event, (void *)(callbacks != NULL ? callbacks : &none));
+
+	int more = next_job(job_context, &pending);
+	while (more >= 0 && status >= 0)
+	{
+		// Take every job that has arrived by now, and the next one to come when nothing else is left.
+		while (more > 0 && (pending.arrival_time <= simulator_time(sim) || simulator_active_jobs(sim) == 0))
+		{
+			simulator_job_t job = { pending.arrival_time, pending.run_time, pending.priority, pending.deadline, 0, 1, NULL };
+
+			if (pending.arrival_time < last_arrival || pending.run_time < 1 || simulator_add_job(sim, &job) < 0)
+			{
+				more = -1;
+				break;
+			}
+			last_arrival = pending.arrival_time;
+			jobs++;
+			more = next_job(job_context, &pending);
+		}
+
+		if (more < 0 || simulator_active_jobs(sim) == 0)
+			break;
+		status = simulator_run_until(sim, (more > 0 ? pending.arrival_time : INT_MAX));
+	}
+
+	if (more < 0 || status < 0)
+	{
+		simulator_destroy(sim);
+		return -1;
+	}
+
+	if (result != NULL)
+	{
+		scheduler_t *s = simulator_scheduler(sim);
+
+		result->jobs = jobs;
+		result->end_time = simulator_time(sim);
+		result->average_waiting_time = (jobs > 0 ? scheduler_average_waiting_time_r(s) : 0);
+		result->average_turnaround_time = (jobs > 0 ? scheduler_average_turnaround_time_r(s) : 0);
+		result->average_response_time = (jobs > 0 ? scheduler_average_response_time_r(s) : 0);
+		result->utilization = (jobs > 0 ? scheduler_cpu_utilization_r(s) : 0);
+	}
+
+	simulator_destroy(sim);
+	return 0;
+}
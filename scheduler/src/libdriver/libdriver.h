@@ -0,0 +1,79 @@
+/** @file libdriver.h
+
+  The public interface of the scheduler library, libscheduler.a and
+  libscheduler.so, for programs that embed the schedulers. It depends on
+  no other header of the project, and changes to it only ever add to it;
+  DRIVER_API_VERSION counts the additions.
+ */
+
+#ifndef LIBDRIVER_H_
+#define LIBDRIVER_H_
+
+#define DRIVER_API_VERSION 1
+
+/* The library is built with hidden symbols; only what is marked here is exported. */
+#if defined(__GNUC__)
+#define DRIVER_EXPORT __attribute__((visibility("default")))
+#else
+#define DRIVER_EXPORT
+#endif
+
+/**
+  Why a job left the core it ran on
+*/
+typedef enum {DRIVER_PREEMPTED = 0, DRIVER_QUANTUM_EXPIRED, DRIVER_FINISHED} driver_release_t;
+
+/**
+  A job as the caller hands it to the driver. A deadline, the time by which
+  the job should finish, only matters to EDF and PEDF; 0 means none.
+*/
+typedef struct _driver_job_t
+{
+	int arrival_time;
+	int run_time;
+	int priority;
+	int deadline;
+} driver_job_t;
+
+/**
+  Hands the driver the next job, in order of arrival time. The driver only
+  asks for a job once the simulated time has reached the arrival of the
+  one before it, so jobs may be produced as they come.
+
+  @return 1 with the next job filled in
+  @return 0 when there are no more jobs
+  @return -1 to stop the run with an error
+*/
+typedef int (*driver_next_job_t)(void *context, driver_job_t *job);
+
+/**
+  What the driver reports as it schedules, any of which may be NULL. Jobs
+  are numbered from 0 in the order they were handed over. A job leaving a
+  core is reported before the job that takes it over, and a job whose
+  quantum expires and that carries on is released and assigned again.
+*/
+typedef struct _driver_callbacks_t
+{
+	void (*arrived)(void *context, int time, int job);                                  ///< The job arrived
+	void (*assigned)(void *context, int time, int job, int core);                       ///< The job starts or resumes on the core
+	void (*released)(void *context, int time, int job, int core, driver_release_t why); ///< The job left the core
+	void *context;                                                                      ///< Passed to every callback
+} driver_callbacks_t;
+
+/**
+  The outcome of a run
+*/
+typedef struct _driver_result_t
+{
+	int jobs;
+	int end_time;                      ///< Time the last job finished
+	float average_waiting_time;
+	float average_turnaround_time;
+	float average_response_time;
+	float utilization;                 ///< Fraction of the time from the first arrival the cores were busy
+} driver_result_t;
+
+DRIVER_EXPORT int driver_run(int cores, const char *scheme, driver_next_job_t next_job, void *job_context,
+                             const driver_callbacks_t *callbacks, driver_result_t *result);
+
+#endif /* LIBDRIVER_H_ */
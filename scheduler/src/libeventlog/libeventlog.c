@@ -0,0 +1,186 @@
+/** @file libeventlog.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "libeventlog.h"
+
+/*
+ * An event log starts with a header of four 32-bit integers: the magic
+ * number, the version of the format, the number of cores and the size of
+ * an event, followed by the events themselves.
+ */
+#define EVENTLOG_MAGIC   0x4c564553
+#define EVENTLOG_VERSION 1
+
+#define EVENTLOG_DEFAULT_BATCH 4096
+
+/**
+  Stores the state of an event log being written.
+*/
+struct _eventlog_t
+{
+	FILE *out;
+	eventlog_event_t *events;
+	int batch;
+	int pending;
+	long long count;
+	int failed;
+};
+
+
+/**
+  Starts an event log, writing its header to the stream.
+
+  @param out the stream to write the log to, opened in binary mode
+  @param cores the number of cores the events happen on
+  @param batch the number of events written out at a time, or 0 for the
+  default
+  @return the new event log
+  @return NULL if memory ran out or the header could not be written
+ */
+eventlog_t *eventlog_open(FILE *out, int cores, int batch)
+{
+	int32_t header[4] = { EVENTLOG_MAGIC, EVENTLOG_VERSION, cores, sizeof(eventlog_event_t) };
+	eventlog_t *log = malloc(sizeof(eventlog_t));
+
+	if (log == NULL)
+		return NULL;
+
+	log->out = out;
+	log->batch = (batch > 0 ? batch : EVENTLOG_DEFAULT_BATCH);
+	log->events = malloc(log->batch * sizeof(eventlog_event_t));
+	log->pending = 0;
+	log->count = 0;
+	log->failed = 0;
+
+	if (log->events == NULL || fwrite(header, sizeof(header), 1, out) != 1)
+	{
+		free(log->events);
+		free(log);
+		return NULL;
+	}
+
+	return log;
+}
+
+
+/**
+  Adds an event to the log. It reaches the file with the rest of its batch
+  once the batch is full, or on eventlog_flush().
+
+  @param log the event log
+  @param type what happened
+  @param time the simulated time it happened at
+  @param job the job it happened to
+  @param core the core it happened on, or -1 for none
+ */
+void eventlog_write(eventlog_t *log, event_type_t type, int time, int job, int core)
+{
+	eventlog_event_t *event = &log->events[log->pending++];
+
+	event->time = time;
+	event->type = type;
+	event->job = job;
+	event->core = core;
+	log->count++;
+
+	if (log->pending == log->batch)
+		eventlog_flush(log);
+}
+
+
+/**
+  Writes out the events gathered so far.
+
+  @param log the event log
+  @return 0 if every event so far reached the stream
+  @return -1 if writing failed, now or before
+ */
+int eventlog_flush(eventlog_t *log)
+{
+	if (log->pending > 0 && fwrite(log->events, sizeof(eventlog_event_t), log->pending, log->out) != (size_t)log->pending)
+		log->failed = 1;
+	log->pending = 0;
+
+	return (log->failed ? -1 : 0);
+}
+
+
+/**
+  Returns the number of events added to the log.
+
+  @param log the event log
+ */
+long long eventlog_count(eventlog_t *log)
+{
+	return log->count;
+}
+
+
+/**
+  Writes out the events gathered so far and frees the event log. The
+  stream is left open.
+
+  @param log the event log
+  @return 0 if every event reached the stream
+  @return -1 if writing failed
+ */
+int eventlog_close(eventlog_t *log)
+{
+	int status = eventlog_flush(log);
+
+	free(log->events);
+	free(log);
+	return status;
+}
+
+
+/**
+  Reads the header of an event log, which must come before its events are
+  read with eventlog_read().
+
+  @param in the stream to read from
+  @param cores receives the number of cores the events happen on
+  @return 0 on success
+  @return -1 if the stream does not hold an event log this build can read
+ */
+int eventlog_read_header(FILE *in, int *cores)
+{
+	int32_t header[4];
+
+	if (fread(header, sizeof(header), 1, in) != 1 || header[0] != EVENTLOG_MAGIC || header[1] != EVENTLOG_VERSION
+			|| header[2] <= 0 || header[3] != sizeof(eventlog_event_t))
+		return -1;
+
+	*cores = header[2];
+	return 0;
+}
+
+
+/**
+  Reads the next events of an event log.
+
+  @param in the stream to read from
+  @param events receives the events
+  @param count the most events to read
+  @return the number of events read, 0 at the end of the log
+ */
+int eventlog_read(FILE *in, eventlog_event_t *events, int count)
+{
+	return fread(events, sizeof(eventlog_event_t), count, in);
+}
+
+
+/**
+  Returns the name of a type of event, as used in traces.
+
+  @param type the type of event
+ */
+const char *eventlog_type_name(event_type_t type)
+{
+	static const char *names[] = { "arrive", "dispatch", "preempt", "quantum expire", "block", "wake", "finish" };
+
+	return (type >= EVENT_ARRIVE && type <= EVENT_FINISH ? names[type] : "unknown");
+}
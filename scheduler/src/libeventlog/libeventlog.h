@@ -0,0 +1,46 @@
+/** @file libeventlog.h
+ */
+
+#ifndef LIBEVENTLOG_H_
+#define LIBEVENTLOG_H_
+
+#include <stdio.h>
+#include <stdint.h>
+
+/**
+  What happened to a job. A job is dispatched to a core when it starts or
+  resumes running there, and leaves it when it is preempted by another,
+  its quantum expires, it blocks on I/O or it finishes.
+*/
+typedef enum {EVENT_ARRIVE = 0, EVENT_DISPATCH, EVENT_PREEMPT, EVENT_QUANTUM_EXPIRE, EVENT_BLOCK, EVENT_WAKE, EVENT_FINISH} event_type_t;
+
+/**
+  One event of an event log, as it is stored in the file: four 32-bit
+  integers in the byte order of the machine that wrote it.
+*/
+typedef struct _eventlog_event_t
+{
+  int32_t time;
+  int32_t type;
+  int32_t job;
+  int32_t core;   ///< -1 for events that do not happen on a core
+} eventlog_event_t;
+
+/**
+  A binary log of scheduling events being written to a file. Events are
+  gathered in a buffer of fixed size and written out a batch at a time, so
+  that logging one costs a few stores.
+*/
+typedef struct _eventlog_t eventlog_t;
+
+eventlog_t *eventlog_open       (FILE *out, int cores, int batch);
+void        eventlog_write      (eventlog_t *log, event_type_t type, int time, int job, int core);
+int         eventlog_flush      (eventlog_t *log);
+long long   eventlog_count      (eventlog_t *log);
+int         eventlog_close      (eventlog_t *log);
+
+int         eventlog_read_header(FILE *in, int *cores);
+int         eventlog_read       (FILE *in, eventlog_event_t *events, int count);
+const char *eventlog_type_name  (event_type_t type);
+
+#endif /* LIBEVENTLOG_H_ */
@@ -0,0 +1,452 @@
+/** @file libexecutor.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libexecutor.h"
+
+
+typedef struct _executor_task_t
+{
+	executor_fn_t fn;
+	void *arg;
+	int done;
+	int running;
+	long long submitted;
+	long long started;
+	long long finished;
+	long long cpu;
+} executor_task_t;
+
+typedef struct _executor_worker_t
+{
+	struct _executor_t *ex;
+	int core_id;
+} executor_worker_t;
+
+/**
+  Stores the complete state of an executor. Everything below the lock is
+  only touched with it held; the scheduler instance in particular is only
+  ever called with it held, so it sees one event at a time.
+*/
+struct _executor_t
+{
+	int cores;
+	long long unit;
+	long long start;
+	pthread_t *threads;
+	executor_worker_t *workers;
+
+	pthread_mutex_t lock;
+	pthread_cond_t changed;
+	scheduler_t *scheduler;
+	int time;
+	int stop;
+
+	executor_task_t *tasks;
+	int tasks_ct;
+	int tasks_size;
+	int finished_ct;
+
+	int *assigned;
+	int *slice_end;
+};
+
+
+static long long now_ns()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec * 1000000000LL + ts.tv_nsec;
+}
+
+
+/*
+ * Returns the current time in time units, never earlier than the time of
+ * the last event given to the scheduler.
+ */
+static int current_time(executor_t *ex)
+{
+	int time = (now_ns() - ex->start) / ex->unit;
+
+	if (time > ex->time)
+		ex->time = time;
+	return ex->time;
+}
+
+
+/*
+ * Records the scheduler's decision to run a task on a core, restarting the
+ * core's time slice, and wakes the workers.
+ */
+static void assign(executor_t *ex, int core_id, int task, int time)
+{
+	int quantum;
+
+	ex->assigned[core_id] = task;
+	quantum = (task != -1 ? scheduler_quantum_r(ex->scheduler, core_id) : 0);
+	ex->slice_end[core_id] = (quantum > 0 ? time + quantum : -1);
+	pthread_cond_broadcast(&ex->changed);
+}
+
+
+/*
+ * Runs the tasks the scheduler puts on one core. Between pieces of a task
+ * the worker reports to the scheduler: that the task finished, or that its
+ * time slice ran out. A task another one preempted is switched out at its
+ * next yield point; one that finished in the piece it was preempted in is
+ * reported finished when the scheduler next puts it on a core. A task is
+ * only ever run by one worker at a time: if the scheduler moves a task
+ * whose piece is still running to another core, that core waits for it.
+ */
+static void *worker(void *arg)
+{
+	executor_worker_t *w = arg;
+	executor_t *ex = w->ex;
+	int core_id = w->core_id;
+
+	pthread_mutex_lock(&ex->lock);
+	while (!ex->stop)
+	{
+		int id = ex->assigned[core_id];
+
+		if (id == -1 || ex->tasks[id].running)
+		{
+			pthread_cond_wait(&ex->changed, &ex->lock);
+			continue;
+		}
+
+		if (!ex->tasks[id].done)
+		{
+			executor_fn_t fn = ex->tasks[id].fn;
+			void *fn_arg = ex->tasks[id].arg;
+			long long begin = now_ns();
+
+			if (ex->tasks[id].started < 0)
+				ex->tasks[id].started = begin;
+			ex->tasks[id].running = 1;
+
+			pthread_mutex_unlock(&ex->lock);
+			int more = fn(fn_arg);
+			long long end = now_ns();
+			pthread_mutex_lock(&ex->lock);
+
+			ex->tasks[id].cpu += end - begin;
+			ex->tasks[id].running = 0;
+			if (!more)
+			{
+				ex->tasks[id].done = 1;
+				ex->tasks[id].finished = end;
+			}
+
+			if (ex->assigned[core_id] != id)
+			{
+				pthread_cond_broadcast(&ex->changed);
+				continue;
+			}
+		}
+
+		int time = current_time(ex);
+
+		if (ex->tasks[id].done)
+		{
+			int next = scheduler_job_finished_r(ex->scheduler, core_id, id, time);
+
+			ex->finished_ct++;
+			assign(ex, core_id, next, time);
+		}
+		else if (ex->slice_end[core_id] >= 0 && time >= ex->slice_end[core_id])
+			assign(ex, core_id, scheduler_quantum_expired_r(ex->scheduler, core_id, time), time);
+	}
+	pthread_mutex_unlock(&ex->lock);
+
+	return NULL;
+}
+
+
+/**
+  Creates an executor and starts its workers, one per core.
+
+  @param cores the number of cores, and of worker threads
+  @param scheme the scheme that decides which task runs on which core
+  @param options parameters of the scheme, or NULL for the defaults
+  @param unit_us the length of a time unit in microseconds
+  @return the new executor
+  @return NULL if the workers could not be started
+ */
+executor_t *executor_create(int cores, scheme_t scheme, const scheduler_options_t *options, int unit_us)
+{
+	executor_t *ex = calloc(1, sizeof(executor_t));
+
+	ex->cores = cores;
+	ex->unit = (unit_us > 0 ? unit_us : 1) * 1000LL;
+	ex->start = now_ns();
+	ex->scheduler = scheduler_create(cores, scheme, options);
+	pthread_mutex_init(&ex->lock, NULL);
+	pthread_cond_init(&ex->changed, NULL);
+
+	ex->assigned = malloc(cores * sizeof(int));
+	ex->slice_end = malloc(cores * sizeof(int));
+	for (int i = 0; i < cores; i++)
+	{
+		ex->assigned[i] = -1;
+		ex->slice_end[i] = -1;
+	}
+
+	ex->threads = malloc(cores * sizeof(pthread_t));
+	ex->workers = malloc(cores * sizeof(executor_worker_t));
+	for (int i = 0; i < cores; i++)
+	{
+		ex->workers[i].ex = ex;
+		ex->workers[i].core_id = i;
+		if (pthread_create(&ex->threads[i], NULL, worker, &ex->workers[i]) != 0)
+		{
+			ex->cores = i;
+			executor_destroy(ex);
+			return NULL;
+		}
+	}
+
+	return ex;
+}
+
+
+/**
+  Submits a task, which arrives at the scheduler right away. Tasks are
+  numbered in the order they are submitted, starting at 0.
+
+  @param ex the executor
+  @param fn the task's work, called until it returns 0
+  @param arg passed to every call of fn
+  @param priority the task's priority, lower values first
+  @param cost the task's estimated running time in time units, which is all
+  the scheduler knows of it
+  @return the task number
+  @return -1 if memory ran out
+ */
+int executor_submit(executor_t *ex, executor_fn_t fn, void *arg, int priority, int cost)
+{
+	pthread_mutex_lock(&ex->lock);
+
+	if (ex->tasks_ct == ex->tasks_size)
+	{
+		int size = (ex->tasks_size > 0 ? 2 * ex->tasks_size : 64);
+		executor_task_t *grown = realloc(ex->tasks, size * sizeof(executor_task_t));
+
+		if (grown == NULL)
+		{
+			pthread_mutex_unlock(&ex->lock);
+			return -1;
+		}
+		ex->tasks = grown;
+		ex->tasks_size = size;
+	}
+
+	int id = ex->tasks_ct++;
+	executor_task_t *task = &ex->tasks[id];
+	task->fn = fn;
+	task->arg = arg;
+	task->done = 0;
+	task->running = 0;
+	task->submitted = now_ns();
+	task->started = -1;
+	task->finished = -1;
+	task->cpu = 0;
+
+	int time = current_time(ex);
+	int core_id = scheduler_new_job_r(ex->scheduler, id, time, (cost > 0 ? cost : 1), priority);
+	if (core_id >= 0)
+		assign(ex, core_id, id, time);
+
+	pthread_mutex_unlock(&ex->lock);
+	return id;
+}
+
+
+/**
+  Waits until every task submitted so far has finished.
+
+  @param ex the executor
+ */
+void executor_wait(executor_t *ex)
+{
+	pthread_mutex_lock(&ex->lock);
+	while (ex->finished_ct < ex->tasks_ct)
+		pthread_cond_wait(&ex->changed, &ex->lock);
+	pthread_mutex_unlock(&ex->lock);
+}
+
+
+/**
+  Returns the current time in time units since the executor was created.
+
+  @param ex the executor
+ */
+int executor_now(executor_t *ex)
+{
+	return (now_ns() - ex->start) / ex->unit;
+}
+
+
+/**
+  Returns the number of tasks submitted.
+
+  @param ex the executor
+ */
+int executor_tasks(executor_t *ex)
+{
+	pthread_mutex_lock(&ex->lock);
+	int tasks = ex->tasks_ct;
+	pthread_mutex_unlock(&ex->lock);
+
+	return tasks;
+}
+
+
+/**
+  Returns when a task was submitted, in time units since the executor was
+  created.
+
+  @param ex the executor
+  @param task the task number
+ */
+double executor_task_arrival_time(executor_t *ex, int task)
+{
+	pthread_mutex_lock(&ex->lock);
+	double time = (ex->tasks[task].submitted - ex->start) / (double)ex->unit;
+	pthread_mutex_unlock(&ex->lock);
+
+	return time;
+}
+
+
+/**
+  Returns the time a task has spent running so far, in time units. Once it
+  has finished, this is its actual cost, as opposed to the estimate it was
+  submitted with.
+
+  @param ex the executor
+  @param task the task number
+ */
+double executor_task_cpu_time(executor_t *ex, int task)
+{
+	pthread_mutex_lock(&ex->lock);
+	double time = ex->tasks[task].cpu / (double)ex->unit;
+	pthread_mutex_unlock(&ex->lock);
+
+	return time;
+}
+
+
+/*
+ * Averages a measure, in time units, over every finished task: 0 for the
+ * waiting time, 1 for the turnaround time and 2 for the response time.
+ */
+static float average(executor_t *ex, int measure)
+{
+	double sum = 0;
+	int count = 0;
+
+	pthread_mutex_lock(&ex->lock);
+	for (int i = 0; i < ex->tasks_ct; i++)
+	{
+		executor_task_t *task = &ex->tasks[i];
+
+		if (task->finished < 0)
+			continue;
+
+		long long turnaround = task->finished - task->submitted;
+		if (measure == 0)
+			sum += turnaround - task->cpu;
+		else if (measure == 1)
+			sum += turnaround;
+		else
+			sum += task->started - task->submitted;
+		count++;
+	}
+	pthread_mutex_unlock(&ex->lock);
+
+	return (count > 0 ? sum / count / ex->unit : 0);
+}
+
+
+/**
+  Returns the average time the finished tasks spent waiting, measured in
+  real time and given in time units.
+
+  @param ex the executor
+ */
+float executor_average_waiting_time(executor_t *ex)
+{
+	return average(ex, 0);
+}
+
+
+/**
+  Returns the average time from submission to completion of the finished
+  tasks, measured in real time and given in time units.
+
+  @param ex the executor
+ */
+float executor_average_turnaround_time(executor_t *ex)
+{
+	return average(ex, 1);
+}
+
+
+/**
+  Returns the average time from submission until the finished tasks first
+  ran, measured in real time and given in time units.
+
+  @param ex the executor
+ */
+float executor_average_response_time(executor_t *ex)
+{
+	return average(ex, 2);
+}
+
+
+/**
+  Returns the scheduler instance deciding for the executor, whose own
+  averages are in whole time units as it saw the events. It must not be
+  called while tasks are running.
+
+  @param ex the executor
+ */
+scheduler_t *executor_scheduler(executor_t *ex)
+{
+	return ex->scheduler;
+}
+
+
+/**
+  Stops the workers, once they are done with the piece of work they are
+  running, and frees the executor and its scheduler instance. Tasks that
+  have not finished are abandoned; call executor_wait() first to finish
+  them.
+
+  @param ex the executor
+ */
+void executor_destroy(executor_t *ex)
+{
+	pthread_mutex_lock(&ex->lock);
+	ex->stop = 1;
+	pthread_cond_broadcast(&ex->changed);
+	pthread_mutex_unlock(&ex->lock);
+
+	for (int i = 0; i < ex->cores; i++)
+		pthread_join(ex->threads[i], NULL);
+
+	pthread_mutex_destroy(&ex->lock);
+	pthread_cond_destroy(&ex->changed);
+	scheduler_destroy(ex->scheduler);
+	free(ex->threads);
+	free(ex->workers);
+	free(ex->assigned);
+	free(ex->slice_end);
+	free(ex->tasks);
+	free(ex);
+}
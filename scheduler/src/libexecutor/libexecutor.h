@@ -0,0 +1,38 @@
+/** @file libexecutor.h
+ */
+
+#ifndef LIBEXECUTOR_H_
+#define LIBEXECUTOR_H_
+
+#include "../libscheduler/libscheduler.h"
+
+/**
+  A task's work, run a piece at a time on one of the executor's workers.
+  Every call does some of the work and returns, which is the task's yield
+  point: nonzero while work remains, 0 once the task is done. Between calls
+  the task may be switched out for another, so a task holding the worker
+  for long stretches delays the scheduler's decisions.
+*/
+typedef int (*executor_fn_t)(void *arg);
+
+/**
+  A pool of worker threads, one per core, running tasks in the order a
+  scheduler instance decides. Real time is counted in time units of a
+  fixed number of microseconds since the executor was created.
+*/
+typedef struct _executor_t executor_t;
+
+executor_t  *executor_create                  (int cores, scheme_t scheme, const scheduler_options_t *options, int unit_us);
+int          executor_submit                  (executor_t *ex, executor_fn_t fn, void *arg, int priority, int cost);
+void         executor_wait                    (executor_t *ex);
+int          executor_now                     (executor_t *ex);
+int          executor_tasks                   (executor_t *ex);
+double       executor_task_arrival_time       (executor_t *ex, int task);
+double       executor_task_cpu_time           (executor_t *ex, int task);
+float        executor_average_waiting_time    (executor_t *ex);
+float        executor_average_turnaround_time (executor_t *ex);
+float        executor_average_response_time   (executor_t *ex);
+scheduler_t *executor_scheduler               (executor_t *ex);
+void         executor_destroy                 (executor_t *ex);
+
+#endif /* LIBEXECUTOR_H_ */
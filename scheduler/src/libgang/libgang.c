@@ -0,0 +1,419 @@
+/** @file libgang.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+
+#include "libgang.h"
+#include "../librbtree/librbtree.h"
+
+/*
+ * A job as the gang scheduler tracks it. Waiting jobs are linked into the
+ * queue in order of arrival, so that a backfilled job leaves it in
+ * constant time.
+ */
+typedef struct _gang_job_t
+{
+	int id;
+	int arrival_time;
+	int run_time;
+	int cores;
+	int start_time;
+	int end_time;
+	int prev, next;
+} gang_job_t;
+
+/**
+  Stores the state of a gang-scheduled run.
+*/
+typedef struct _gang_t
+{
+	gang_job_t *jobs;
+	int cores;
+	gang_policy_t policy;
+	FILE *trace;
+	int *starts;
+
+	int *core_job;       ///< Job on each core, or -1
+	int free;            ///< Cores without a job
+
+	int head, tail;      ///< Ends of the queue, or -1
+	int waiting;
+	int *needing;        ///< Waiting jobs by the number of cores they need
+
+	rbtree_t running;    ///< Running jobs in order of the time they end, the availability profile
+
+	int backfilled;
+	long long busy_time;
+} gang_t;
+
+
+/**
+  Parses the name of a gang scheduling policy, fcfs or easy. Case is
+  ignored.
+
+  @param name the name
+  @param policy receives the policy
+  @return 0 on success
+  @return -1 if the name is not a known policy
+ */
+int gang_parse_policy(const char *name, gang_policy_t *policy)
+{
+	if (strcasecmp(name, "fcfs") == 0)
+		*policy = GANG_FCFS;
+	else if (strcasecmp(name, "easy") == 0)
+		*policy = GANG_EASY;
+	else
+		return -1;
+	return 0;
+}
+
+
+/**
+  Returns the name of a gang scheduling policy, as gang_parse_policy()
+  takes it.
+
+  @param policy the policy
+  @return the name
+ */
+const char *gang_policy_name(gang_policy_t policy)
+{
+	return (policy == GANG_EASY ? "easy" : "fcfs");
+}
+
+
+/* Orders running jobs by the time they end, then by number */
+static int compare_end(const void *a, const void *b)
+{
+	const gang_job_t *x = a, *y = b;
+
+	if (x->end_time != y->end_time)
+		return (x->end_time < y->end_time ? -1 : 1);
+	return (x->id < y->id ? -1 : x->id > y->id);
+}
+
+
+/* Orders jobs by arrival time, then by number */
+static int compare_arrival(const void *a, const void *b)
+{
+	const gang_job_t *x = *(gang_job_t * const *)a, *y = *(gang_job_t * const *)b;
+
+	if (x->arrival_time != y->arrival_time)
+		return (x->arrival_time < y->arrival_time ? -1 : 1);
+	return (x->id < y->id ? -1 : x->id > y->id);
+}
+
+
+/* Prints the cores a job holds as ranges, as in 0-3,6 */
+static void print_cores(gang_t *g, int id)
+{
+	const char *separator = "";
+
+	for (int c = 0; c < g->cores; c++)
+	{
+		if (g->core_job[c] != id)
+			continue;
+
+		int last = c;
+		while (last + 1 < g->cores && g->core_job[last + 1] == id)
+			last++;
+		if (last > c)
+			fprintf(g->trace, "%s%d-%d", separator, c, last);
+		else
+			fprintf(g->trace, "%s%d", separator, c);
+		separator = ",";
+		c = last;
+	}
+}
+
+
+static void enqueue(gang_t *g, gang_job_t *job)
+{
+	job->prev = g->tail;
+	job->next = -1;
+	if (g->tail != -1)
+		g->jobs[g->tail].next = job->id;
+	else
+		g->head = job->id;
+	g->tail = job->id;
+
+	g->waiting++;
+	g->needing[job->cores]++;
+}
+
+
+/*
+ * Takes a job off the queue and starts it on the lowest-numbered free
+ * cores, all of them at once.
+ */
+static void start_job(gang_t *g, gang_job_t *job, int time, int backfilled)
+{
+	if (job->prev != -1)
+		g->jobs[job->prev].next = job->next;
+	else
+		g->head = job->next;
+	if (job->next != -1)
+		g->jobs[job->next].prev = job->prev;
+	else
+		g->tail = job->prev;
+	g->waiting--;
+	g->needing[job->cores]--;
+
+	for (int c = 0, taken = 0; taken < job->cores; c++)
+	{
+		if (g->core_job[c] == -1)
+		{
+			g->core_job[c] = job->id;
+			taken++;
+		}
+	}
+	g->free -= job->cores;
+
+	job->start_time = time;
+	job->end_time = time + job->run_time;
+	rbtree_insert(&g->running, job);
+
+	g->busy_time += (long long)job->cores * job->run_time;
+	g->backfilled += backfilled;
+	if (g->starts != NULL)
+		g->starts[job->id] = time;
+
+	if (g->trace != NULL)
+	{
+		fprintf(g->trace, "At time %d, job %d (running time=%d, cores=%d) started on core(s) ", time, job->id,
+				job->run_time, job->cores);
+		print_cores(g, job->id);
+		fprintf(g->trace, "%s.\n", backfilled ? ", backfilled" : "");
+	}
+}
+
+
+static void finish_job(gang_t *g, gang_job_t *job)
+{
+	if (g->trace != NULL)
+	{
+		fprintf(g->trace, "At time %d, job %d finished, freeing core(s) ", job->end_time, job->id);
+		print_cores(g, job->id);
+		fprintf(g->trace, ".\n");
+	}
+
+	for (int c = 0; c < g->cores; c++)
+		if (g->core_job[c] == job->id)
+			g->core_job[c] = -1;
+	g->free += job->cores;
+}
+
+
+/*
+ * Walks the availability profile, the cores free now and those each
+ * running job frees as it ends, for the earliest time a job needing need
+ * cores could start: the shadow time its reservation is at. Also finds the
+ * cores free then beyond its need, which jobs still running at the shadow
+ * time may use without delaying it. Every running job holds a core, so the
+ * walk takes no more steps than there are cores, however long the queue.
+ */
+static void find_reservation(gang_t *g, int need, int *shadow, int *extra)
+{
+	int free = g->free;
+
+	for (rbnode_t *node = rbtree_first(&g->running); node != NULL; node = rbtree_next(node))
+	{
+		gang_job_t *job = node->value;
+		rbnode_t *after = rbtree_next(node);
+
+		free += job->cores;
+		// Count every job that ends at the same time before deciding.
+		if (free >= need && (after == NULL || ((gang_job_t *)after->value)->end_time != job->end_time))
+		{
+			*shadow = job->end_time;
+			*extra = free - need;
+			return;
+		}
+	}
+
+	// Not reached: no job needs more cores than there are.
+	*shadow = INT_MAX;
+	*extra = 0;
+}
+
+
+/* Whether any waiting job needs no more cores than are free */
+static int any_fits(gang_t *g)
+{
+	for (int k = 1; k <= g->free; k++)
+		if (g->needing[k] > 0)
+			return 1;
+	return 0;
+}
+
+
+/*
+ * Starts jobs from the head of the queue while they fit. Under EASY, once
+ * the head does not, it is given a reservation and later jobs that fit now
+ * are backfilled if they end by the shadow time or only use cores the
+ * reservation leaves spare.
+ */
+static void schedule(gang_t *g, int time)
+{
+	while (g->head != -1 && g->jobs[g->head].cores <= g->free)
+		start_job(g, &g->jobs[g->head], time, 0);
+
+	if (g->policy != GANG_EASY || g->head == -1 || !any_fits(g))
+		return;
+
+	int shadow, extra;
+	find_reservation(g, g->jobs[g->head].cores, &shadow, &extra);
+
+	for (int id = g->jobs[g->head].next; id != -1 && g->free > 0; )
+	{
+		gang_job_t *job = &g->jobs[id];
+
+		id = job->next;
+		if (job->cores > g->free)
+			continue;
+
+		if ((long long)time + job->run_time <= shadow)
+			start_job(g, job, time, 1);
+		else if (job->cores <= extra)
+		{
+			extra -= job->cores;
+			start_job(g, job, time, 1);
+		}
+	}
+}
+
+
+/**
+  Simulates jobs that each need a number of cores at the same time, which
+  they hold from start to finish without being preempted. Jobs that arrive
+  together are queued in the order they are given in. At every time a job
+  arrives or finishes, finished jobs free their cores first, then arrived
+  jobs join the queue, and then the policy starts what it can.
+
+  Under GANG_EASY, the running time of each job serves as its estimate, so
+  reservations are exact. The running jobs, ordered by the time they end,
+  are the availability profile the reservations are found in; it holds no
+  more jobs than there are cores, so a long queue only costs a scan of the
+  jobs that might backfill, made when some waiting job fits the free cores.
+
+  @param jobs the jobs; a job needing 0 cores needs one, and only the first
+  burst of a job is used
+  @param count the number of jobs
+  @param cores the number of cores
+  @param policy how jobs are started
+  @param trace receives a line for every job started or finished, or NULL
+  @param starts receives the time each job started, or NULL
+  @param result receives the outcome
+  @return 0 on success
+  @return -1 if a job needs more cores than there are, or memory ran out
+ */
+int gang_simulate(const simulator_job_t *jobs, int count, int cores, gang_policy_t policy,
+		FILE *trace, int *starts, gang_result_t *result)
+{
+	gang_t g;
+	int i;
+
+	memset(result, 0, sizeof(gang_result_t));
+	if (cores < 1)
+		return -1;
+	for (i = 0; i < count; i++)
+		if (jobs[i].cores > cores)
+			return -1;
+	if (count == 0)
+		return 0;
+
+	memset(&g, 0, sizeof(gang_t));
+	g.cores = g.free = cores;
+	g.policy = policy;
+	g.trace = trace;
+	g.starts = starts;
+	g.head = g.tail = -1;
+	g.jobs = malloc(count * sizeof(gang_job_t));
+	g.core_job = malloc(cores * sizeof(int));
+	g.needing = calloc(cores + 1, sizeof(int));
+	gang_job_t **order = malloc(count * sizeof(gang_job_t *));
+
+	if (g.jobs == NULL || g.core_job == NULL || g.needing == NULL || order == NULL)
+	{
+		free(g.jobs);
+		free(g.core_job);
+		free(g.needing);
+		free(order);
+		return -1;
+	}
+
+	for (i = 0; i < cores; i++)
+		g.core_job[i] = -1;
+	for (i = 0; i < count; i++)
+	{
+		g.jobs[i].id = i;
+		g.jobs[i].arrival_time = jobs[i].arrival_time;
+		g.jobs[i].run_time = jobs[i].run_time;
+		g.jobs[i].cores = (jobs[i].cores > 1 ? jobs[i].cores : 1);
+		order[i] = &g.jobs[i];
+	}
+	qsort(order, count, sizeof(gang_job_t *), compare_arrival);
+	rbtree_init(&g.running, compare_end);
+
+	int time = order[0]->arrival_time;
+	int arrived = 0, done = 0;
+	long long fragmented = 0;
+
+	while (done < count)
+	{
+		gang_job_t *job;
+
+		while ((job = rbtree_min(&g.running)) != NULL && job->end_time <= time)
+		{
+			rbtree_poll(&g.running);
+			finish_job(&g, job);
+			done++;
+		}
+		while (arrived < count && order[arrived]->arrival_time <= time)
+			enqueue(&g, order[arrived++]);
+
+		schedule(&g, time);
+		if (g.waiting > result->max_queue)
+			result->max_queue = g.waiting;
+
+		int next = INT_MAX;
+		if (arrived < count)
+			next = order[arrived]->arrival_time;
+		if ((job = rbtree_min(&g.running)) != NULL && job->end_time < next)
+			next = job->end_time;
+		if (next == INT_MAX)
+			break;
+
+		// Cores left idle while jobs wait are lost to fragmentation.
+		if (g.waiting > 0)
+			fragmented += (long long)g.free * (next - time);
+		time = next;
+	}
+
+	double waiting = 0, turnaround = 0;
+	for (i = 0; i < count; i++)
+	{
+		waiting += g.jobs[i].start_time - g.jobs[i].arrival_time;
+		turnaround += g.jobs[i].end_time - g.jobs[i].arrival_time;
+		if (g.jobs[i].end_time > result->makespan)
+			result->makespan = g.jobs[i].end_time;
+	}
+
+	double span = (double)cores * (result->makespan - order[0]->arrival_time);
+	result->jobs = count;
+	result->backfilled = g.backfilled;
+	result->average_waiting_time = waiting / count;
+	result->average_turnaround_time = turnaround / count;
+	result->utilization = (span > 0 ? g.busy_time / span : 0);
+	result->fragmentation = (span > 0 ? fragmented / span : 0);
+
+	rbtree_destroy(&g.running);
+	free(g.jobs);
+	free(g.core_job);
+	free(g.needing);
+	free(order);
+	return 0;
+}
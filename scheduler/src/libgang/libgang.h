@@ -0,0 +1,42 @@
+/** @file libgang.h
+ */
+
+#ifndef LIBGANG_H_
+#define LIBGANG_H_
+
+#include <stdio.h>
+
+#include "../libsimulator/libsimulator.h"
+
+/**
+  How jobs that need several cores at once are started. Under GANG_FCFS,
+  jobs start strictly in order of arrival, each once enough cores are free.
+  Under GANG_EASY, the job at the head of the queue is given a reservation
+  at the earliest time enough cores free up for it, and later jobs may start
+  ahead of it, or backfill, as long as they do not delay that reservation.
+*/
+typedef enum {GANG_FCFS = 0, GANG_EASY} gang_policy_t;
+
+/**
+  The outcome of a gang-scheduled run. Utilization and fragmentation are
+  shares of the core time from the first arrival to the last finish.
+*/
+typedef struct _gang_result_t
+{
+	int jobs;
+	int backfilled;                  ///< Jobs started ahead of an earlier one
+	int makespan;                    ///< Time the last job finished
+	int max_queue;                   ///< Most jobs waiting at once
+	float average_waiting_time;
+	float average_turnaround_time;
+	float utilization;               ///< Share of the core time spent running jobs
+	float fragmentation;             ///< Share of the core time idle while jobs waited
+} gang_result_t;
+
+int         gang_parse_policy(const char *name, gang_policy_t *policy);
+const char *gang_policy_name (gang_policy_t policy);
+
+int         gang_simulate    (const simulator_job_t *jobs, int count, int cores, gang_policy_t policy,
+                              FILE *trace, int *starts, gang_result_t *result);
+
+#endif /* LIBGANG_H_ */
@@ -0,0 +1,141 @@
+/** @file libheap.c
+ */
+
+#include <stdlib.h>
+
+#include "libheap.h"
+
+
+/**
+  Initializes the heap_t data structure.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param comparer a function pointer that compares two elements, in the same
+  way as the comparer of a priqueue_t. Elements that compare equal come out
+  in no particular order, so a comparer that only returns 0 for the same
+  element keeps the order deterministic.
+ */
+void heap_init(heap_t *h, int(*comparer)(const void *, const void *))
+{
+	h->m_array = NULL;
+	h->m_size = 0;
+	h->m_capacity = 0;
+	h->comparer = comparer;
+}
+
+
+/**
+  Inserts the specified element into the heap in O(log n).
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param ptr a pointer to the data to be inserted into the heap
+ */
+void heap_offer(heap_t *h, void *ptr)
+{
+	if (h->m_size == h->m_capacity)
+	{
+		h->m_capacity = (h->m_capacity > 0 ? 2 * h->m_capacity : 16);
+		h->m_array = realloc(h->m_array, h->m_capacity * sizeof(void *));
+	}
+
+	// Move parents down until the hole is where the element belongs.
+	int i = h->m_size++;
+	while (i > 0)
+	{
+		int parent = (i - 1) / 2;
+
+		if (h->comparer(ptr, h->m_array[parent]) >= 0)
+			break;
+		h->m_array[i] = h->m_array[parent];
+		i = parent;
+	}
+	h->m_array[i] = ptr;
+}
+
+
+/**
+  Retrieves, but does not remove, the smallest element of the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return pointer to the smallest element
+  @return NULL if the heap is empty
+ */
+void *heap_peek(heap_t *h)
+{
+	return (h->m_size > 0 ? h->m_array[0] : NULL);
+}
+
+
+/**
+  Retrieves and removes the smallest element of the heap in O(log n).
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return the smallest element
+  @return NULL if the heap is empty
+ */
+void *heap_poll(heap_t *h)
+{
+	if (h->m_size == 0)
+		return NULL;
+
+	void *top = h->m_array[0];
+	void *last = h->m_array[--h->m_size];
+
+	// Move the smaller child up until the hole is where the last element belongs.
+	int i = 0;
+	while (2 * i + 1 < h->m_size)
+	{
+		int child = 2 * i + 1;
+
+		if (child + 1 < h->m_size && h->comparer(h->m_array[child + 1], h->m_array[child]) < 0)
+			child++;
+		if (h->comparer(last, h->m_array[child]) <= 0)
+			break;
+		h->m_array[i] = h->m_array[child];
+		i = child;
+	}
+	if (h->m_size > 0)
+		h->m_array[i] = last;
+
+	return top;
+}
+
+
+/**
+  Returns the element at the given position of the heap's array, to walk
+  every element in no particular order.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @param index position of the element
+  @return the element at that position
+  @return NULL if the index is out of range
+ */
+void *heap_at(heap_t *h, int index)
+{
+	return (index >= 0 && index < h->m_size ? h->m_array[index] : NULL);
+}
+
+
+/**
+  Returns the number of elements in the heap.
+
+  @param h a pointer to an instance of the heap_t data structure
+  @return the number of elements in the heap
+ */
+int heap_size(heap_t *h)
+{
+	return h->m_size;
+}
+
+
+/**
+  Destroys and frees all the memory associated with h. The elements
+  themselves are not freed.
+
+  @param h a pointer to an instance of the heap_t data structure
+ */
+void heap_destroy(heap_t *h)
+{
+	free(h->m_array);
+	heap_init(h, h->comparer);
+}
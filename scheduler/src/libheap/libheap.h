@@ -0,0 +1,30 @@
+/** @file libheap.h
+ */
+
+#ifndef LIBHEAP_H_
+#define LIBHEAP_H_
+
+/**
+  Binary heap Data Structure. The smallest element, as defined by the
+  comparer, is at the root; the rest of the array is only partially
+  ordered.
+*/
+typedef struct _heap_t
+{
+  void** m_array;
+  int m_size;
+  int m_capacity;
+  int (*comparer)(const void *a, const void *b);
+} heap_t;
+
+void   heap_init   (heap_t *h, int(*comparer)(const void *, const void *));
+
+void   heap_offer  (heap_t *h, void *ptr);
+void * heap_peek   (heap_t *h);
+void * heap_poll   (heap_t *h);
+void * heap_at     (heap_t *h, int index);
+int    heap_size   (heap_t *h);
+
+void   heap_destroy(heap_t *h);
+
+#endif /* LIBHEAP_H_ */
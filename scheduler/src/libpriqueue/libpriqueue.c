@@ -3,9 +3,24 @@
 
 #include <stdlib.h>
 #include <stdio.h>
+#include <string.h>
 
 #include "libpriqueue.h"
 
+/*
+ * Counting the work done, which compiles away unless PRIQUEUE_STATS is
+ * defined.
+ */
+#ifdef PRIQUEUE_STATS
+#define COUNT(q, counter, n) ((q)->m_stats.counter += (n))
+#define NOTE_SIZE(q) ((q)->m_size > (q)->m_stats.high_water ? (q)->m_stats.high_water = (q)->m_size : 0)
+#define COMPARE(q, a, b) ((q)->m_stats.comparisons++, (q)->comparer((a), (b)))
+#else
+#define COUNT(q, counter, n) ((void)0)
+#define NOTE_SIZE(q) ((void)0)
+#define COMPARE(q, a, b) ((q)->comparer((a), (b)))
+#endif
+
 
 /**
   Initializes the priqueue_t data structure.
@@ -22,7 +37,11 @@ void priqueue_init(priqueue_t *q, int(*comparer)(const void *, const void *))
 {
 	q->m_size = 0;
 	q->m_front = NULL;
+	q->m_back = NULL;
 	q->comparer = comparer;
+#ifdef PRIQUEUE_STATS
+	memset(&q->m_stats, 0, sizeof(q->m_stats));
+#endif
 }
 
 void node_init(struct node_t* node){
@@ -34,6 +53,10 @@ void node_init(struct node_t* node){
 /**
   Inserts the specified element into this priority queue.
 
+  An element that orders after the current back of the queue is appended
+  without walking the list, so FIFO-like comparers insert in constant time.
+  This relies on the comparer ordering the elements consistently.
+
   @param q a pointer to an instance of the priqueue_t data structure
   @param ptr a pointer to the data to be inserted into the priority queue
   @return The zero-based index where ptr is stored in the priority queue, where 0 indicates that ptr was stored at the front of the priority queue.
@@ -42,6 +65,8 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 {
 	//ptr is expected to be a node
 	node_t* newNode = malloc(sizeof(*newNode));
+	COUNT(q, allocations, 1);
+	COUNT(q, offers, 1);
 	node_init(newNode);
 	node_t* temp = q->m_front;
 	newNode->value = ptr;
@@ -49,17 +74,24 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 	int counter = 0;
 	if(q->m_front == NULL) {
 	  q->m_front = newNode;
+	  q->m_back = newNode;
   }
-	else if (q->comparer (newNode->value, q->m_front->value) <= 0) { //should this be 1 or 0?
+	else if (COMPARE (q, newNode->value, q->m_back->value) > 0) {
+		q->m_back->next = newNode;
+		q->m_back = newNode;
+		counter = q->m_size;
+	}
+	else if (COMPARE (q, newNode->value, q->m_front->value) <= 0) { //should this be 1 or 0?
 		q->m_front = newNode;
 		newNode->next = temp;
 		counter++;
 	}
 	else {
-		while (temp->next != NULL && q->comparer (newNode->value, temp->next->value) > 0) {
+		while (temp->next != NULL && COMPARE (q, newNode->value, temp->next->value) > 0) {
 			temp = temp->next;
 			counter++;
 		}
+		COUNT(q, traversed, counter);
 		node_t* tempNode = temp->next;
 		temp->next = newNode;
 		newNode->next = tempNode;
@@ -68,10 +100,41 @@ int priqueue_offer(priqueue_t *q, void *ptr)
 	// return -1; default return
 	//might not return 0
 	q->m_size++;
+	NOTE_SIZE(q);
 	return counter;
 }
 
 
+/**
+  Inserts the specified element at the back of the queue without comparing
+  it to the others, as when rebuilding a queue from its elements in order.
+  Offering them again would not keep the order of elements that compare
+  equal.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param ptr a pointer to the data to be inserted into the priority queue
+  @return The zero-based index where ptr is stored in the priority queue, which is the last one.
+ */
+int priqueue_append(priqueue_t *q, void *ptr)
+{
+	node_t* newNode = malloc(sizeof(*newNode));
+	COUNT(q, allocations, 1);
+	node_init(newNode);
+	newNode->value = ptr;
+
+	if (q->m_front == NULL) {
+		q->m_front = newNode;
+	}
+	else {
+		q->m_back->next = newNode;
+	}
+	q->m_back = newNode;
+	q->m_size++;
+	NOTE_SIZE(q);
+	return q->m_size - 1;
+}
+
+
 /**
   Retrieves, but does not remove, the head of this queue, returning NULL if
   this queue is empty.
@@ -82,8 +145,7 @@ int priqueue_offer(priqueue_t *q, void *ptr)
  */
 void *priqueue_peek(priqueue_t *q)
 {
-	return q->m_front->value;
-	// return NULL;
+	return (q->m_front != NULL ? q->m_front->value : NULL);
 }
 
 
@@ -104,6 +166,7 @@ void *priqueue_poll(priqueue_t *q)
 	}
 	else if (temp->next == NULL){
 		q->m_front = NULL;
+		q->m_back = NULL;
 		q->m_size -= 1;
 	}
 	else{
@@ -184,9 +247,12 @@ int priqueue_remove(priqueue_t *q, void *ptr)
 			free(temp2);
 			removed++;
 		}
-		temp1 = temp1->next;
+		else{
+			temp1 = temp1->next;
+		}
 	}
 
+	q->m_back = temp1;
 	q->m_size -= removed;
 	return removed;
 }
@@ -211,6 +277,9 @@ void *priqueue_remove_at(priqueue_t *q, int index)
 	else if (index == 0){
 		temp = q->m_front;
 		q->m_front = q->m_front->next;
+		if (q->m_front == NULL){
+			q->m_back = NULL;
+		}
 		q->m_size--;
 		void* tempValue = temp->value;
 		free(temp);
@@ -224,6 +293,9 @@ void *priqueue_remove_at(priqueue_t *q, int index)
 		}
 		temp2 = temp1->next;
 		temp1->next  = temp1->next->next;
+		if (temp2 == q->m_back){
+			q->m_back = temp1;
+		}
 		q->m_size--;
 		void* tempValue = temp2->value;
 		free(temp2);
@@ -244,6 +316,27 @@ int priqueue_size(priqueue_t *q)
 }
 
 
+/**
+  Retrieves the counters of the work the queue has done since it was
+  initialized.
+
+  @param q a pointer to an instance of the priqueue_t data structure
+  @param stats receives the counters, all 0 when they are not kept
+  @return 0 if the counters are kept
+  @return -1 if the library was built without PRIQUEUE_STATS
+ */
+int priqueue_stats(priqueue_t *q, priqueue_stats_t *stats)
+{
+#ifdef PRIQUEUE_STATS
+	*stats = q->m_stats;
+	return 0;
+#else
+	memset(stats, 0, sizeof(*stats));
+	return -1;
+#endif
+}
+
+
 /**
   Destroys and frees all the memory associated with q.
 
@@ -263,6 +356,7 @@ void priqueue_destroy(priqueue_t *q)
 		}
 		node_t* temp = q->m_front;
 		q->m_front = NULL;
+		q->m_back = NULL;
 		free(temp);
 	}
 	return;
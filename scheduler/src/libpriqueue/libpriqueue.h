@@ -12,11 +12,30 @@ typedef struct node_t node_t;
 
 typedef int (*Comparer) (const void *a, const void *b);
 
+/**
+  Counters of the work a queue has done since it was initialized. They are
+  only kept when the library is built with PRIQUEUE_STATS defined, as by
+  make PRIQUEUE_STATS=1; otherwise the queue carries no counters and does
+  no counting.
+*/
+typedef struct _priqueue_stats_t
+{
+  long long comparisons;  ///< Calls to the comparer
+  long long offers;       ///< Elements offered
+  long long traversed;    ///< Nodes offers walked past to find the place of the new element
+  long long allocations;  ///< Nodes allocated
+  int high_water;         ///< Most elements the queue has held at once
+} priqueue_stats_t;
+
 typedef struct _priqueue_t
 {
   struct node_t* m_front;
+  struct node_t* m_back;
   int m_size;
   Comparer comparer;
+#ifdef PRIQUEUE_STATS
+  priqueue_stats_t m_stats;
+#endif
 
 } priqueue_t;
 
@@ -31,12 +50,14 @@ void priqueue_print(priqueue_t *q);
 void   priqueue_init     (priqueue_t *q, int(*comparer)(const void *, const void *));
 
 int    priqueue_offer    (priqueue_t *q, void *ptr);
+int    priqueue_append   (priqueue_t *q, void *ptr);
 void * priqueue_peek     (priqueue_t *q);
 void * priqueue_poll     (priqueue_t *q);
 void * priqueue_at       (priqueue_t *q, int index);
 int    priqueue_remove   (priqueue_t *q, void *ptr);
 void * priqueue_remove_at(priqueue_t *q, int index);
 int    priqueue_size     (priqueue_t *q);
+int    priqueue_stats    (priqueue_t *q, priqueue_stats_t *stats);
 
 void   priqueue_destroy  (priqueue_t *q);
 
@@ -0,0 +1,452 @@
+/** @file librbtree.c
+ */
+
+#include <stdlib.h>
+
+#include "librbtree.h"
+
+
+/**
+  Initializes the rbtree_t data structure.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @param comparer a function pointer that compares two elements, in the same
+  way as the comparer of a priqueue_t.
+ */
+void rbtree_init(rbtree_t *t, int(*comparer)(const void *, const void *))
+{
+	t->m_root = NULL;
+	t->m_leftmost = NULL;
+	t->m_size = 0;
+	t->comparer = comparer;
+}
+
+
+static void rotate_left(rbtree_t *t, rbnode_t *x)
+{
+	rbnode_t *y = x->right;
+
+	x->right = y->left;
+	if (y->left != NULL)
+		y->left->parent = x;
+
+	y->parent = x->parent;
+	if (x->parent == NULL)
+		t->m_root = y;
+	else if (x == x->parent->left)
+		x->parent->left = y;
+	else
+		x->parent->right = y;
+
+	y->left = x;
+	x->parent = y;
+}
+
+
+static void rotate_right(rbtree_t *t, rbnode_t *x)
+{
+	rbnode_t *y = x->left;
+
+	x->left = y->right;
+	if (y->right != NULL)
+		y->right->parent = x;
+
+	y->parent = x->parent;
+	if (x->parent == NULL)
+		t->m_root = y;
+	else if (x == x->parent->right)
+		x->parent->right = y;
+	else
+		x->parent->left = y;
+
+	y->right = x;
+	x->parent = y;
+}
+
+
+static rbnode_t *minimum(rbnode_t *node)
+{
+	while (node->left != NULL)
+		node = node->left;
+	return node;
+}
+
+
+static int is_red(rbnode_t *node)
+{
+	return node != NULL && node->red;
+}
+
+
+/**
+  Inserts the specified element into the tree in O(log n). Elements that
+  compare equal to ones already in the tree are placed after them.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @param ptr a pointer to the data to be inserted into the tree
+ */
+void rbtree_insert(rbtree_t *t, void *ptr)
+{
+	rbnode_t *node = malloc(sizeof(rbnode_t));
+	rbnode_t *parent = NULL;
+	rbnode_t **link = &t->m_root;
+	int leftmost = 1;
+
+	while (*link != NULL)
+	{
+		parent = *link;
+		if (t->comparer(ptr, parent->value) < 0)
+			link = &parent->left;
+		else
+		{
+			link = &parent->right;
+			leftmost = 0;
+		}
+	}
+
+	node->value = ptr;
+	node->left = NULL;
+	node->right = NULL;
+	node->parent = parent;
+	node->red = 1;
+	*link = node;
+
+	if (leftmost)
+		t->m_leftmost = node;
+
+	while (is_red(node->parent))
+	{
+		rbnode_t *p = node->parent;
+		rbnode_t *g = p->parent;
+
+		if (p == g->left)
+		{
+			rbnode_t *uncle = g->right;
+
+			if (is_red(uncle))
+			{
+				p->red = 0;
+				uncle->red = 0;
+				g->red = 1;
+				node = g;
+				continue;
+			}
+			if (node == p->right)
+			{
+				node = p;
+				rotate_left(t, node);
+				p = node->parent;
+			}
+			p->red = 0;
+			g->red = 1;
+			rotate_right(t, g);
+		}
+		else
+		{
+			rbnode_t *uncle = g->left;
+
+			if (is_red(uncle))
+			{
+				p->red = 0;
+				uncle->red = 0;
+				g->red = 1;
+				node = g;
+				continue;
+			}
+			if (node == p->left)
+			{
+				node = p;
+				rotate_right(t, node);
+				p = node->parent;
+			}
+			p->red = 0;
+			g->red = 1;
+			rotate_left(t, g);
+		}
+	}
+
+	t->m_root->red = 0;
+	t->m_size++;
+}
+
+
+/**
+  Retrieves, but does not remove, the smallest element of the tree in
+  constant time.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @return pointer to the smallest element
+  @return NULL if the tree is empty
+ */
+void *rbtree_min(rbtree_t *t)
+{
+	return (t->m_leftmost != NULL ? t->m_leftmost->value : NULL);
+}
+
+
+static void transplant(rbtree_t *t, rbnode_t *u, rbnode_t *v)
+{
+	if (u->parent == NULL)
+		t->m_root = v;
+	else if (u == u->parent->left)
+		u->parent->left = v;
+	else
+		u->parent->right = v;
+
+	if (v != NULL)
+		v->parent = u->parent;
+}
+
+
+static void erase(rbtree_t *t, rbnode_t *z)
+{
+	rbnode_t *y = z;
+	rbnode_t *x, *x_parent;
+	int removed_red = y->red;
+
+	// The leftmost node has no left child, so the next smallest is either
+	// the smallest of its right subtree or its parent.
+	if (t->m_leftmost == z)
+		t->m_leftmost = (z->right != NULL ? minimum(z->right) : z->parent);
+
+	if (z->left == NULL)
+	{
+		x = z->right;
+		x_parent = z->parent;
+		transplant(t, z, z->right);
+	}
+	else if (z->right == NULL)
+	{
+		x = z->left;
+		x_parent = z->parent;
+		transplant(t, z, z->left);
+	}
+	else
+	{
+		y = minimum(z->right);
+		removed_red = y->red;
+		x = y->right;
+
+		if (y->parent == z)
+			x_parent = y;
+		else
+		{
+			x_parent = y->parent;
+			transplant(t, y, y->right);
+			y->right = z->right;
+			y->right->parent = y;
+		}
+
+		transplant(t, z, y);
+		y->left = z->left;
+		y->left->parent = y;
+		y->red = z->red;
+	}
+
+	free(z);
+	t->m_size--;
+
+	if (removed_red)
+		return;
+
+	while (x != t->m_root && !is_red(x))
+	{
+		if (x == x_parent->left)
+		{
+			rbnode_t *w = x_parent->right;
+
+			if (is_red(w))
+			{
+				w->red = 0;
+				x_parent->red = 1;
+				rotate_left(t, x_parent);
+				w = x_parent->right;
+			}
+			if (!is_red(w->left) && !is_red(w->right))
+			{
+				w->red = 1;
+				x = x_parent;
+				x_parent = x->parent;
+			}
+			else
+			{
+				if (!is_red(w->right))
+				{
+					w->left->red = 0;
+					w->red = 1;
+					rotate_right(t, w);
+					w = x_parent->right;
+				}
+				w->red = x_parent->red;
+				x_parent->red = 0;
+				w->right->red = 0;
+				rotate_left(t, x_parent);
+				x = t->m_root;
+			}
+		}
+		else
+		{
+			rbnode_t *w = x_parent->left;
+
+			if (is_red(w))
+			{
+				w->red = 0;
+				x_parent->red = 1;
+				rotate_right(t, x_parent);
+				w = x_parent->left;
+			}
+			if (!is_red(w->left) && !is_red(w->right))
+			{
+				w->red = 1;
+				x = x_parent;
+				x_parent = x->parent;
+			}
+			else
+			{
+				if (!is_red(w->left))
+				{
+					w->right->red = 0;
+					w->red = 1;
+					rotate_left(t, w);
+					w = x_parent->left;
+				}
+				w->red = x_parent->red;
+				x_parent->red = 0;
+				w->left->red = 0;
+				rotate_right(t, x_parent);
+				x = t->m_root;
+			}
+		}
+	}
+
+	if (x != NULL)
+		x->red = 0;
+}
+
+
+/**
+  Retrieves and removes the smallest element of the tree in O(log n).
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @return the smallest element
+  @return NULL if the tree is empty
+ */
+void *rbtree_poll(rbtree_t *t)
+{
+	if (t->m_leftmost == NULL)
+		return NULL;
+
+	void *value = t->m_leftmost->value;
+	erase(t, t->m_leftmost);
+	return value;
+}
+
+
+/**
+  Removes one element of the tree that the comparer considers equal to ptr,
+  in O(log n).
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @param ptr address of element to be removed
+  @return the number of elements removed from the tree, 0 or 1
+ */
+int rbtree_remove(rbtree_t *t, void *ptr)
+{
+	rbnode_t *node = t->m_root;
+
+	while (node != NULL)
+	{
+		int c = t->comparer(ptr, node->value);
+
+		if (c == 0)
+		{
+			erase(t, node);
+			return 1;
+		}
+		node = (c < 0 ? node->left : node->right);
+	}
+
+	return 0;
+}
+
+
+/**
+  Returns the number of elements in the tree.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @return the number of elements in the tree
+ */
+int rbtree_size(rbtree_t *t)
+{
+	return t->m_size;
+}
+
+
+/**
+  Returns the node of the smallest element, to walk the tree in order with
+  rbtree_next(). The tree must not be changed during the walk.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+  @return the node of the smallest element
+  @return NULL if the tree is empty
+ */
+rbnode_t *rbtree_first(rbtree_t *t)
+{
+	return t->m_leftmost;
+}
+
+
+/**
+  Returns the node that follows node in order, in amortized constant time.
+
+  @param node a node of the tree
+  @return the next node
+  @return NULL if node holds the largest element
+ */
+rbnode_t *rbtree_next(rbnode_t *node)
+{
+	if (node->right != NULL)
+		return minimum(node->right);
+
+	while (node->parent != NULL && node == node->parent->right)
+		node = node->parent;
+	return node->parent;
+}
+
+
+/**
+  Destroys and frees all the memory associated with t. The elements
+  themselves are not freed.
+
+  @param t a pointer to an instance of the rbtree_t data structure
+ */
+void rbtree_destroy(rbtree_t *t)
+{
+	rbnode_t *node = t->m_root;
+
+	// Walk down to a leaf, free it and climb back up, so that no stack
+	// proportional to the size of the tree is needed.
+	while (node != NULL)
+	{
+		if (node->left != NULL)
+			node = node->left;
+		else if (node->right != NULL)
+			node = node->right;
+		else
+		{
+			rbnode_t *parent = node->parent;
+
+			if (parent != NULL)
+			{
+				if (parent->left == node)
+					parent->left = NULL;
+				else
+					parent->right = NULL;
+			}
+			free(node);
+			node = parent;
+		}
+	}
+
+	rbtree_init(t, t->comparer);
+}
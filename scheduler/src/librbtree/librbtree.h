@@ -0,0 +1,45 @@
+/** @file librbtree.h
+ */
+
+#ifndef LIBRBTREE_H_
+#define LIBRBTREE_H_
+
+/**
+  Red-black tree node
+*/
+typedef struct rbnode_t
+{
+  void* value;
+  struct rbnode_t* left;
+  struct rbnode_t* right;
+  struct rbnode_t* parent;
+  int red;
+} rbnode_t;
+
+/**
+  Red-black tree Data Structure. Elements are kept in the order defined by
+  the comparer, with the smallest element cached so that it can be read in
+  constant time.
+*/
+typedef struct _rbtree_t
+{
+  rbnode_t* m_root;
+  rbnode_t* m_leftmost;
+  int m_size;
+  int (*comparer)(const void *a, const void *b);
+} rbtree_t;
+
+void   rbtree_init   (rbtree_t *t, int(*comparer)(const void *, const void *));
+
+void   rbtree_insert (rbtree_t *t, void *ptr);
+void * rbtree_min    (rbtree_t *t);
+void * rbtree_poll   (rbtree_t *t);
+int    rbtree_remove (rbtree_t *t, void *ptr);
+int    rbtree_size   (rbtree_t *t);
+
+rbnode_t * rbtree_first(rbtree_t *t);
+rbnode_t * rbtree_next (rbnode_t *node);
+
+void   rbtree_destroy(rbtree_t *t);
+
+#endif /* LIBRBTREE_H_ */
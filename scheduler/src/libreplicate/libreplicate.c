@@ -0,0 +1,372 @@
+/** @file libreplicate.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "libreplicate.h"
+
+/* The 97.5th percentile of the standard normal distribution */
+#define Z_975 1.959963984540054
+
+/* The 97.5th percentile of Student's t distribution, by degrees of freedom up to 30 */
+static const double t_975[] =
+{
+	0, 12.7062, 4.3027, 3.1824, 2.7764, 2.5706, 2.4469, 2.3646, 2.3060, 2.2622, 2.2281,
+	2.2010, 2.1788, 2.1604, 2.1448, 2.1314, 2.1199, 2.1098, 2.1009, 2.0930, 2.0860,
+	2.0796, 2.0739, 2.0687, 2.0639, 2.0595, 2.0555, 2.0518, 2.0484, 2.0452, 2.0423
+};
+
+typedef struct _replicate_task_t
+{
+	int config;
+	int index;
+} replicate_task_t;
+
+/**
+  Stores the state of an experiment, shared by its threads.
+*/
+typedef struct _replicate_t
+{
+	const replicate_experiment_t *experiment;
+	const replicate_config_t *configs;
+
+	double *values;   ///< Metric m of replication i of configuration c at ((c * REPLICATE_METRICS) + m) * max_replications + i
+
+	replicate_task_t *tasks;
+	int tasks_ct;
+	atomic_int next;
+	atomic_int failed;
+} replicate_t;
+
+
+/**
+  Fills in the default experiment: the default workload of 1000 jobs on a
+  single core, between 5 and 30 replications added 5 at a time, all 30
+  run, on a single thread.
+
+  @param experiment the experiment to fill in
+ */
+void replicate_experiment_init(replicate_experiment_t *experiment)
+{
+	memset(experiment, 0, sizeof(*experiment));
+
+	workload_config_init(&experiment->workload);
+	experiment->workload.jobs = 1000;
+	experiment->cores = 1;
+	experiment->min_replications = 5;
+	experiment->max_replications = 30;
+	experiment->batch = 5;
+	experiment->precision = 0.0;
+	experiment->threads = 1;
+}
+
+
+/**
+  Returns the name of a metric, as the simulator's summary puts it.
+
+  @param metric the metric
+ */
+const char *replicate_metric_name(replicate_metric_t metric)
+{
+	switch (metric)
+	{
+		case REPLICATE_MEAN_WAITING: return "Average Waiting Time";
+		case REPLICATE_MEAN_TURNAROUND: return "Average Turnaround Time";
+		case REPLICATE_P99_TURNAROUND: return "99th Percentile Turnaround Time";
+		case REPLICATE_MEAN_RESPONSE: return "Average Response Time";
+		case REPLICATE_P50_RESPONSE: return "Median Response Time";
+		case REPLICATE_P95_RESPONSE: return "95th Percentile Response Time";
+		case REPLICATE_P99_RESPONSE: return "99th Percentile Response Time";
+	}
+	return "";
+}
+
+
+/**
+  Returns the 97.5th percentile of Student's t distribution, which a 95%
+  confidence interval of a mean is that many standard errors either side
+  of. Past 30 degrees of freedom it is the Cornish-Fisher expansion about
+  the normal, good to four decimal places.
+
+  @param df the degrees of freedom, at least 1
+ */
+double replicate_t_quantile(int df)
+{
+	if (df < 1)
+		return INFINITY;
+	if (df <= 30)
+		return t_975[df];
+
+	double z = Z_975, z3 = z * z * z, z5 = z3 * z * z, z7 = z5 * z * z;
+	double n = df;
+	return z + (z3 + z) / (4 * n) + (5 * z5 + 16 * z3 + 3 * z) / (96 * n * n)
+			+ (3 * z7 + 19 * z5 + 17 * z3 - 15 * z) / (384 * n * n * n);
+}
+
+
+/**
+  Summarizes the values a metric took over some replications: their mean,
+  range, and the 95% confidence interval of the mean from the sample
+  standard deviation and Student's t distribution.
+
+  @param values the values, one per replication
+  @param count the number of replications, at least 1
+  @param stat receives the summary
+ */
+void replicate_summarize(const double *values, int count, replicate_stat_t *stat)
+{
+	double sum = 0, squares = 0;
+
+	stat->min = stat->max = values[0];
+	for (int i = 0; i < count; i++)
+	{
+		sum += values[i];
+		if (values[i] < stat->min)
+			stat->min = values[i];
+		if (values[i] > stat->max)
+			stat->max = values[i];
+	}
+	stat->mean = sum / count;
+
+	for (int i = 0; i < count; i++)
+		squares += (values[i] - stat->mean) * (values[i] - stat->mean);
+
+	if (count < 2)
+		stat->half_width = INFINITY;
+	else
+		stat->half_width = replicate_t_quantile(count - 1) * sqrt(squares / (count - 1) / count);
+}
+
+
+static int compare_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+ * The nearest rank percentile of sorted times, as for tardiness.
+ */
+static double percentile(const int *sorted, int count, double p)
+{
+	int rank = (int)ceil(p * count);
+	return sorted[(rank < 1 ? 1 : rank) - 1];
+}
+
+
+/*
+ * Generates the workload of a replication and simulates a configuration
+ * on it, storing what it measured. Every configuration sees the same
+ * workloads, so that the differences between them are not lost in the
+ * differences between workloads. Returns 0, or -1 if the simulation
+ * failed.
+ */
+static int run_replication(replicate_t *r, int config, int index)
+{
+	const replicate_experiment_t *e = r->experiment;
+	const replicate_config_t *c = &r->configs[config];
+	workload_config_t wc = e->workload;
+	workload_t workload;
+	workload_job_t generated;
+	int count = (int)e->workload.jobs;
+	int status = -1;
+
+	wc.seed += index;
+	int *response = malloc(count * sizeof(int));
+	int *turnaround = malloc(count * sizeof(int));
+	simulator_t *sim = simulator_create(e->cores, c->scheme, &c->options);
+
+	if (sim == NULL || response == NULL || turnaround == NULL || workload_init(&workload, &wc) != 0)
+		goto done;
+
+	while (workload_next(&workload, &generated))
+	{
+		simulator_job_t job = { generated.arrival_time, generated.run_time, generated.priority, 0, 0, 1, NULL };
+
+		if (simulator_add_job(sim, &job) < 0)
+			goto done;
+	}
+
+	for (int i = 0; i < count; i++)
+		response[i] = turnaround[i] = -1;
+	simulator_record_jobs(sim, response, turnaround);
+	if (simulator_run(sim) != 0)
+		goto done;
+
+	// Jobs an admission policy rejected have no times, and are left out.
+	long long response_sum = 0, turnaround_sum = 0;
+	int finished = 0;
+	for (int i = 0; i < count; i++)
+	{
+		if (turnaround[i] >= 0)
+		{
+			response[finished] = response[i];
+			turnaround[finished] = turnaround[i];
+			response_sum += response[i];
+			turnaround_sum += turnaround[i];
+			finished++;
+		}
+	}
+	if (finished == 0)
+		goto done;
+	qsort(response, finished, sizeof(int), compare_int);
+	qsort(turnaround, finished, sizeof(int), compare_int);
+
+	double *values = r->values + (size_t)config * REPLICATE_METRICS * e->max_replications + index;
+	values[REPLICATE_MEAN_WAITING * e->max_replications] = scheduler_average_waiting_time_r(simulator_scheduler(sim));
+	values[REPLICATE_MEAN_TURNAROUND * e->max_replications] = turnaround_sum / (double)finished;
+	values[REPLICATE_P99_TURNAROUND * e->max_replications] = percentile(turnaround, finished, 0.99);
+	values[REPLICATE_MEAN_RESPONSE * e->max_replications] = response_sum / (double)finished;
+	values[REPLICATE_P50_RESPONSE * e->max_replications] = percentile(response, finished, 0.50);
+	values[REPLICATE_P95_RESPONSE * e->max_replications] = percentile(response, finished, 0.95);
+	values[REPLICATE_P99_RESPONSE * e->max_replications] = percentile(response, finished, 0.99);
+	status = 0;
+
+done:
+	if (sim != NULL)
+		simulator_destroy(sim);
+	free(response);
+	free(turnaround);
+	return status;
+}
+
+
+static void *worker(void *arg)
+{
+	replicate_t *r = arg;
+	int i;
+
+	while ((i = atomic_fetch_add(&r->next, 1)) < r->tasks_ct && !atomic_load(&r->failed))
+		if (run_replication(r, r->tasks[i].config, r->tasks[i].index) != 0)
+			atomic_store(&r->failed, 1);
+	return NULL;
+}
+
+
+/*
+ * Runs the tasks on up to the given number of threads, the calling thread
+ * among them, and waits for all of them.
+ */
+static void run_tasks(replicate_t *r, int threads)
+{
+	if (threads > r->tasks_ct)
+		threads = r->tasks_ct;
+
+	pthread_t ids[threads > 1 ? threads - 1 : 1];
+	int started = 0;
+
+	atomic_store(&r->next, 0);
+	for (int i = 0; i < threads - 1; i++)
+		if (pthread_create(&ids[started], NULL, worker, r) == 0)
+			started++;
+
+	worker(r);
+	for (int i = 0; i < started; i++)
+		pthread_join(ids[i], NULL);
+}
+
+
+/**
+  Runs seeded replications of a synthetic workload under each of a set of
+  configurations, and summarizes every metric over them with a 95%
+  confidence interval of its mean.
+
+  Each configuration first runs the minimum number of replications. While
+  the interval of any of its metrics is wider than the precision, relative
+  to the metric's mean, it runs another batch, up to the maximum; with a
+  precision of 0 it runs the maximum outright. Replication i of every
+  configuration simulates the same workload, seeded with the experiment's
+  seed plus i. The replications of a round run in parallel, each in a
+  simulation of its own, and the intervals are only looked at between
+  rounds, so the outcome does not depend on the number of threads.
+
+  @param experiment the workload, cores, stopping rule and threads
+  @param configs the configurations
+  @param configs_ct the number of configurations
+  @param results receives the outcome for each configuration, in the same order
+  @return 0 on success
+  @return -1 if the experiment is invalid, memory ran out or a scheduler
+  made an invalid decision
+ */
+int replicate_run(const replicate_experiment_t *experiment, const replicate_config_t *configs,
+		int configs_ct, replicate_result_t *results)
+{
+	const replicate_experiment_t *e = experiment;
+	replicate_t r;
+	workload_t check;
+	int c;
+
+	if (configs_ct < 1 || e->cores < 1 || e->min_replications < 1 || e->max_replications < e->min_replications ||
+			e->batch < 1 || e->precision < 0 || e->workload.jobs < 1 || e->workload.jobs > INT_MAX ||
+			workload_init(&check, &e->workload) != 0)
+		return -1;
+
+	memset(&r, 0, sizeof(r));
+	r.experiment = e;
+	r.configs = configs;
+	r.values = malloc((size_t)configs_ct * REPLICATE_METRICS * e->max_replications * sizeof(double));
+	r.tasks = malloc((size_t)configs_ct * e->max_replications * sizeof(replicate_task_t));
+	char *active = malloc(configs_ct);
+	if (r.values == NULL || r.tasks == NULL || active == NULL)
+	{
+		free(r.values);
+		free(r.tasks);
+		free(active);
+		return -1;
+	}
+
+	memset(results, 0, configs_ct * sizeof(replicate_result_t));
+	memset(active, 1, configs_ct);
+
+	int done = 0, active_ct = configs_ct;
+	int target = (e->precision > 0 ? e->min_replications : e->max_replications);
+	while (active_ct > 0 && !r.failed)
+	{
+		r.tasks_ct = 0;
+		for (int i = done; i < target; i++)
+			for (c = 0; c < configs_ct; c++)
+				if (active[c])
+					r.tasks[r.tasks_ct++] = (replicate_task_t){ c, i };
+		run_tasks(&r, e->threads);
+		if (r.failed)
+			break;
+
+		for (c = 0; c < configs_ct; c++)
+		{
+			if (!active[c])
+				continue;
+
+			int converged = (e->precision > 0);
+			for (int m = 0; m < REPLICATE_METRICS; m++)
+			{
+				replicate_stat_t *stat = &results[c].metrics[m];
+
+				replicate_summarize(r.values + ((size_t)c * REPLICATE_METRICS + m) * e->max_replications, target, stat);
+				if (!(stat->half_width <= e->precision * fabs(stat->mean)))
+					converged = 0;
+			}
+			results[c].replications = target;
+			results[c].converged = converged;
+
+			if (converged || target == e->max_replications)
+			{
+				active[c] = 0;
+				active_ct--;
+			}
+		}
+
+		done = target;
+		target = (target + e->batch < e->max_replications ? target + e->batch : e->max_replications);
+	}
+
+	free(r.values);
+	free(r.tasks);
+	free(active);
+	return (r.failed ? -1 : 0);
+}
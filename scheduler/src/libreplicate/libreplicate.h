@@ -0,0 +1,70 @@
+/** @file libreplicate.h
+ */
+
+#ifndef LIBREPLICATE_H_
+#define LIBREPLICATE_H_
+
+#include "../libsimulator/libsimulator.h"
+#include "../libworkload/libworkload.h"
+
+/**
+  What each replication measures, over the jobs of its workload
+*/
+typedef enum {REPLICATE_MEAN_WAITING = 0, REPLICATE_MEAN_TURNAROUND, REPLICATE_P99_TURNAROUND,
+              REPLICATE_MEAN_RESPONSE, REPLICATE_P50_RESPONSE, REPLICATE_P95_RESPONSE,
+              REPLICATE_P99_RESPONSE} replicate_metric_t;
+
+#define REPLICATE_METRICS (REPLICATE_P99_RESPONSE + 1)
+
+/**
+  Parameters of an experiment, shared by every configuration. Fill in with
+  replicate_experiment_init() and then override the fields of interest.
+*/
+typedef struct _replicate_experiment_t
+{
+	workload_config_t workload;   ///< Workload of the first replication; replication i is seeded with seed + i
+	int cores;
+	int min_replications;         ///< Replications run before the intervals are first looked at
+	int max_replications;         ///< Replications never run beyond, R
+	int batch;                    ///< Replications added each time an interval is still too wide
+	double precision;             ///< Target half-width of every interval over its mean, 0 to run all R
+	int threads;
+} replicate_experiment_t;
+
+/**
+  A configuration to replicate: a scheme with its options
+*/
+typedef struct _replicate_config_t
+{
+	scheme_t scheme;
+	scheduler_options_t options;
+} replicate_config_t;
+
+/**
+  A metric over the replications of a configuration
+*/
+typedef struct _replicate_stat_t
+{
+	double mean;         ///< Mean over the replications
+	double half_width;   ///< Half-width of the 95% confidence interval of the mean, infinite for one replication
+	double min, max;
+} replicate_stat_t;
+
+/**
+  The outcome of the replications of a configuration
+*/
+typedef struct _replicate_result_t
+{
+	int replications;
+	int converged;       ///< 1 if every interval got within the precision
+	replicate_stat_t metrics[REPLICATE_METRICS];
+} replicate_result_t;
+
+void        replicate_experiment_init(replicate_experiment_t *experiment);
+const char *replicate_metric_name    (replicate_metric_t metric);
+double      replicate_t_quantile     (int df);
+void        replicate_summarize      (const double *values, int count, replicate_stat_t *stat);
+int         replicate_run            (const replicate_experiment_t *experiment, const replicate_config_t *configs,
+                                      int configs_ct, replicate_result_t *results);
+
+#endif /* LIBREPLICATE_H_ */
@@ -3,10 +3,13 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <stdint.h>
 #include <string.h>
 
 #include "libscheduler.h"
 #include "../libpriqueue/libpriqueue.h"
+#include "../librbtree/librbtree.h"
+#include "../libheap/libheap.h"
 
 
 /**
@@ -23,18 +26,251 @@ typedef struct _job_t
 	int remaining_time;
 	int running_time;
 	int priority;
+	long long aged_priority;
+	int deadline;
+	int level;
+	long long vruntime;
+	int weight;
+	int slot;
+	int queue;
+	int penalty;
+	int last_core;
+	int progress;
+	int core_time;
+	int penalized;
+	int blocked_at;
+	int io_time;
 } job_t;
 
-priqueue_t queue;
-int preemptive;
-int num_cores;
-int total_jobs;
-float curr_time;
-float waiting_time;
-float response_time;
-float turnaround_time;
+/**
+  A run queue, holding the waiting jobs in whichever structure the scheme
+  needs. There is either a single run queue shared by every core, one per
+  core, or one per group when the cores are shared between groups.
+*/
+typedef struct _runqueue_t
+{
+	priqueue_t queue;
+	int size;
+	int cores;
+
+	/* MLFQ: one FIFO per level and a bit per non-empty level */
+	priqueue_t levels[SCHEDULER_MAX_LEVELS];
+	unsigned long long nonempty_levels;
+
+	/* CFS: runnable jobs ordered by virtual runtime, and the load they add up to */
+	rbtree_t tree;
+	long long min_vruntime;
+	long long load_weight;
+	int nr_running;
+
+	/* EDF and STRIDE: waiting jobs in a heap by deadline or pass */
+	heap_t heap;
+
+	/*
+	 * LOTTERY: a slot per waiting job, the free slots, and a Fenwick tree
+	 * over the tickets of the slots, so that drawing a ticket and finding
+	 * whose it is costs O(log n).
+	 */
+	job_t **slots;
+	long long *fenwick;
+	int *free_slots;
+	int free_count;
+	int slots_used;
+	int slot_capacity;
+	long long tickets;
+} runqueue_t;
+
+/**
+  A group of jobs that shares the cores with the other groups in proportion
+  to its weight. Its virtual time is the CPU time its jobs had, divided by
+  the weight, and the group with waiting jobs that is furthest behind runs
+  next. The statistics of its finished jobs are kept apart from the rest.
+*/
+typedef struct _group_t
+{
+	int weight;
+	long long vtime;
+	int alive;
+	int jobs;
+	float waiting_time;
+	float response_time;
+	float turnaround_time;
+	long long cpu_time;
+} group_t;
+
+/**
+  The token bucket of one priority class. Its level is kept in time units,
+  admission_rate of them to a token, so that it fills by one every time
+  unit up to admission_limit tokens.
+*/
+typedef struct _bucket_t
+{
+	int priority;
+	int updated;
+	long long level;
+} bucket_t;
+
+/**
+  Stores the complete state of one scheduler instance.
+*/
+struct _scheduler_t
+{
+	scheme_t scheme;
+	scheduler_options_t options;
+	Comparer comparer;
+
+	runqueue_t *queues;
+	int num_queues;
+	int preemptive;
+	int num_cores;
+	int total_jobs;
+	float curr_time;
+
+	/* Jobs finished, running on a core and blocked on I/O, kept up as they change */
+	int finished_jobs;
+	int running_jobs;
+	int blocked_jobs;
+
+	float waiting_time;
+	float response_time;
+	float turnaround_time;
+	int max_waiting_time;
+
+	/* Time the first job arrived, and the time units the cores spent running jobs */
+	int first_arrival;
+	long long busy_time;
+
+	/* Jobs blocked on I/O, by job number */
+	job_t** blocked;
+	int blocked_size;
+
+	job_t** active_cores;
+	unsigned long long *idle_cores;
+
+	/* LOTTERY: state of the splitmix64 generator the tickets are drawn with */
+	uint64_t rng;
+
+	/*
+	 * Core speeds, and the cores ranked fastest first with a bitmap of the
+	 * idle ones by rank, so that the fastest and slowest idle cores are the
+	 * lowest and highest bits set. Running sums of the running times and
+	 * priorities of every job so far tell short and urgent jobs apart.
+	 */
+	int *speeds;
+	int *core_rank;
+	int *rank_core;
+	unsigned long long *idle_ranked;
+	long long total_running_time;
+	long long total_priority;
+
+	/* Jobs that had a deadline, how many missed it, and by how much each finished late */
+	int deadline_jobs;
+	int deadline_misses;
+	int *tardiness;
+	int tardiness_size;
+	int tardiness_sorted;
+
+	/* MLFQ: time of the next priority boost */
+	int next_boost;
+
+	/* Per-core queues: migration cost not yet reported per core, and totals */
+	int *migration_cost;
+	int steals;
+	int migrations;
+
+	/* Resumes on a core other than the last one, and all time lost to moving */
+	int cache_misses;
+	int penalty_time;
 
-job_t** active_cores;
+	/*
+	 * Per-core queues: tournament trees over the queues, stored as heaps with
+	 * the queues at the leaves. The roots are the least loaded and the
+	 * busiest queue, and a change to one queue costs O(log cores).
+	 */
+	int balance_leaves;
+	int *least_loaded;
+	int *busiest;
+
+	/*
+	 * Groups: one per run queue, and a tournament tree over them like the
+	 * ones above whose root is the group with waiting jobs that is furthest
+	 * behind its share. A group that had no jobs starts again no further
+	 * behind than that group was when a core last took a job, so that it
+	 * can not hoard the cores to make up for the time it had nothing to run.
+	 */
+	group_t *groups;
+	int *neediest;
+	long long min_group_vtime;
+
+	/*
+	 * Admission: the work left on the runnable jobs as far as the scheduler
+	 * knows it, the jobs turned away and the times jobs were deferred, the
+	 * time admitted jobs spent deferred, and a token bucket per priority
+	 * class, by priority.
+	 */
+	long long backlog_work;
+	int rejected_jobs;
+	int deferrals;
+	long long admission_delay;
+	bucket_t *buckets;
+	int buckets_ct;
+};
+
+/**
+  CFS: the weight of each nice value from -20 to 19, as used by Linux. Each
+  step of nice is worth about 10% of CPU time, and nice 0 weighs
+  CFS_NICE_0_LOAD.
+*/
+#define CFS_NICE_0_LOAD 1024
+
+static const int cfs_weights[40] = {
+	88761, 71755, 56483, 46273, 36291,
+	29154, 23254, 18705, 14949, 11916,
+	 9548,  7620,  6100,  4904,  3906,
+	 3121,  2501,  1991,  1586,  1277,
+	 1024,   820,   655,   526,   423,
+	  335,   272,   215,   172,   137,
+	  110,    87,    70,    56,    45,
+	   36,    29,    23,    18,    15,
+};
+
+/**
+  The instance driven by the scheduler_*() functions that take no instance.
+*/
+static scheduler_t *default_scheduler;
+
+static void update_remaining_time(scheduler_t *s, int time);
+static void runqueue_init(scheduler_t *s, runqueue_t *rq, int cores);
+static runqueue_t *core_queue(scheduler_t *s, int core_id);
+static int home_queue(scheduler_t *s, job_t *job, int core_id);
+static int least_loaded_queue(scheduler_t *s, job_t *job);
+static void update_balance(scheduler_t *s, int queue);
+static void play_match(scheduler_t *s, int n);
+static void join_queue(scheduler_t *s, job_t *job, int queue);
+static int place_job(scheduler_t *s, job_t *job, int time);
+static int take_next(scheduler_t *s, int core_id, int time);
+static void dispatch(scheduler_t *s, int core_id, job_t *job, int time);
+static void set_idle(scheduler_t *s, int core_id, int idle);
+static int compare_speed(const void *a, const void *b);
+static int compare_int(const void *a, const void *b);
+static int uses_heap(scheduler_t *s);
+static void lottery_add(runqueue_t *rq, job_t *job);
+static job_t *lottery_draw(scheduler_t *s, runqueue_t *rq);
+static void fenwick_add(runqueue_t *rq, int slot, long long tickets);
+static int pick_idle_core(scheduler_t *s, job_t *job);
+static job_t *pick_next(scheduler_t *s, runqueue_t *rq, int core_id);
+static void steal(scheduler_t *s, int core_id);
+static void enqueue(scheduler_t *s, job_t *job);
+static job_t *dequeue(scheduler_t *s, runqueue_t *rq);
+static int queue_empty(runqueue_t *rq);
+static void boost_levels(scheduler_t *s, int time);
+static int cfs_slice(scheduler_t *s, runqueue_t *rq, job_t *job);
+static int admit(scheduler_t *s, int time, int running_time, int priority);
+static int take_token(scheduler_t *s, int time, int priority);
+static void show_jobs(priqueue_t *q, FILE *out);
+static void show_tree(rbnode_t *node, FILE *out);
+static void show_heap(heap_t *h, FILE *out);
+static void show_slots(runqueue_t *rq, FILE *out);
 
 int fcfs(const void *a, const void *b);
 int sjf(const void *a, const void *b);
@@ -42,6 +278,10 @@ int psjf(const void *a, const void *b);
 int pri(const void *a, const void *b);
 int ppri(const void *a, const void *b);
 int rr(const void *a, const void *b);
+int mlfq(const void *a, const void *b);
+int cfs(const void *a, const void *b);
+int edf(const void *a, const void *b);
+int aged(const void *a, const void *b);
 /**
   Initalizes the scheduler.
 
@@ -52,60 +292,283 @@ int rr(const void *a, const void *b);
     - You may assume that scheme is a valid scheduling scheme.
 
   @param cores the number of cores that is available by the scheduler. These cores will be known as core(id=0), core(id=1), ..., core(id=cores-1).
-  @param scheme  the scheduling scheme that should be used. This value will be one of the six enum values of scheme_t
+  @param scheme  the scheduling scheme that should be used. This value will be one of the values of scheme_t
 */
 
 void scheduler_start_up(int cores, scheme_t scheme)
 {
-	num_cores = cores;
-	total_jobs = 0;
-	waiting_time = 0.0;
-	turnaround_time = 0.0;
-	response_time = 0.0;
-	curr_time = 0.0;
+	default_scheduler = scheduler_create(cores, scheme, NULL);
+}
+
+
+/**
+  Fills in the default options: no RR quantum, three MLFQ levels with
+  quanta of 2, 4 and 8 and a priority boost every 100 time units, and a CFS
+  target latency of 24 time units with slices of at least 3, and a lottery
+  seed of 1. Priorities do not age. All cores share one run queue, run at
+  nominal speed, and moving between cores costs nothing. A new job goes to
+  the lowest idle core. Jobs are not grouped. Every job is admitted.
+
+  @param options the options to initialize
+*/
+void scheduler_options_init(scheduler_options_t *options)
+{
+	memset(options, 0, sizeof(*options));
+
+	options->quantum = 0;
+	options->seed = 1;
+	options->levels = 3;
+	options->level_quantum[0] = 2;
+	options->level_quantum[1] = 4;
+	options->level_quantum[2] = 8;
+	options->boost = 100;
+	options->aging = 0;
+	options->latency = 24;
+	options->min_granularity = 3;
+	options->per_core_queues = 0;
+	options->migration_cost = 0;
+	options->cache_penalty = 0;
+	options->affinity = 0;
+	options->speeds = NULL;
+	options->placement = PLACE_LOWEST;
+	options->groups = 0;
+	options->group_weights = NULL;
+	options->admission = ADMIT_ALL;
+	options->admission_limit = 0;
+	options->admission_rate = 0;
+	options->admission_defer = 0;
+}
+
+
+/**
+  Fills in the default job attributes: no deadline, the first group, and
+  arriving now.
+
+  @param attr the attributes to initialize
+*/
+void scheduler_job_attr_init(scheduler_job_attr_t *attr)
+{
+	memset(attr, 0, sizeof(*attr));
+
+	attr->deadline = 0;
+	attr->group = 0;
+	attr->arrival_time = -1;
+}
+
+
+/**
+  Creates an independent scheduler instance. This is the reentrant form of
+  scheduler_start_up(); the instance must be released with
+  scheduler_destroy().
+
+  @param cores the number of cores that is available by the scheduler.
+  @param scheme the scheduling scheme that should be used.
+  @param options parameters of the scheme, or NULL for the defaults
+  @return the new scheduler instance
+*/
+scheduler_t *scheduler_create(int cores, scheme_t scheme, const scheduler_options_t *options)
+{
+	scheduler_t *s = malloc(sizeof(scheduler_t));
+
+	s->scheme = scheme;
+	if (options != NULL){
+		s->options = *options;
+	}
+	else{
+		scheduler_options_init(&s->options);
+	}
+
+	s->num_cores = cores;
+	s->total_jobs = 0;
+	s->finished_jobs = 0;
+	s->running_jobs = 0;
+	s->blocked_jobs = 0;
+	s->waiting_time = 0.0;
+	s->turnaround_time = 0.0;
+	s->response_time = 0.0;
+	s->curr_time = 0.0;
+	s->max_waiting_time = 0;
+	s->first_arrival = -1;
+	s->busy_time = 0;
+	s->blocked = NULL;
+	s->blocked_size = 0;
+
+	s->active_cores = calloc(cores, sizeof(job_t*));
+	s->rng = s->options.seed;
+	s->idle_cores = malloc((cores + 63) / 64 * sizeof(unsigned long long));
+	for (int i = 0; i < cores; i += 64){
+		s->idle_cores[i / 64] = (cores - i >= 64 ? ~0ULL : (1ULL << (cores - i)) - 1);
+	}
+	s->idle_ranked = malloc((cores + 63) / 64 * sizeof(unsigned long long));
+	memcpy(s->idle_ranked, s->idle_cores, (cores + 63) / 64 * sizeof(unsigned long long));
 
-	active_cores = malloc(sizeof(job_t) * cores);
-	for (int i = 0; i < num_cores; i++){
-		active_cores[i] = 0;
+	s->speeds = malloc(cores * sizeof(int));
+	s->rank_core = malloc(cores * sizeof(int));
+	s->core_rank = malloc(cores * sizeof(int));
+	int fastest = 0;
+	for (int i = 0; i < cores; i++){
+		s->speeds[i] = (s->options.speeds != NULL ? s->options.speeds[i] : SCHEDULER_SPEED_UNIT);
+		if (s->speeds[i] > fastest){
+			fastest = s->speeds[i];
+		}
+	}
+	s->options.speeds = s->speeds;
+
+	// Ranks by how much slower than the fastest core, then by id, in one key.
+	long long *keys = malloc(cores * sizeof(long long));
+	for (int i = 0; i < cores; i++){
+		keys[i] = (long long)(fastest - s->speeds[i]) * cores + i;
+	}
+	qsort(keys, cores, sizeof(long long), compare_speed);
+	for (int i = 0; i < cores; i++){
+		s->rank_core[i] = keys[i] % cores;
+		s->core_rank[s->rank_core[i]] = i;
 	}
+	free(keys);
+	s->total_running_time = 0;
+	s->total_priority = 0;
+	s->deadline_jobs = 0;
+	s->deadline_misses = 0;
+	s->tardiness = NULL;
+	s->tardiness_size = 0;
+	s->tardiness_sorted = 1;
+
+	s->migration_cost = calloc(cores, sizeof(int));
+	s->steals = 0;
+	s->migrations = 0;
+	s->cache_misses = 0;
+	s->penalty_time = 0;
+	s->backlog_work = 0;
+	s->rejected_jobs = 0;
+	s->deferrals = 0;
+	s->admission_delay = 0;
+	s->buckets = NULL;
+	s->buckets_ct = 0;
 
 	switch(scheme){
 		case FCFS:
-			priqueue_init(&queue,fcfs);
-			preemptive = 0;
+			s->comparer = fcfs;
+			s->preemptive = 0;
 			break;
 		case SJF:
-			priqueue_init(&queue,sjf);
-			preemptive = 0;
+			s->comparer = sjf;
+			s->preemptive = 0;
 			break;
 		case PSJF:
-			priqueue_init(&queue,psjf);
-			preemptive = 1;
+			s->comparer = psjf;
+			s->preemptive = 1;
 			break;
 		case PRI:
-			priqueue_init(&queue,pri);
-			preemptive = 0;
+			s->comparer = pri;
+			s->preemptive = 0;
 			break;
 		case PPRI:
-			priqueue_init(&queue,ppri);
-			preemptive = 1;
+			s->comparer = ppri;
+			s->preemptive = 1;
 			break;
 		case RR:
-			priqueue_init(&queue,rr);
-			preemptive = 0;
+			s->comparer = rr;
+			s->preemptive = 0;
+			break;
+		case MLFQ:
+			s->comparer = mlfq;
+			s->preemptive = 1;
+			s->next_boost = s->options.boost;
+			break;
+		case CFS:
+			s->comparer = cfs;
+			s->preemptive = 0;
+			break;
+		case EDF:
+			s->comparer = edf;
+			s->preemptive = 0;
 			break;
+		case PEDF:
+			s->comparer = edf;
+			s->preemptive = 1;
+			break;
+		case STRIDE:
+			// The pass is kept where CFS keeps virtual runtime, and ordered alike.
+			s->comparer = cfs;
+			s->preemptive = 0;
+			break;
+		case LOTTERY:
+			s->comparer = rr;
+			s->preemptive = 0;
+			break;
+	}
+
+	if ((scheme == PRI || scheme == PPRI) && s->options.aging > 0){
+		s->comparer = aged;
+	}
+
+	// Every core serves every group, so groups take the place of per-core queues.
+	s->groups = NULL;
+	s->min_group_vtime = 0;
+	if (s->options.groups > 0){
+		s->groups = calloc(s->options.groups, sizeof(group_t));
+		for (int i = 0; i < s->options.groups; i++){
+			int weight = (s->options.group_weights != NULL ? s->options.group_weights[i] : 1);
+			s->groups[i].weight = (weight > 0 ? weight : 1);
+		}
+		s->options.group_weights = NULL;
+		s->options.per_core_queues = 0;
+	}
+
+	s->num_queues = (s->groups != NULL ? s->options.groups : (s->options.per_core_queues ? cores : 1));
+	s->queues = malloc(s->num_queues * sizeof(runqueue_t));
+	for (int i = 0; i < s->num_queues; i++){
+		runqueue_init(s, &s->queues[i], (s->groups != NULL ? cores : cores / s->num_queues));
+	}
+
+	s->least_loaded = NULL;
+	s->busiest = NULL;
+	s->neediest = NULL;
+	if (s->num_queues > 1){
+		s->balance_leaves = 1;
+		while (s->balance_leaves < s->num_queues){
+			s->balance_leaves *= 2;
+		}
+		if (s->groups != NULL){
+			s->neediest = malloc(2 * s->balance_leaves * sizeof(int));
+			for (int i = 0; i < s->balance_leaves; i++){
+				s->neediest[s->balance_leaves + i] = (i < s->num_queues ? i : -1);
+			}
+		}
+		else{
+			s->least_loaded = malloc(2 * s->balance_leaves * sizeof(int));
+			s->busiest = malloc(2 * s->balance_leaves * sizeof(int));
+			for (int i = 0; i < s->balance_leaves; i++){
+				s->least_loaded[s->balance_leaves + i] = (i < s->num_queues ? i : -1);
+				s->busiest[s->balance_leaves + i] = (i < s->num_queues ? i : -1);
+			}
+		}
+		for (int n = s->balance_leaves - 1; n > 0; n--){
+			play_match(s, n);
+		}
 	}
+
+	return s;
 }
 
 /**
   Called when a new job arrives.
 
   If multiple cores are idle, the job should be assigned to the core with the
-  lowest id.
+  lowest id, unless the placement option prefers fast cores: then it goes to
+  the fastest idle core, or, when only short or urgent jobs are to run on
+  fast cores, a job that is longer or less urgent than the average job so
+  far goes to the slowest idle core. With per-core run queues, a job that
+  can not run right away waits on the queue with the fewest jobs. When the
+  cores are shared between groups, a job only preempts jobs of its own
+  group, and waits on its group's queue.
   If the job arriving should be scheduled to run during the next
   time cycle, return the zero-based index of the core the job should be
   scheduled on. If another job is already running on the core specified,
   this will preempt the currently running job.
+  Under an admission policy, a job that is not admitted is rejected, and
+  the scheduler forgets it, or deferred, in which case the caller holds it
+  and offers it again later, as scheduler_new_job_attr_r() describes.
   Assumptions:
     - You may assume that every job wil have a unique arrival time.
 
@@ -115,59 +578,264 @@ void scheduler_start_up(int cores, scheme_t scheme)
   @param priority the priority of the job. (The lower the value, the higher the priority.)
   @return index of core job should be scheduled on
   @return -1 if no scheduling changes should be made.
+  @return SCHEDULER_REJECTED if the job was not admitted and is dropped
+  @return SCHEDULER_DEFERRED if the job was not admitted yet
  */
 int scheduler_new_job(int job_number, int time, int running_time, int priority)
 {
-	update_remaining_time(time);
+	return scheduler_new_job_r(default_scheduler, job_number, time, running_time, priority);
+}
+
+/**
+  Reentrant form of scheduler_new_job().
+
+  @param s the scheduler instance
+ */
+int scheduler_new_job_r(scheduler_t *s, int job_number, int time, int running_time, int priority)
+{
+	return scheduler_new_job_attr_r(s, job_number, time, running_time, priority, NULL);
+}
+
+/**
+  Form of scheduler_new_job_r() for jobs with further attributes. A job
+  with a deadline should finish by then: EDF schemes run the job with the
+  earliest deadline first, and jobs without one after all others, and every
+  scheme counts the deadlines missed. When the cores are shared between
+  groups, the job joins its group; a group the scheduler was not created
+  with counts as the first. A deferred job offered again keeps the time it
+  first arrived, so that the time it was deferred counts towards its
+  waiting, response and turnaround times.
+
+  @param s the scheduler instance
+  @param attr the attributes of the job, or NULL for the defaults
+ */
+int scheduler_new_job_attr_r(scheduler_t *s, int job_number, int time, int running_time, int priority, const scheduler_job_attr_t *attr)
+{
+	int deadline = (attr != NULL ? attr->deadline : 0);
+	int group = (attr != NULL ? attr->group : 0);
+	int arrival = (attr != NULL && attr->arrival_time >= 0 && attr->arrival_time < time ? attr->arrival_time : time);
+
+	update_remaining_time(s, time);
+	boost_levels(s, time);
+
+	if (!admit(s, time, running_time, priority)){
+		if (s->options.admission_defer){
+			s->deferrals++;
+			return SCHEDULER_DEFERRED;
+		}
+		s->rejected_jobs++;
+		return SCHEDULER_REJECTED;
+	}
+	s->admission_delay += time - arrival;
+	s->backlog_work += running_time;
 	
-	total_jobs++;
+	s->total_jobs++;
 	job_t* job = malloc(sizeof(job_t));
 	job->id = job_number;
-	job->arrival_time = time;
+	job->arrival_time = arrival;
 	job->start_time = -1;
 	job->running_time = running_time;
 	job->remaining_time = running_time;
 	job->priority = priority;
+	job->aged_priority = (long long)priority * s->options.aging + time;
+	job->deadline = (deadline > 0 ? deadline : 0);
+	job->level = 0;
+	job->vruntime = 0;
+	job->penalty = 0;
+	job->last_core = -1;
+	job->progress = 0;
+	job->core_time = 0;
+	job->penalized = 0;
+	job->blocked_at = 0;
+	job->io_time = 0;
+	job->queue = (s->groups != NULL && group > 0 && group < s->options.groups ? group : 0);
 
-	int core = -1;
-	for (int i = 0; i < num_cores; i++){
-		if (active_cores[i] == 0){
-			core = i;
-			break;
+	if (s->first_arrival == -1){
+		s->first_arrival = arrival;
+	}
+	s->total_running_time += running_time;
+	s->total_priority += priority;
+
+	if (s->scheme == CFS){
+		// Priorities are read as nice values.
+		int nice = (priority < -20 ? -20 : (priority > 19 ? 19 : priority));
+		job->weight = cfs_weights[nice + 20];
+	}
+	else if (s->scheme == STRIDE || s->scheme == LOTTERY){
+		// Priorities are read as tickets.
+		job->weight = (priority > 0 ? priority : 1);
+	}
+
+	return place_job(s, job, time);
+}
+
+
+/**
+  Called when the job running on a core starts a burst of I/O and so no
+  longer needs the core until scheduler_job_woke() is called for it. The
+  core is freed as when a job finishes.
+
+  @param core_id the zero-based index of the core where the job was located.
+  @param job_number a globally unique identification number of the job,
+  which must be the job running on core core_id.
+  @param time the current time of the simulator.
+  @return job_number of the job that should be scheduled to run on core core_id
+  @return -1 if core should remain idle.
+  @return SCHEDULER_MISMATCH if job_number is not running on core core_id.
+ */
+int scheduler_job_blocked(int core_id, int job_number, int time)
+{
+	return scheduler_job_blocked_r(default_scheduler, core_id, job_number, time);
+}
+
+/**
+  Reentrant form of scheduler_job_blocked(). Job numbers must not be
+  negative.
+
+  @param s the scheduler instance
+ */
+int scheduler_job_blocked_r(scheduler_t *s, int core_id, int job_number, int time)
+{
+	job_t* job = s->active_cores[core_id];
+	if (job == NULL || job->id != job_number){
+		return SCHEDULER_MISMATCH;
+	}
+
+	update_remaining_time(s, time);
+	boost_levels(s, time);
+
+	job->blocked_at = time;
+	s->backlog_work -= job->remaining_time;
+
+	// A blocked job is not runnable, so it adds nothing to the load of its queue or group.
+	if (s->scheme == CFS){
+		s->queues[job->queue].load_weight -= job->weight;
+		s->queues[job->queue].nr_running--;
+	}
+	if (s->groups != NULL){
+		s->groups[job->queue].alive--;
+	}
+
+	if (job_number >= s->blocked_size){
+		int size = (s->blocked_size > 0 ? s->blocked_size : 64);
+		while (size <= job_number){
+			size *= 2;
 		}
+		s->blocked = realloc(s->blocked, size * sizeof(job_t*));
+		memset(s->blocked + s->blocked_size, 0, (size - s->blocked_size) * sizeof(job_t*));
+		s->blocked_size = size;
+	}
+	s->blocked[job_number] = job;
+	s->blocked_jobs++;
+
+	s->active_cores[core_id] = 0;
+	set_idle(s, core_id, 1);
+	if (s->least_loaded != NULL){
+		update_balance(s, core_id);
+	}
+
+	return take_next(s, core_id, time);
+}
+
+
+/**
+  Called when a job blocked on I/O has finished it and needs a core for its
+  next burst. The job is placed exactly as a new job would be, so it may go
+  to an idle core, preferring the one it last ran on when affinity is
+  preferred, preempt a running job, or wait. Under MLFQ it keeps the level
+  it had, and under CFS and STRIDE the virtual runtime or pass, unless that
+  has fallen behind the rest of its queue.
+
+  @param job_number a globally unique identification number of the job.
+  @param time the current time of the simulator.
+  @param running_time the number of time units the next burst of the job runs.
+  @return index of core job should be scheduled on
+  @return -1 if no scheduling changes should be made.
+ */
+int scheduler_job_woke(int job_number, int time, int running_time)
+{
+	return scheduler_job_woke_r(default_scheduler, job_number, time, running_time);
+}
+
+/**
+  Reentrant form of scheduler_job_woke().
+
+  @param s the scheduler instance
+ */
+int scheduler_job_woke_r(scheduler_t *s, int job_number, int time, int running_time)
+{
+	if (job_number < 0 || job_number >= s->blocked_size || s->blocked[job_number] == NULL){
+		return -1;
 	}
 
+	update_remaining_time(s, time);
+	boost_levels(s, time);
+
+	job_t* job = s->blocked[job_number];
+	s->blocked[job_number] = NULL;
+	s->blocked_jobs--;
+
+	job->io_time += time - job->blocked_at;
+	job->running_time = running_time;
+	job->remaining_time = running_time;
+	s->backlog_work += running_time;
+	job->progress = 0;
+	job->aged_priority = (long long)job->priority * s->options.aging + time;
+
+	return place_job(s, job, time);
+}
+
+
+/*
+  Puts a job that has become runnable on an idle core, on the core of a job
+  it preempts, or in a run queue, and returns the core or -1.
+ */
+static int place_job(scheduler_t *s, job_t *job, int time){
+	int core = pick_idle_core(s, job);
+
 	if (core != -1){
-		job->start_time = time;
-		active_cores[core] = job;
+		join_queue(s, job, home_queue(s, job, core));
+		dispatch(s, core, job, time);
 		return core;
 	}
 
-	if (preemptive){
+	if (s->preemptive){
 		job_t* worst_priority_job = job;
 
-		for (int i = 0; i < num_cores; i++){
-			if (queue.comparer(worst_priority_job,active_cores[i]) < 0){
+		for (int i = 0; i < s->num_cores; i++){
+			if (s->groups != NULL && s->active_cores[i]->queue != job->queue){
+				continue;
+			}
+			if (s->comparer(worst_priority_job,s->active_cores[i]) < 0){
 				core = i;
-				worst_priority_job = active_cores[i];
+				worst_priority_job = s->active_cores[i];
+			}
+		}
+
+		// With aging, a job that waited long enough may outrank the new one;
+		// the new job must not jump ahead of it onto a core.
+		if (core != -1 && s->comparer == aged){
+			job_t* head = priqueue_peek(&s->queues[home_queue(s, job, core)].queue);
+			if (head != NULL && aged(head, job) < 0){
+				core = -1;
 			}
 		}
 
 		if (core != -1){
-			job->start_time = time;
+			join_queue(s, job, home_queue(s, job, core));
+			dispatch(s, core, job, time);
 			
 			if (time == worst_priority_job->start_time){
 				worst_priority_job->start_time = -1;
 			}
 			
-			active_cores[core] = job;
-			priqueue_offer(&queue,worst_priority_job);
+			enqueue(s,worst_priority_job);
 			return core;
 		}
 	}
 
-	job->start_time = -1;
-	priqueue_offer(&queue,job);
+	join_queue(s, job, least_loaded_queue(s, job));
+	enqueue(s,job);
 	return -1;
 }
 
@@ -178,7 +846,10 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
   The core_id, job_number and time parameters are provided for convenience. You may be able to calculate the values with your own data structure.
   If any job should be scheduled to run on the core free'd up by the
   finished job, return the job_number of the job that should be scheduled to
-  run on core core_id.
+  run on core core_id. With per-core run queues, a core whose own queue is
+  empty first steals work from the busiest queue. When the cores are shared
+  between groups, the core takes the next job of the group with waiting
+  jobs that is furthest behind its share.
 
   @param core_id the zero-based index of the core where the job was located.
   @param job_number a globally unique identification number of the job.
@@ -188,23 +859,84 @@ int scheduler_new_job(int job_number, int time, int running_time, int priority)
  */
 int scheduler_job_finished(int core_id, int job_number, int time)
 {
-	update_remaining_time(time);
+	return scheduler_job_finished_r(default_scheduler, core_id, job_number, time);
+}
+
+/**
+  Reentrant form of scheduler_job_finished().
+
+  @param s the scheduler instance
+ */
+int scheduler_job_finished_r(scheduler_t *s, int core_id, int job_number, int time)
+{
+	update_remaining_time(s, time);
+	boost_levels(s, time);
 
-	job_t* finished_job = active_cores[core_id];
+	job_t* finished_job = s->active_cores[core_id];
 	
-	waiting_time += time - finished_job->running_time - finished_job->arrival_time;
-	response_time += finished_job->start_time - finished_job->arrival_time;
-	turnaround_time += time - finished_job->arrival_time;
+	// Penalties were added to the running time, but are time lost waiting.
+	int waited = time - finished_job->core_time + finished_job->penalized - finished_job->io_time - finished_job->arrival_time;
+	s->waiting_time += waited;
+	if (waited > s->max_waiting_time){
+		s->max_waiting_time = waited;
+	}
+	s->response_time += finished_job->start_time - finished_job->arrival_time;
+	s->turnaround_time += time - finished_job->arrival_time;
+	s->finished_jobs++;
+	s->backlog_work -= finished_job->remaining_time;
 
-	free(finished_job);
-	active_cores[core_id] = 0;
+	if (finished_job->deadline > 0){
+		int late = time - finished_job->deadline;
 
-	if (queue.m_front != NULL){
-		job_t* job = priqueue_poll(&queue);
-		if (job->start_time == -1){
-			job->start_time = time;
+		if (s->tardiness_size == s->deadline_jobs){
+			s->tardiness_size = (s->tardiness_size > 0 ? 2 * s->tardiness_size : 64);
+			s->tardiness = realloc(s->tardiness, s->tardiness_size * sizeof(int));
 		}
-		active_cores[core_id] = job;
+		s->tardiness[s->deadline_jobs++] = (late > 0 ? late : 0);
+		s->tardiness_sorted = 0;
+		if (late > 0){
+			s->deadline_misses++;
+		}
+	}
+
+	if (s->scheme == CFS){
+		s->queues[finished_job->queue].load_weight -= finished_job->weight;
+		s->queues[finished_job->queue].nr_running--;
+	}
+
+	if (s->groups != NULL){
+		group_t* g = &s->groups[finished_job->queue];
+		g->alive--;
+		g->jobs++;
+		g->waiting_time += waited;
+		g->response_time += finished_job->start_time - finished_job->arrival_time;
+		g->turnaround_time += time - finished_job->arrival_time;
+	}
+
+	free(finished_job);
+	s->active_cores[core_id] = 0;
+	set_idle(s, core_id, 1);
+	if (s->least_loaded != NULL){
+		update_balance(s, core_id);
+	}
+
+	return take_next(s, core_id, time);
+}
+
+
+/*
+  Finds a freed core its next job, stealing one with per-core queues if its
+  own queue is empty, and returns its number or -1 if the core stays idle.
+ */
+static int take_next(scheduler_t *s, int core_id, int time){
+	runqueue_t* rq = core_queue(s, core_id);
+	if (queue_empty(rq) && s->least_loaded != NULL){
+		steal(s, core_id);
+	}
+
+	if (!queue_empty(rq)){
+		job_t* job = pick_next(s, rq, core_id);
+		dispatch(s, core_id, job, time);
 		return job->id;
 	}
 
@@ -213,8 +945,15 @@ int scheduler_job_finished(int core_id, int job_number, int time)
 
 
 /**
-  When the scheme is set to RR, called when the quantum timer has expired
-  on a core.
+  When the scheme is time sliced (RR, MLFQ, CFS, STRIDE or LOTTERY), called
+  when the quantum timer has expired on a core. Under MLFQ the job on the
+  core moves down a level; under CFS it goes back into the tree by the
+  virtual runtime it has accumulated and the job with the smallest one runs
+  next. Under STRIDE the job with the smallest pass runs next, and under
+  LOTTERY the holder of a ticket drawn from every waiting job's, the job on
+  the core included. When the cores are shared between groups, the next job
+  comes from the group furthest behind its share, which may be the group of
+  the job on the core.
 
   If any job should be scheduled to run on the core free'd up by
   the quantum expiration, return the job_number of the job that should be
@@ -227,20 +966,31 @@ int scheduler_job_finished(int core_id, int job_number, int time)
  */
 int scheduler_quantum_expired(int core_id, int time)
 {
-	update_remaining_time(time);
+	return scheduler_quantum_expired_r(default_scheduler, core_id, time);
+}
+
+/**
+  Reentrant form of scheduler_quantum_expired().
+
+  @param s the scheduler instance
+ */
+int scheduler_quantum_expired_r(scheduler_t *s, int core_id, int time)
+{
+	update_remaining_time(s, time);
+	boost_levels(s, time);
 	
-	job_t* job = active_cores[core_id];
+	job_t* job = s->active_cores[core_id];
 
-	if (queue.m_front != NULL){
-		
-		priqueue_offer(&queue,job);
-		job = priqueue_poll(&queue);
+	if (s->scheme == MLFQ && job->level < s->options.levels - 1){
+		job->level++;
+	}
+
+	if (!queue_empty(core_queue(s, core_id))){
 		
-		if (job->start_time == -1){
-			job->start_time = time;
-		}
+		enqueue(s,job);
+		job = pick_next(s, core_queue(s, core_id), core_id);
 		
-		active_cores[core_id] = job;
+		dispatch(s, core_id, job, time);
 		
 	}
 	
@@ -250,94 +1000,1737 @@ int scheduler_quantum_expired(int core_id, int time)
 
 
 /**
-  Returns the average waiting time of all jobs scheduled by your scheduler.
+  Returns the length of the time slice the job running on a core gets. The
+  simulator should start the quantum timer of a core with this value
+  whenever the scheduler places a job on it.
 
-  Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average waiting time of all jobs scheduled.
+  @param s the scheduler instance
+  @param core_id the zero-based index of the core
+  @return the number of time units before scheduler_quantum_expired_r() should be called
+  @return 0 if the core is idle or the scheme is not time sliced
  */
-float scheduler_average_waiting_time()
+int scheduler_quantum_r(scheduler_t *s, int core_id)
 {
-	return (total_jobs > 0 ? waiting_time/total_jobs : 0.0);
+	job_t* job = s->active_cores[core_id];
+
+	if (job == NULL){
+		return 0;
+	}
+
+	switch(s->scheme){
+		case RR:
+		case STRIDE:
+		case LOTTERY:
+			return s->options.quantum;
+		case MLFQ:
+			return s->options.level_quantum[job->level];
+		case CFS:
+			return cfs_slice(s, &s->queues[job->queue], job);
+		default:
+			return 0;
+	}
 }
 
 
 /**
-  Returns the average turnaround time of all jobs scheduled by your scheduler.
+  Returns the time units the jobs placed on a core since the last call have
+  to spend on migrating there before they make progress again, and resets
+  the count. This is the migration cost of moving between run queues plus
+  the cache penalty of resuming away from the core a job last ran on. The
+  simulator should add this to the running time left of the job on the
+  core whenever the scheduler places a job on it.
 
-  Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average turnaround time of all jobs scheduled.
+  @param s the scheduler instance
+  @param core_id the zero-based index of the core
+  @return the migration cost in time units, 0 if the job did not migrate
  */
-float scheduler_average_turnaround_time()
+int scheduler_migration_cost_r(scheduler_t *s, int core_id)
 {
-	return (total_jobs > 0 ? turnaround_time/total_jobs : 0.0);
+	int cost = s->migration_cost[core_id];
+	s->migration_cost[core_id] = 0;
+	return cost;
 }
 
 
 /**
-  Returns the average response time of all jobs scheduled by your scheduler.
+  Returns the number of times an idle core stole work from another core's
+  run queue. Always 0 unless per-core run queues are enabled.
 
-  Assumptions:
-    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
-  @return the average response time of all jobs scheduled.
+  @param s the scheduler instance
  */
-float scheduler_average_response_time()
+int scheduler_steals_r(scheduler_t *s)
 {
-		return (total_jobs > 0 ? response_time/total_jobs : 0.0);
+	return s->steals;
 }
 
 
 /**
-  Free any memory associated with your scheduler.
+  Returns the number of jobs that moved from one core's run queue to
+  another's. A steal may move several jobs at once.
 
-  Assumptions:
-    - This function will be the last function called in your library.
-*/
-void scheduler_clean_up()
+  @param s the scheduler instance
+ */
+int scheduler_migrations_r(scheduler_t *s)
 {
-	while (queue.m_size > 0) {
-		job_t* temp = priqueue_poll(&queue);
-		free(temp);
-	}
+	return s->migrations;
 }
 
 
 /**
-  This function may print out any debugging information you choose. This
-  function will be called by the simulator after every call the simulator
-  makes to your scheduler.
-  In our provided output, we have implemented this function to list the jobs in the order they are to be scheduled. Furthermore, we have also listed the current state of the job (either running on a given core or idle). For example, if we have a non-preemptive algorithm and job(id=4) has began running, job(id=2) arrives with a higher priority, and job(id=1) arrives with a lower priority, the output in our sample output will be:
+  Adds up the counters of the priority queues behind the run queues: the
+  one of every run queue, and for MLFQ those of its levels. The high-water
+  mark is the highest of any one queue. Schemes that keep their waiting
+  jobs in a tree or a heap leave these queues unused.
 
-    2(-1) 4(0) 1(-1)
-
-  This function is not required and will not be graded. You may leave it
-  blank if you do not find it useful.
+  @param s the scheduler instance
+  @param stats receives the counters
+  @return 0 if the counters are kept
+  @return -1 if libpriqueue was built without PRIQUEUE_STATS
  */
-void scheduler_show_queue()
+int scheduler_queue_stats_r(scheduler_t *s, priqueue_stats_t *stats)
 {
-	node_t* temp = queue.m_front;
-	if (queue.m_front != NULL){
-		while (temp != NULL){
-			job_t* job = temp->value;
-			printf(
-									"ID: %d, arrival_time: %d, start_time: %d, remaining_time: %d, running_time: %d, priority: %d\n"
+	priqueue_stats_t queue;
+	int status = 0;
+
+	memset(stats, 0, sizeof(*stats));
+	for (int i = 0; i < s->num_queues; i++){
+		runqueue_t* rq = &s->queues[i];
+		int levels = (s->scheme == MLFQ ? s->options.levels : 0);
+
+		for (int level = -1; level < levels; level++){
+			status = priqueue_stats(level < 0 ? &rq->queue : &rq->levels[level], &queue);
+			stats->comparisons += queue.comparisons;
+			stats->offers += queue.offers;
+			stats->traversed += queue.traversed;
+			stats->allocations += queue.allocations;
+			if (queue.high_water > stats->high_water){
+				stats->high_water = queue.high_water;
+			}
+		}
+	}
+
+	return status;
+}
+
+
+/**
+  Returns the number of times a job resumed on a core other than the one it
+  last ran on, and so started with a cold cache.
+
+  @param s the scheduler instance
+ */
+int scheduler_cache_misses_r(scheduler_t *s)
+{
+	return s->cache_misses;
+}
+
+
+/**
+  Returns the total time units jobs lost to migration costs and cache
+  penalties, which is the CPU time moving jobs around took away from useful
+  work.
+
+  @param s the scheduler instance
+ */
+int scheduler_penalty_time_r(scheduler_t *s)
+{
+	return s->penalty_time;
+}
+
+
+/**
+  Returns the speed of a core, in SCHEDULER_SPEED_UNITs. A job on the core
+  does that many thousandths of a time unit of work per time unit, so the
+  simulator should advance it accordingly.
+
+  @param s the scheduler instance
+  @param core_id the zero-based index of the core
+ */
+int scheduler_core_speed_r(scheduler_t *s, int core_id)
+{
+	return s->speeds[core_id];
+}
+
+
+/**
+  Returns the number of finished jobs that had a deadline.
+
+  @param s the scheduler instance
+ */
+int scheduler_deadline_jobs_r(scheduler_t *s)
+{
+	return s->deadline_jobs;
+}
+
+
+/**
+  Returns the number of finished jobs that finished after their deadline.
+
+  @param s the scheduler instance
+ */
+int scheduler_deadline_misses_r(scheduler_t *s)
+{
+	return s->deadline_misses;
+}
+
+
+/**
+  Returns a percentile of the tardiness of the finished jobs that had a
+  deadline, that is how long after its deadline each finished, 0 for those
+  that made it. Uses the nearest rank, so the result is the tardiness of an
+  actual job.
+
+  @param s the scheduler instance
+  @param percentile the percentile, from 0 to 100
+  @return the tardiness at that percentile
+  @return 0 if no job with a deadline has finished
+ */
+int scheduler_tardiness_percentile_r(scheduler_t *s, float percentile)
+{
+	if (s->deadline_jobs == 0){
+		return 0;
+	}
+	if (!s->tardiness_sorted){
+		qsort(s->tardiness, s->deadline_jobs, sizeof(int), compare_int);
+		s->tardiness_sorted = 1;
+	}
+
+	int rank = (int)(percentile / 100.0 * s->deadline_jobs + 0.999999);
+	if (rank < 1){
+		rank = 1;
+	}
+	if (rank > s->deadline_jobs){
+		rank = s->deadline_jobs;
+	}
+	return s->tardiness[rank - 1];
+}
+
+
+/**
+  Returns the number of jobs the admission policy rejected.
+
+  @param s the scheduler instance
+ */
+int scheduler_rejected_jobs_r(scheduler_t *s)
+{
+	return s->rejected_jobs;
+}
+
+
+/**
+  Returns the number of times the admission policy deferred a job. A job
+  deferred again each time it is offered counts each time.
+
+  @param s the scheduler instance
+ */
+int scheduler_deferrals_r(scheduler_t *s)
+{
+	return s->deferrals;
+}
+
+
+/**
+  Returns the average time the admitted jobs spent deferred before they
+  were admitted, which their waiting, response and turnaround times
+  include.
+
+  @param s the scheduler instance
+ */
+float scheduler_average_admission_delay_r(scheduler_t *s)
+{
+	return (s->total_jobs > 0 ? s->admission_delay / (float)s->total_jobs : 0.0);
+}
+
+
+/**
+  Returns the longest any finished job spent waiting, the measure of how
+  close the scheme came to starving a job.
+
+  @param s the scheduler instance
+ */
+int scheduler_max_waiting_time_r(scheduler_t *s)
+{
+	return s->max_waiting_time;
+}
+
+
+/**
+  Returns the weight of a group, by which it shares the cores with the
+  others.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+  @return the weight of the group
+  @return 0 if the cores are not shared between groups or there is no such group
+ */
+int scheduler_group_weight_r(scheduler_t *s, int group)
+{
+	if (s->groups == NULL || group < 0 || group >= s->options.groups){
+		return 0;
+	}
+	return s->groups[group].weight;
+}
+
+
+/**
+  Returns the number of finished jobs of a group.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+ */
+int scheduler_group_jobs_r(scheduler_t *s, int group)
+{
+	if (s->groups == NULL || group < 0 || group >= s->options.groups){
+		return 0;
+	}
+	return s->groups[group].jobs;
+}
+
+
+/**
+  Returns the time units of CPU the jobs of a group have had, which over a
+  busy stretch should be in proportion to the weight of the group.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+ */
+long long scheduler_group_cpu_time_r(scheduler_t *s, int group)
+{
+	if (s->groups == NULL || group < 0 || group >= s->options.groups){
+		return 0;
+	}
+	return s->groups[group].cpu_time;
+}
+
+
+/**
+  Returns the average waiting time of the finished jobs of a group.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+ */
+float scheduler_group_average_waiting_time_r(scheduler_t *s, int group)
+{
+	int jobs = scheduler_group_jobs_r(s, group);
+	return (jobs > 0 ? s->groups[group].waiting_time/jobs : 0.0);
+}
+
+
+/**
+  Returns the average turnaround time of the finished jobs of a group.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+ */
+float scheduler_group_average_turnaround_time_r(scheduler_t *s, int group)
+{
+	int jobs = scheduler_group_jobs_r(s, group);
+	return (jobs > 0 ? s->groups[group].turnaround_time/jobs : 0.0);
+}
+
+
+/**
+  Returns the average response time of the finished jobs of a group.
+
+  @param s the scheduler instance
+  @param group the group, from 0
+ */
+float scheduler_group_average_response_time_r(scheduler_t *s, int group)
+{
+	int jobs = scheduler_group_jobs_r(s, group);
+	return (jobs > 0 ? s->groups[group].response_time/jobs : 0.0);
+}
+
+
+/**
+  Returns the fraction of the time from the first arrival to the last event
+  that the cores spent running jobs, counting time lost to migrations.
+  Jobs that block on I/O leave their cores to others, so the more of it
+  overlaps with computation, the closer this comes to 1.
+
+  @param s the scheduler instance
+  @return the utilization, from 0 to 1
+ */
+float scheduler_cpu_utilization_r(scheduler_t *s)
+{
+	long long span = (long long)(s->curr_time - s->first_arrival) * s->num_cores;
+	return (s->first_arrival != -1 && span > 0 ? s->busy_time / (float)span : 0.0);
+}
+
+
+/**
+  Returns the time units the cores spent running jobs, added up over the
+  cores.
+
+  @param s the scheduler instance
+ */
+long long scheduler_busy_time_r(scheduler_t *s)
+{
+	return s->busy_time;
+}
+
+
+/**
+  Fills in the state of the default scheduler instance at the given time.
+  Unlike the averages above, this may be called at any time.
+
+  @param time the current time of the simulator.
+  @param stats receives the state of the scheduler
+ */
+void scheduler_stats_snapshot(int time, scheduler_stats_t *stats)
+{
+	scheduler_stats_snapshot_r(default_scheduler, time, stats);
+}
+
+/**
+  Reentrant form of scheduler_stats_snapshot(). It costs the same however
+  many jobs and cores there are. The scheduler only hears of time passing
+  at events, so the time the cores spent running jobs since the last one is
+  added on: the jobs running then still are.
+
+  @param s the scheduler instance
+  @param time the current time of the simulator, no earlier than the last event
+  @param stats receives the state of the scheduler
+ */
+void scheduler_stats_snapshot_r(scheduler_t *s, int time, scheduler_stats_t *stats)
+{
+	int since = (time > s->curr_time ? time - (int)s->curr_time : 0);
+	int finished = s->finished_jobs;
+
+	stats->time = (since > 0 ? time : (int)s->curr_time);
+	stats->arrived_jobs = s->total_jobs;
+	stats->finished_jobs = finished;
+	stats->running_jobs = s->running_jobs;
+	stats->blocked_jobs = s->blocked_jobs;
+	stats->waiting_jobs = s->total_jobs - finished - s->running_jobs - s->blocked_jobs;
+	stats->busy_time = s->busy_time + (long long)since * s->running_jobs;
+
+	long long span = (long long)(stats->time - s->first_arrival) * s->num_cores;
+	stats->cpu_utilization = (s->first_arrival != -1 && span > 0 ? stats->busy_time / (float)span : 0.0);
+	stats->average_waiting_time = (finished > 0 ? s->waiting_time / finished : 0.0);
+	stats->average_turnaround_time = (finished > 0 ? s->turnaround_time / finished : 0.0);
+	stats->average_response_time = (finished > 0 ? s->response_time / finished : 0.0);
+	stats->deadline_misses = s->deadline_misses;
+}
+
+
+/**
+  Returns the average waiting time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average waiting time of all jobs scheduled.
+ */
+float scheduler_average_waiting_time()
+{
+	return scheduler_average_waiting_time_r(default_scheduler);
+}
+
+/**
+  Reentrant form of scheduler_average_waiting_time().
+
+  @param s the scheduler instance
+ */
+float scheduler_average_waiting_time_r(scheduler_t *s)
+{
+	return (s->total_jobs > 0 ? s->waiting_time/s->total_jobs : 0.0);
+}
+
+
+/**
+  Returns the average turnaround time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average turnaround time of all jobs scheduled.
+ */
+float scheduler_average_turnaround_time()
+{
+	return scheduler_average_turnaround_time_r(default_scheduler);
+}
+
+/**
+  Reentrant form of scheduler_average_turnaround_time().
+
+  @param s the scheduler instance
+ */
+float scheduler_average_turnaround_time_r(scheduler_t *s)
+{
+	return (s->total_jobs > 0 ? s->turnaround_time/s->total_jobs : 0.0);
+}
+
+
+/**
+  Returns the average response time of all jobs scheduled by your scheduler.
+
+  Assumptions:
+    - This function will only be called after all scheduling is complete (all jobs that have arrived will have finished and no new jobs will arrive).
+  @return the average response time of all jobs scheduled.
+ */
+float scheduler_average_response_time()
+{
+	return scheduler_average_response_time_r(default_scheduler);
+}
+
+/**
+  Reentrant form of scheduler_average_response_time().
+
+  @param s the scheduler instance
+ */
+float scheduler_average_response_time_r(scheduler_t *s)
+{
+	return (s->total_jobs > 0 ? s->response_time/s->total_jobs : 0.0);
+}
+
+
+/**
+  Free any memory associated with your scheduler.
+
+  Assumptions:
+    - This function will be the last function called in your library.
+*/
+void scheduler_clean_up()
+{
+	scheduler_destroy(default_scheduler);
+	default_scheduler = NULL;
+}
+
+/**
+  Frees an instance created by scheduler_create(), including any jobs that
+  are still queued or running.
+
+  @param s the scheduler instance
+*/
+void scheduler_destroy(scheduler_t *s)
+{
+	for (int i = 0; i < s->num_queues; i++){
+		while (!queue_empty(&s->queues[i])) {
+			job_t* temp = dequeue(s, &s->queues[i]);
+			free(temp);
+		}
+		if (s->scheme == CFS){
+			rbtree_destroy(&s->queues[i].tree);
+		}
+		if (uses_heap(s)){
+			heap_destroy(&s->queues[i].heap);
+		}
+		free(s->queues[i].slots);
+		free(s->queues[i].fenwick);
+		free(s->queues[i].free_slots);
+	}
+	for (int i = 0; i < s->num_cores; i++){
+		free(s->active_cores[i]);
+	}
+	for (int i = 0; i < s->blocked_size; i++){
+		free(s->blocked[i]);
+	}
+	free(s->blocked);
+	free(s->active_cores);
+	free(s->idle_cores);
+	free(s->idle_ranked);
+	free(s->speeds);
+	free(s->core_rank);
+	free(s->rank_core);
+	free(s->tardiness);
+	free(s->buckets);
+	free(s->migration_cost);
+	free(s->least_loaded);
+	free(s->busiest);
+	free(s->neediest);
+	free(s->groups);
+	free(s->queues);
+	free(s);
+}
+
+/*
+  Snapshots hold every field in the machine's own layout, so they are read
+  back by the same build on the same kind of machine.
+ */
+#define SCHEDULER_SNAPSHOT_MAGIC 0x53434832
+
+static void save_value(FILE *out, const void *value, size_t size){
+	if (size > 0){
+		fwrite(value, size, 1, out);
+	}
+}
+
+static int load_value(FILE *in, void *value, size_t size){
+	return size == 0 || fread(value, size, 1, in) == 1;
+}
+
+static job_t *load_job(FILE *in){
+	job_t* job = malloc(sizeof(job_t));
+
+	if (job != NULL && !load_value(in, job, sizeof(job_t))){
+		free(job);
+		return NULL;
+	}
+	return job;
+}
+
+/*
+  Lists the waiting jobs of a run queue in the order of its structure: the
+  levels of MLFQ one after the other, the tree of CFS in order, the array of
+  a heap and the slots of LOTTERY. Putting them back in that order rebuilds
+  the same structure.
+ */
+static job_t **runqueue_jobs(scheduler_t *s, runqueue_t *rq, int *count){
+	job_t** jobs = malloc((rq->size + rq->slots_used + 1) * sizeof(job_t*));
+	*count = 0;
+
+	if (s->scheme == MLFQ){
+		for (int i = 0; i < s->options.levels; i++){
+			for (node_t* node = rq->levels[i].m_front; node != NULL; node = node->next){
+				jobs[(*count)++] = node->value;
+			}
+		}
+	}
+	else if (s->scheme == CFS){
+		for (rbnode_t* node = rbtree_first(&rq->tree); node != NULL; node = rbtree_next(node)){
+			jobs[(*count)++] = node->value;
+		}
+	}
+	else if (uses_heap(s)){
+		for (int i = 0; i < heap_size(&rq->heap); i++){
+			jobs[(*count)++] = heap_at(&rq->heap, i);
+		}
+	}
+	else if (s->scheme == LOTTERY){
+		for (int i = 0; i < rq->slots_used; i++){
+			if (rq->slots[i] != NULL){
+				jobs[(*count)++] = rq->slots[i];
+			}
+		}
+	}
+	else{
+		for (node_t* node = rq->queue.m_front; node != NULL; node = node->next){
+			jobs[(*count)++] = node->value;
+		}
+	}
+	return jobs;
+}
+
+/*
+  Puts a waiting job back where runqueue_jobs() found it. LOTTERY slots
+  must already be allocated.
+ */
+static int restore_job(scheduler_t *s, runqueue_t *rq, job_t *job){
+	if (s->scheme == MLFQ){
+		if (job->level < 0 || job->level >= s->options.levels){
+			return 0;
+		}
+		priqueue_append(&rq->levels[job->level], job);
+	}
+	else if (s->scheme == CFS){
+		rbtree_insert(&rq->tree, job);
+	}
+	else if (uses_heap(s)){
+		heap_offer(&rq->heap, job);
+	}
+	else if (s->scheme == LOTTERY){
+		if (job->slot < 0 || job->slot >= rq->slots_used || rq->slots[job->slot] != NULL){
+			return 0;
+		}
+		rq->slots[job->slot] = job;
+	}
+	else{
+		priqueue_append(&rq->queue, job);
+	}
+	return 1;
+}
+
+/*
+  Frees the waiting jobs of a run queue that could not be fully restored,
+  whose bookkeeping can not be trusted to take them out one by one.
+ */
+static void discard_jobs(scheduler_t *s, runqueue_t *rq){
+	int count;
+	job_t** jobs = runqueue_jobs(s, rq, &count);
+
+	for (int i = 0; i < count; i++){
+		free(jobs[i]);
+	}
+	free(jobs);
+
+	priqueue_destroy(&rq->queue);
+	for (int i = 0; s->scheme == MLFQ && i < s->options.levels; i++){
+		priqueue_destroy(&rq->levels[i]);
+	}
+	if (s->scheme == CFS){
+		rbtree_destroy(&rq->tree);
+		rbtree_init(&rq->tree,cfs);
+	}
+	if (uses_heap(s)){
+		heap_destroy(&rq->heap);
+	}
+	for (int i = 0; i < rq->slots_used && rq->slots != NULL; i++){
+		rq->slots[i] = NULL;
+	}
+	rq->size = 0;
+}
+
+
+/**
+  Writes the complete state of a scheduler instance to a compact binary
+  snapshot: its configuration, every job it knows of, whether running,
+  waiting or blocked, the contents and order of its run queues, and every
+  statistic it has gathered. scheduler_restore() reads it back into an
+  instance that makes exactly the decisions this one would have.
+
+  @param s the scheduler instance
+  @param out the stream to write to
+  @return 0 on success
+  @return -1 if writing failed
+ */
+int scheduler_save_r(scheduler_t *s, FILE *out)
+{
+	int magic = SCHEDULER_SNAPSHOT_MAGIC;
+	int none = -1;
+
+	save_value(out, &magic, sizeof(magic));
+	save_value(out, &s->num_cores, sizeof(s->num_cores));
+	save_value(out, &s->scheme, sizeof(s->scheme));
+	save_value(out, &s->options, sizeof(s->options));
+	save_value(out, s->speeds, s->num_cores * sizeof(int));
+	for (int i = 0; i < s->options.groups; i++){
+		save_value(out, &s->groups[i], sizeof(group_t));
+	}
+	save_value(out, &s->min_group_vtime, sizeof(s->min_group_vtime));
+
+	// Running jobs, by core
+	for (int i = 0; i < s->num_cores; i++){
+		if (s->active_cores[i] != NULL){
+			save_value(out, &i, sizeof(i));
+			save_value(out, s->active_cores[i], sizeof(job_t));
+		}
+	}
+	save_value(out, &none, sizeof(none));
+
+	// Blocked jobs, by job number
+	save_value(out, &s->blocked_size, sizeof(s->blocked_size));
+	for (int i = 0; i < s->blocked_size; i++){
+		if (s->blocked[i] != NULL){
+			save_value(out, &i, sizeof(i));
+			save_value(out, s->blocked[i], sizeof(job_t));
+		}
+	}
+	save_value(out, &none, sizeof(none));
+
+	// Waiting jobs, by run queue
+	for (int q = 0; q < s->num_queues; q++){
+		runqueue_t* rq = &s->queues[q];
+		int count;
+		job_t** jobs = runqueue_jobs(s, rq, &count);
+
+		save_value(out, &rq->size, sizeof(rq->size));
+		save_value(out, &rq->nonempty_levels, sizeof(rq->nonempty_levels));
+		save_value(out, &rq->min_vruntime, sizeof(rq->min_vruntime));
+		save_value(out, &rq->load_weight, sizeof(rq->load_weight));
+		save_value(out, &rq->nr_running, sizeof(rq->nr_running));
+		save_value(out, &rq->slots_used, sizeof(rq->slots_used));
+		save_value(out, &rq->free_count, sizeof(rq->free_count));
+		save_value(out, rq->free_slots, rq->free_count * sizeof(int));
+		save_value(out, &count, sizeof(count));
+		for (int i = 0; i < count; i++){
+			save_value(out, jobs[i], sizeof(job_t));
+		}
+		free(jobs);
+	}
+
+	save_value(out, &s->total_jobs, sizeof(s->total_jobs));
+	save_value(out, &s->finished_jobs, sizeof(s->finished_jobs));
+	save_value(out, &s->blocked_jobs, sizeof(s->blocked_jobs));
+	save_value(out, &s->curr_time, sizeof(s->curr_time));
+	save_value(out, &s->waiting_time, sizeof(s->waiting_time));
+	save_value(out, &s->response_time, sizeof(s->response_time));
+	save_value(out, &s->turnaround_time, sizeof(s->turnaround_time));
+	save_value(out, &s->max_waiting_time, sizeof(s->max_waiting_time));
+	save_value(out, &s->first_arrival, sizeof(s->first_arrival));
+	save_value(out, &s->busy_time, sizeof(s->busy_time));
+	save_value(out, &s->rng, sizeof(s->rng));
+	save_value(out, &s->total_running_time, sizeof(s->total_running_time));
+	save_value(out, &s->total_priority, sizeof(s->total_priority));
+	save_value(out, &s->deadline_jobs, sizeof(s->deadline_jobs));
+	save_value(out, &s->deadline_misses, sizeof(s->deadline_misses));
+	save_value(out, s->tardiness, s->deadline_jobs * sizeof(int));
+	save_value(out, &s->tardiness_sorted, sizeof(s->tardiness_sorted));
+	save_value(out, &s->next_boost, sizeof(s->next_boost));
+	save_value(out, s->migration_cost, s->num_cores * sizeof(int));
+	save_value(out, &s->steals, sizeof(s->steals));
+	save_value(out, &s->migrations, sizeof(s->migrations));
+	save_value(out, &s->cache_misses, sizeof(s->cache_misses));
+	save_value(out, &s->penalty_time, sizeof(s->penalty_time));
+	save_value(out, &s->backlog_work, sizeof(s->backlog_work));
+	save_value(out, &s->rejected_jobs, sizeof(s->rejected_jobs));
+	save_value(out, &s->deferrals, sizeof(s->deferrals));
+	save_value(out, &s->admission_delay, sizeof(s->admission_delay));
+	save_value(out, &s->buckets_ct, sizeof(s->buckets_ct));
+	save_value(out, s->buckets, s->buckets_ct * sizeof(bucket_t));
+	save_value(out, &magic, sizeof(magic));
+
+	return (ferror(out) ? -1 : 0);
+}
+
+
+/**
+  Creates a scheduler instance from a snapshot written by
+  scheduler_save_r(), picking up where the instance that wrote it was.
+
+  @param in the stream to read from
+  @return the restored scheduler instance
+  @return NULL if the stream does not hold a valid snapshot
+ */
+scheduler_t *scheduler_restore(FILE *in)
+{
+	int magic, cores, ok = 1;
+	scheme_t scheme;
+	scheduler_options_t options;
+
+	if (!load_value(in, &magic, sizeof(magic)) || magic != SCHEDULER_SNAPSHOT_MAGIC
+			|| !load_value(in, &cores, sizeof(cores)) || !load_value(in, &scheme, sizeof(scheme))
+			|| !load_value(in, &options, sizeof(options))
+			|| cores <= 0 || cores > (1 << 20) || scheme < FCFS || scheme > LOTTERY
+			|| options.levels <= 0 || options.levels > SCHEDULER_MAX_LEVELS || options.groups < 0 || options.groups > (1 << 20)){
+		return NULL;
+	}
+
+	int* speeds = malloc(cores * sizeof(int));
+	group_t* groups = malloc((options.groups + 1) * sizeof(group_t));
+	int* weights = malloc((options.groups + 1) * sizeof(int));
+
+	ok = load_value(in, speeds, cores * sizeof(int));
+	for (int i = 0; ok && i < options.groups; i++){
+		ok = load_value(in, &groups[i], sizeof(group_t));
+		weights[i] = groups[i].weight;
+	}
+	options.speeds = speeds;
+	options.group_weights = weights;
+
+	scheduler_t* s = (ok ? scheduler_create(cores, scheme, &options) : NULL);
+	free(speeds);
+	free(weights);
+	if (s == NULL){
+		free(groups);
+		return NULL;
+	}
+	if (options.groups > 0){
+		memcpy(s->groups, groups, options.groups * sizeof(group_t));
+	}
+	free(groups);
+	ok = load_value(in, &s->min_group_vtime, sizeof(s->min_group_vtime));
+
+	// Running jobs, by core
+	int index;
+	while (ok && (ok = load_value(in, &index, sizeof(index))) && index != -1){
+		if (index < 0 || index >= cores || s->active_cores[index] != NULL || (s->active_cores[index] = load_job(in)) == NULL){
+			ok = 0;
+			break;
+		}
+		set_idle(s, index, 0);
+	}
+
+	// Blocked jobs, by job number
+	int blocked_size;
+	ok = ok && load_value(in, &blocked_size, sizeof(blocked_size)) && blocked_size >= 0;
+	if (ok && blocked_size > 0){
+		s->blocked = calloc(blocked_size, sizeof(job_t*));
+		s->blocked_size = blocked_size;
+	}
+	while (ok && (ok = load_value(in, &index, sizeof(index))) && index != -1){
+		if (index < 0 || index >= s->blocked_size || s->blocked[index] != NULL || (s->blocked[index] = load_job(in)) == NULL){
+			ok = 0;
+		}
+	}
+
+	// Waiting jobs, by run queue
+	for (int q = 0; ok && q < s->num_queues; q++){
+		runqueue_t* rq = &s->queues[q];
+		int count;
+
+		ok = load_value(in, &rq->size, sizeof(rq->size))
+				&& load_value(in, &rq->nonempty_levels, sizeof(rq->nonempty_levels))
+				&& load_value(in, &rq->min_vruntime, sizeof(rq->min_vruntime))
+				&& load_value(in, &rq->load_weight, sizeof(rq->load_weight))
+				&& load_value(in, &rq->nr_running, sizeof(rq->nr_running))
+				&& load_value(in, &rq->slots_used, sizeof(rq->slots_used))
+				&& load_value(in, &rq->free_count, sizeof(rq->free_count))
+				&& rq->slots_used >= 0 && rq->free_count >= 0 && rq->free_count <= rq->slots_used;
+
+		if (ok && s->scheme == LOTTERY && rq->slots_used > 0){
+			int capacity = 64;
+			while (capacity < rq->slots_used){
+				capacity *= 2;
+			}
+			rq->slot_capacity = capacity;
+			rq->slots = calloc(capacity, sizeof(job_t*));
+			rq->free_slots = malloc(capacity * sizeof(int));
+			rq->fenwick = calloc(capacity + 1, sizeof(long long));
+			ok = load_value(in, rq->free_slots, rq->free_count * sizeof(int));
+		}
+		else if (rq->slots_used > 0 || rq->free_count > 0){
+			ok = 0;
+		}
+
+		int size = rq->size;
+		rq->size = 0;
+		ok = ok && load_value(in, &count, sizeof(count)) && count >= 0 && count == size;
+		for (int i = 0; ok && i < count; i++){
+			job_t* job = load_job(in);
+
+			if (job == NULL || job->queue != q || !restore_job(s, rq, job)){
+				free(job);
+				ok = 0;
+				break;
+			}
+			rq->size++;
+		}
+
+		// The slots now hold the same tickets, so the Fenwick tree is rebuilt over them.
+		for (int i = 0; ok && i < rq->slots_used; i++){
+			if (rq->slots[i] != NULL){
+				fenwick_add(rq, i, rq->slots[i]->weight);
+				rq->tickets += rq->slots[i]->weight;
+			}
+		}
+	}
+
+	ok = ok && load_value(in, &s->total_jobs, sizeof(s->total_jobs))
+			&& load_value(in, &s->finished_jobs, sizeof(s->finished_jobs))
+			&& load_value(in, &s->blocked_jobs, sizeof(s->blocked_jobs))
+			&& load_value(in, &s->curr_time, sizeof(s->curr_time))
+			&& load_value(in, &s->waiting_time, sizeof(s->waiting_time))
+			&& load_value(in, &s->response_time, sizeof(s->response_time))
+			&& load_value(in, &s->turnaround_time, sizeof(s->turnaround_time))
+			&& load_value(in, &s->max_waiting_time, sizeof(s->max_waiting_time))
+			&& load_value(in, &s->first_arrival, sizeof(s->first_arrival))
+			&& load_value(in, &s->busy_time, sizeof(s->busy_time))
+			&& load_value(in, &s->rng, sizeof(s->rng))
+			&& load_value(in, &s->total_running_time, sizeof(s->total_running_time))
+			&& load_value(in, &s->total_priority, sizeof(s->total_priority))
+			&& load_value(in, &s->deadline_jobs, sizeof(s->deadline_jobs))
+			&& load_value(in, &s->deadline_misses, sizeof(s->deadline_misses))
+			&& s->deadline_jobs >= 0;
+	if (ok && s->deadline_jobs > 0){
+		s->tardiness_size = s->deadline_jobs;
+		s->tardiness = malloc(s->tardiness_size * sizeof(int));
+		ok = load_value(in, s->tardiness, s->deadline_jobs * sizeof(int));
+	}
+	ok = ok && load_value(in, &s->tardiness_sorted, sizeof(s->tardiness_sorted))
+			&& load_value(in, &s->next_boost, sizeof(s->next_boost))
+			&& load_value(in, s->migration_cost, cores * sizeof(int))
+			&& load_value(in, &s->steals, sizeof(s->steals))
+			&& load_value(in, &s->migrations, sizeof(s->migrations))
+			&& load_value(in, &s->cache_misses, sizeof(s->cache_misses))
+			&& load_value(in, &s->penalty_time, sizeof(s->penalty_time))
+			&& load_value(in, &s->backlog_work, sizeof(s->backlog_work))
+			&& load_value(in, &s->rejected_jobs, sizeof(s->rejected_jobs))
+			&& load_value(in, &s->deferrals, sizeof(s->deferrals))
+			&& load_value(in, &s->admission_delay, sizeof(s->admission_delay))
+			&& load_value(in, &s->buckets_ct, sizeof(s->buckets_ct))
+			&& s->buckets_ct >= 0 && s->buckets_ct <= (1 << 20);
+	if (ok && s->buckets_ct > 0){
+		s->buckets = malloc(s->buckets_ct * sizeof(bucket_t));
+		ok = (s->buckets != NULL && load_value(in, s->buckets, s->buckets_ct * sizeof(bucket_t)));
+	}
+	ok = ok && load_value(in, &magic, sizeof(magic)) && magic == SCHEDULER_SNAPSHOT_MAGIC;
+
+	if (!ok){
+		for (int q = 0; q < s->num_queues; q++){
+			discard_jobs(s, &s->queues[q]);
+		}
+		scheduler_destroy(s);
+		return NULL;
+	}
+
+	if (s->num_queues > 1){
+		for (int n = s->balance_leaves - 1; n > 0; n--){
+			play_match(s, n);
+		}
+	}
+	return s;
+}
+
+
+/**
+  This function may print out any debugging information you choose. This
+  function will be called by the simulator after every call the simulator
+  makes to your scheduler.
+  In our provided output, we have implemented this function to list the jobs in the order they are to be scheduled. Furthermore, we have also listed the current state of the job (either running on a given core or idle). For example, if we have a non-preemptive algorithm and job(id=4) has began running, job(id=2) arrives with a higher priority, and job(id=1) arrives with a lower priority, the output in our sample output will be:
+
+    2(-1) 4(0) 1(-1)
+
+  This function is not required and will not be graded. You may leave it
+  blank if you do not find it useful.
+ */
+void scheduler_show_queue()
+{
+	scheduler_show_queue_r(default_scheduler, stdout);
+}
+
+/**
+  Reentrant form of scheduler_show_queue(), writing to out.
+
+  @param s the scheduler instance
+  @param out the stream to write the queue to
+ */
+void scheduler_show_queue_r(scheduler_t *s, FILE *out)
+{
+	for (int q = 0; q < s->num_queues; q++){
+		runqueue_t* rq = &s->queues[q];
+
+		if (s->scheme == MLFQ){
+			for (int i = 0; i < s->options.levels; i++){
+				show_jobs(&rq->levels[i], out);
+			}
+		}
+		else if (s->scheme == CFS){
+			show_tree(rq->tree.m_root, out);
+			if (rq->tree.m_root != NULL){
+				fprintf(out, "\n");
+			}
+		}
+		else if (uses_heap(s)){
+			show_heap(&rq->heap, out);
+		}
+		else if (s->scheme == LOTTERY){
+			show_slots(rq, out);
+		}
+		else{
+			show_jobs(&rq->queue, out);
+		}
+	}
+}
+
+static void show_jobs(priqueue_t *q, FILE *out)
+{
+	node_t* temp = q->m_front;
+	if (q->m_front != NULL){
+		while (temp != NULL){
+			job_t* job = temp->value;
+			fprintf(out,
+									"ID: %d, arrival_time: %d, start_time: %d, remaining_time: %d, running_time: %d, priority: %d\n"
 									,job->id,job->arrival_time,job->start_time,job->remaining_time,job->running_time,job->priority
 						);
 			temp = temp->next;
 		}
-		printf("\n");
+		fprintf(out, "\n");
+	}
+
+}
+
+/*
+  Lists the jobs of a heap in the order of its array, which starts with the
+  job that runs next but is otherwise only partially sorted.
+ */
+static void show_heap(heap_t *h, FILE *out)
+{
+	for (int i = 0; i < heap_size(h); i++){
+		job_t* job = heap_at(h, i);
+		fprintf(out,
+								"ID: %d, arrival_time: %d, start_time: %d, remaining_time: %d, running_time: %d, priority: %d, deadline: %d\n"
+								,job->id,job->arrival_time,job->start_time,job->remaining_time,job->running_time,job->priority,job->deadline
+					);
+	}
+	if (heap_size(h) > 0){
+		fprintf(out, "\n");
+	}
+}
+
+static void show_slots(runqueue_t *rq, FILE *out)
+{
+	for (int i = 0; i < rq->slots_used; i++){
+		job_t* job = rq->slots[i];
+		if (job != NULL){
+			fprintf(out,
+									"ID: %d, arrival_time: %d, start_time: %d, remaining_time: %d, running_time: %d, priority: %d\n"
+									,job->id,job->arrival_time,job->start_time,job->remaining_time,job->running_time,job->priority
+						);
+		}
+	}
+	if (rq->size > 0){
+		fprintf(out, "\n");
+	}
+}
+
+static void show_tree(rbnode_t *node, FILE *out)
+{
+	if (node == NULL){
+		return;
+	}
+	show_tree(node->left, out);
+	job_t* job = node->value;
+	fprintf(out,
+							"ID: %d, arrival_time: %d, start_time: %d, remaining_time: %d, running_time: %d, priority: %d, vruntime: %.2f\n"
+							,job->id,job->arrival_time,job->start_time,job->remaining_time,job->running_time,job->priority,job->vruntime/(double)CFS_NICE_0_LOAD
+				);
+	show_tree(node->right, out);
+}
+
+static void runqueue_init(scheduler_t *s, runqueue_t *rq, int cores){
+	priqueue_init(&rq->queue,s->comparer);
+	rq->size = 0;
+	rq->cores = cores;
+
+	if (s->scheme == MLFQ){
+		for (int i = 0; i < s->options.levels; i++){
+			priqueue_init(&rq->levels[i],rr);
+		}
+	}
+	rq->nonempty_levels = 0;
+
+	if (s->scheme == CFS){
+		rbtree_init(&rq->tree,cfs);
+	}
+	if (uses_heap(s)){
+		heap_init(&rq->heap,s->comparer);
+	}
+	rq->min_vruntime = 0;
+	rq->load_weight = 0;
+	rq->nr_running = 0;
+
+	rq->slots = NULL;
+	rq->fenwick = NULL;
+	rq->free_slots = NULL;
+	rq->free_count = 0;
+	rq->slots_used = 0;
+	rq->slot_capacity = 0;
+	rq->tickets = 0;
+}
+
+/*
+  The run queue a freed core takes its next job from: its own with per-core
+  queues, and the one of the group furthest behind its share with groups.
+ */
+static runqueue_t *core_queue(scheduler_t *s, int core_id){
+	if (s->neediest != NULL){
+		return &s->queues[s->neediest[1]];
+	}
+	return &s->queues[s->least_loaded != NULL ? core_id : 0];
+}
+
+/*
+  The run queue a new job placed on a core belongs to: that core's with
+  per-core queues, and otherwise the job's group's, the only queue when
+  jobs are not grouped.
+ */
+static int home_queue(scheduler_t *s, job_t *job, int core_id){
+	return (s->least_loaded != NULL ? core_id : job->queue);
+}
+
+/*
+  The run queue a new job that can not run right away waits on. With
+  per-core queues that is the queue with the fewest jobs, counting the one
+  running on its core, and the lowest core among equals.
+ */
+static int least_loaded_queue(scheduler_t *s, job_t *job){
+	return (s->least_loaded != NULL ? s->least_loaded[1] : job->queue);
+}
+
+static int queue_load(scheduler_t *s, int queue){
+	return s->queues[queue].size + (s->active_cores[queue] != 0);
+}
+
+/*
+  Groups: whether group a is further behind its share than group b. Groups
+  with waiting jobs come before those without, and ties go to the lower
+  group.
+ */
+static int group_before(scheduler_t *s, int a, int b){
+	if (b == -1 || a == -1){
+		return b == -1;
+	}
+	if (queue_empty(&s->queues[a]) != queue_empty(&s->queues[b])){
+		return !queue_empty(&s->queues[a]);
+	}
+	return s->groups[a].vtime <= s->groups[b].vtime;
+}
+
+/*
+  Decides node n of the tournament trees from its two children. Per-core
+  queues have two trees, and ties go to the lower core; groups have one.
+ */
+static void play_match(scheduler_t *s, int n){
+	if (s->neediest != NULL){
+		int a = s->neediest[2 * n];
+		int b = s->neediest[2 * n + 1];
+		s->neediest[n] = (group_before(s, a, b) ? a : b);
+		return;
+	}
+
+	int a = s->least_loaded[2 * n];
+	int b = s->least_loaded[2 * n + 1];
+	s->least_loaded[n] = ((b == -1 || (a != -1 && queue_load(s, a) <= queue_load(s, b))) ? a : b);
+
+	a = s->busiest[2 * n];
+	b = s->busiest[2 * n + 1];
+	s->busiest[n] = ((b == -1 || (a != -1 && s->queues[a].size >= s->queues[b].size)) ? a : b);
+}
+
+/*
+  Replays the matches on the way from a queue, whose load or group's share
+  just changed, to the roots.
+ */
+static void update_balance(scheduler_t *s, int queue){
+	if (s->num_queues == 1){
+		return;
+	}
+
+	for (int n = (s->balance_leaves + queue) / 2; n > 0; n /= 2){
+		play_match(s, n);
+	}
+}
+
+/*
+  Makes a new job part of a run queue. Under CFS it starts level with the
+  least served runnable job of that queue instead of at zero, so that it
+  can not monopolize the cores to catch up; the same goes for the pass of
+  a STRIDE job, and for a group that had no jobs. A job back from I/O keeps
+  what it had unless that fell behind the queue.
+ */
+static void join_queue(scheduler_t *s, job_t *job, int queue){
+	job->queue = queue;
+
+	if (s->groups != NULL){
+		group_t* g = &s->groups[queue];
+		if (g->alive++ == 0 && g->vtime < s->min_group_vtime){
+			g->vtime = s->min_group_vtime;
+			update_balance(s, queue);
+		}
+	}
+
+	if (s->scheme == STRIDE && job->vruntime < s->queues[queue].min_vruntime){
+		job->vruntime = s->queues[queue].min_vruntime;
+	}
+
+	if (s->scheme == CFS){
+		runqueue_t* rq = &s->queues[queue];
+		if (job->vruntime < rq->min_vruntime){
+			job->vruntime = rq->min_vruntime;
+		}
+		rq->load_weight += job->weight;
+		rq->nr_running++;
+	}
+}
+
+/*
+  Places a job on a core. A job that ran on another core before pays the
+  cache penalty. That and any migration cost the job carries are added to
+  its remaining time and reported through scheduler_migration_cost_r().
+ */
+static void dispatch(scheduler_t *s, int core_id, job_t *job, int time){
+	if (job->start_time == -1){
+		job->start_time = time;
+	}
+	s->active_cores[core_id] = job;
+	set_idle(s, core_id, 0);
+	if (s->least_loaded != NULL){
+		update_balance(s, core_id);
+	}
+	if (s->neediest != NULL){
+		group_t* g = &s->groups[s->neediest[1]];
+		if (!queue_empty(&s->queues[s->neediest[1]]) && g->vtime > s->min_group_vtime){
+			s->min_group_vtime = g->vtime;
+		}
+	}
+
+	if (job->last_core != -1 && job->last_core != core_id){
+		s->cache_misses++;
+		job->penalty += s->options.cache_penalty;
+	}
+	job->last_core = core_id;
+
+	if (job->penalty > 0){
+		job->remaining_time += job->penalty;
+		s->backlog_work += job->penalty;
+		s->migration_cost[core_id] += job->penalty;
+		s->penalty_time += job->penalty;
+		job->penalized += job->penalty;
+		job->penalty = 0;
+	}
+}
+
+static void set_idle(scheduler_t *s, int core_id, int idle){
+	int rank = s->core_rank[core_id];
+
+	if (((s->idle_cores[core_id / 64] >> (core_id % 64)) & 1) != (unsigned long long)idle){
+		s->running_jobs += (idle ? -1 : 1);
+	}
+
+	if (idle){
+		s->idle_cores[core_id / 64] |= 1ULL << (core_id % 64);
+		s->idle_ranked[rank / 64] |= 1ULL << (rank % 64);
+	}
+	else{
+		s->idle_cores[core_id / 64] &= ~(1ULL << (core_id % 64));
+		s->idle_ranked[rank / 64] &= ~(1ULL << (rank % 64));
+	}
+}
+
+static int compare_int(const void *a, const void *b){
+	return *(const int*)a - *(const int*)b;
+}
+
+/*
+  Whether the run queues are heaps rather than sorted lists.
+ */
+static int uses_heap(scheduler_t *s){
+	return s->scheme == EDF || s->scheme == PEDF || s->scheme == STRIDE;
+}
+
+static int compare_speed(const void *a, const void *b){
+	long long key_a = *(const long long*)a;
+	long long key_b = *(const long long*)b;
+	return (key_a < key_b ? -1 : key_a > key_b);
+}
+
+/*
+  Returns the idle core a job should go to, or -1 if every core is busy.
+  That is the core the job last ran on if affinity is preferred and it is
+  idle, and otherwise the idle core the placement policy asks for. Jobs not
+  meant for fast cores take the slowest idle core, the highest bit set by
+  rank, to leave the fast ones free.
+ */
+static int pick_idle_core(scheduler_t *s, job_t *job){
+	int words = (s->num_cores + 63) / 64;
+
+	if (s->options.affinity > 0 && job->last_core != -1 && s->active_cores[job->last_core] == 0){
+		return job->last_core;
+	}
+
+	if (s->options.placement != PLACE_LOWEST){
+		int fast = 1;
+		if (s->options.placement == PLACE_SHORT){
+			fast = ((long long)job->running_time * s->total_jobs <= s->total_running_time);
+		}
+		else if (s->options.placement == PLACE_PRIORITY){
+			fast = ((long long)job->priority * s->total_jobs <= s->total_priority);
+		}
+
+		if (fast){
+			for (int i = 0; i < words; i++){
+				if (s->idle_ranked[i] != 0){
+					return s->rank_core[i * 64 + __builtin_ctzll(s->idle_ranked[i])];
+				}
+			}
+		}
+		else{
+			for (int i = words - 1; i >= 0; i--){
+				if (s->idle_ranked[i] != 0){
+					return s->rank_core[i * 64 + 63 - __builtin_clzll(s->idle_ranked[i])];
+				}
+			}
+		}
+		return -1;
+	}
+
+	for (int i = 0; i < words; i++){
+		if (s->idle_cores[i] != 0){
+			return i * 64 + __builtin_ctzll(s->idle_cores[i]);
+		}
+	}
+	return -1;
+}
+
+/*
+  Removes and returns the job a freed core should run next. That is the job
+  at the head of the run queue, unless affinity is preferred, the head ran
+  on another core before, and one of the next jobs within the affinity
+  window last ran on this core; that job is taken instead, so that it finds
+  its cache warm. Under MLFQ only the highest non-empty level is looked
+  through. A heap keeps no order past its head and a lottery none at all,
+  so EDF, STRIDE and LOTTERY always take the job they would anyway.
+ */
+static job_t *pick_next(scheduler_t *s, runqueue_t *rq, int core_id){
+	int window = s->options.affinity;
+	job_t* head;
+
+	if (window <= 0 || uses_heap(s) || s->scheme == LOTTERY){
+		return dequeue(s, rq);
+	}
+
+	if (s->scheme == CFS){
+		rbnode_t* node = rbtree_first(&rq->tree);
+		head = node->value;
+		if (head->last_core == -1 || head->last_core == core_id){
+			return dequeue(s, rq);
+		}
+
+		for (int i = 0; i < window && (node = rbtree_next(node)) != NULL; i++){
+			job_t* job = node->value;
+			if (job->last_core == core_id){
+				if (head->vruntime > rq->min_vruntime){
+					rq->min_vruntime = head->vruntime;
+				}
+				rbtree_remove(&rq->tree, job);
+				rq->size--;
+				update_balance(s, rq - s->queues);
+				return job;
+			}
+		}
+		return dequeue(s, rq);
+	}
+
+	int level = (s->scheme == MLFQ ? __builtin_ctzll(rq->nonempty_levels) : 0);
+	priqueue_t* q = (s->scheme == MLFQ ? &rq->levels[level] : &rq->queue);
+	node_t* node = q->m_front;
+
+	head = node->value;
+	if (head->last_core == -1 || head->last_core == core_id){
+		return dequeue(s, rq);
+	}
+
+	node = node->next;
+	for (int i = 1; i <= window && node != NULL; i++, node = node->next){
+		job_t* job = node->value;
+		if (job->last_core == core_id){
+			priqueue_remove_at(q, i);
+			rq->size--;
+			update_balance(s, rq - s->queues);
+			return job;
+		}
+	}
+	return dequeue(s, rq);
+}
+
+/*
+  Per-core queues: moves half of the jobs waiting on the busiest queue, the
+  ones that would run there first, to the queue of an idle core, so that a
+  single steal evens the two out. Every job moved is a migration and pays
+  the migration cost when it next runs.
+ */
+static void steal(scheduler_t *s, int core_id){
+	runqueue_t* busiest = &s->queues[s->busiest[1]];
+	runqueue_t* rq = core_queue(s, core_id);
+
+	if (busiest->size == 0){
+		return;
+	}
+
+	int count = (busiest->size + 1) / 2;
+	for (int i = 0; i < count; i++){
+		job_t* job = dequeue(s, busiest);
+
+		if (s->scheme == CFS || s->scheme == STRIDE){
+			job->vruntime += rq->min_vruntime - busiest->min_vruntime;
+		}
+		if (s->scheme == CFS){
+			busiest->load_weight -= job->weight;
+			busiest->nr_running--;
+			rq->load_weight += job->weight;
+			rq->nr_running++;
+		}
+		job->queue = rq - s->queues;
+		job->penalty += s->options.migration_cost;
+		enqueue(s,job);
+	}
+
+	s->steals++;
+	s->migrations += count;
+}
+
+/*
+  Adds a job to its run queue. MLFQ jobs go to the back of the FIFO of their
+  level; CFS jobs go into the tree by virtual runtime.
+ */
+static void enqueue(scheduler_t *s, job_t *job){
+	runqueue_t* rq = &s->queues[job->queue];
+
+	rq->size++;
+	update_balance(s, job->queue);
+	if (s->scheme == CFS){
+		rbtree_insert(&rq->tree,job);
+	}
+	else if (uses_heap(s)){
+		heap_offer(&rq->heap,job);
+	}
+	else if (s->scheme == LOTTERY){
+		lottery_add(rq,job);
+	}
+	else if (s->scheme == MLFQ){
+		priqueue_offer(&rq->levels[job->level],job);
+		rq->nonempty_levels |= 1ULL << job->level;
+	}
+	else{
+		priqueue_offer(&rq->queue,job);
+	}
+}
+
+/*
+  Removes and returns the job that should run next, or NULL if no job is
+  waiting. Under MLFQ the lowest set bit of the level bitmap is the highest
+  non-empty level, so picking a level does not depend on the number of
+  levels or jobs. Under CFS the leftmost job of the tree is cached, and taking
+  it out costs O(log n), as does taking the head of an EDF or STRIDE heap
+  or drawing a LOTTERY ticket.
+ */
+static job_t *dequeue(scheduler_t *s, runqueue_t *rq){
+	if (rq->size == 0){
+		return NULL;
+	}
+	rq->size--;
+	update_balance(s, rq - s->queues);
+
+	if (s->scheme == CFS){
+		job_t* job = rbtree_poll(&rq->tree);
+		if (job->vruntime > rq->min_vruntime){
+			rq->min_vruntime = job->vruntime;
+		}
+		return job;
+	}
+	if (s->scheme == MLFQ){
+		int level = __builtin_ctzll(rq->nonempty_levels);
+		job_t* job = priqueue_poll(&rq->levels[level]);
+		if (rq->levels[level].m_front == NULL){
+			rq->nonempty_levels &= ~(1ULL << level);
+		}
+		return job;
+	}
+	if (uses_heap(s)){
+		job_t* job = heap_poll(&rq->heap);
+		if (job->vruntime > rq->min_vruntime){
+			rq->min_vruntime = job->vruntime;
+		}
+		return job;
+	}
+	if (s->scheme == LOTTERY){
+		return lottery_draw(s, rq);
+	}
+	return priqueue_poll(&rq->queue);
+}
+
+/*
+  LOTTERY: gives a job a slot, reusing a freed one if there is any. When the
+  slots run out their number doubles, and the Fenwick tree is rebuilt over
+  them in O(n).
+ */
+static void lottery_add(runqueue_t *rq, job_t *job){
+	int slot;
+
+	if (rq->free_count > 0){
+		slot = rq->free_slots[--rq->free_count];
+	}
+	else{
+		if (rq->slots_used == rq->slot_capacity){
+			int capacity = (rq->slot_capacity > 0 ? 2 * rq->slot_capacity : 64);
+
+			rq->slots = realloc(rq->slots, capacity * sizeof(job_t*));
+			rq->free_slots = realloc(rq->free_slots, capacity * sizeof(int));
+			rq->fenwick = realloc(rq->fenwick, (capacity + 1) * sizeof(long long));
+			for (int i = rq->slot_capacity; i < capacity; i++){
+				rq->slots[i] = NULL;
+			}
+			rq->slot_capacity = capacity;
+
+			for (int i = 1; i <= capacity; i++){
+				rq->fenwick[i] = (rq->slots[i - 1] != NULL ? rq->slots[i - 1]->weight : 0);
+			}
+			for (int i = 1; i <= capacity; i++){
+				int parent = i + (i & -i);
+				if (parent <= capacity){
+					rq->fenwick[parent] += rq->fenwick[i];
+				}
+			}
+		}
+		slot = rq->slots_used++;
+	}
+
+	rq->slots[slot] = job;
+	job->slot = slot;
+	fenwick_add(rq, slot, job->weight);
+	rq->tickets += job->weight;
+}
+
+/*
+  LOTTERY: draws one of the tickets of the waiting jobs and removes the job
+  holding it. Walking down the Fenwick tree finds the slot whose tickets
+  cover the one drawn without summing over the slots before it.
+ */
+static job_t *lottery_draw(scheduler_t *s, runqueue_t *rq){
+	uint64_t z = (s->rng += 0x9e3779b97f4a7c15ULL);
+	z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+	z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+	long long ticket = (long long)((z ^ (z >> 31)) % (uint64_t)rq->tickets);
+
+	int slot = 0;
+	for (int step = 1 << (31 - __builtin_clz(rq->slot_capacity)); step > 0; step >>= 1){
+		if (slot + step <= rq->slot_capacity && rq->fenwick[slot + step] <= ticket){
+			slot += step;
+			ticket -= rq->fenwick[slot];
+		}
+	}
+
+	job_t* job = rq->slots[slot];
+	rq->slots[slot] = NULL;
+	rq->free_slots[rq->free_count++] = slot;
+	fenwick_add(rq, slot, -job->weight);
+	rq->tickets -= job->weight;
+	return job;
+}
+
+static void fenwick_add(runqueue_t *rq, int slot, long long tickets){
+	for (int i = slot + 1; i <= rq->slot_capacity; i += i & -i){
+		rq->fenwick[i] += tickets;
+	}
+}
+
+static int queue_empty(runqueue_t *rq){
+	return rq->size == 0;
+}
+
+/*
+  Decides whether a new job is admitted: while fewer jobs than the limit
+  wait or a core is idle, while the work left on the runnable jobs and the
+  new one stays within the limit or nothing is runnable, or while the
+  bucket of its priority class holds a token.
+ */
+static int admit(scheduler_t *s, int time, int running_time, int priority){
+	int runnable = s->total_jobs - s->finished_jobs - s->blocked_jobs;
+
+	switch (s->options.admission){
+		case ADMIT_QUEUE:
+			return (runnable - s->running_jobs < s->options.admission_limit || s->running_jobs < s->num_cores);
+		case ADMIT_BACKLOG:
+			return (s->backlog_work + running_time <= s->options.admission_limit || runnable == 0);
+		case ADMIT_TOKENS:
+			return take_token(s, time, priority);
+		default:
+			return 1;
+	}
+}
+
+/*
+  Takes a token from the bucket of a priority class, if it holds one,
+  after filling it for the time since it was last looked at. A class seen
+  for the first time starts with a full bucket. There are few classes, so
+  the buckets sit in an array sorted by priority.
+ */
+static int take_token(scheduler_t *s, int time, int priority){
+	int rate = (s->options.admission_rate > 0 ? s->options.admission_rate : 1);
+	long long full = (long long)s->options.admission_limit * rate;
+	int lo = 0, hi = s->buckets_ct;
+
+	while (lo < hi){
+		int mid = (lo + hi) / 2;
+		if (s->buckets[mid].priority < priority){
+			lo = mid + 1;
+		}
+		else{
+			hi = mid;
+		}
+	}
+
+	if (lo == s->buckets_ct || s->buckets[lo].priority != priority){
+		s->buckets = realloc(s->buckets, (s->buckets_ct + 1) * sizeof(bucket_t));
+		memmove(&s->buckets[lo + 1], &s->buckets[lo], (s->buckets_ct - lo) * sizeof(bucket_t));
+		s->buckets_ct++;
+		s->buckets[lo].priority = priority;
+		s->buckets[lo].updated = time;
+		s->buckets[lo].level = full;
+	}
+
+	bucket_t* bucket = &s->buckets[lo];
+	bucket->level += time - bucket->updated;
+	if (bucket->level > full){
+		bucket->level = full;
+	}
+	bucket->updated = time;
+
+	if (bucket->level < rate){
+		return 0;
+	}
+	bucket->level -= rate;
+	return 1;
+}
+
+/*
+  MLFQ: once every boost period, moves every job back to the top level so
+  that long running jobs demoted to the bottom cannot starve.
+ */
+static void boost_levels(scheduler_t *s, int time){
+	if (s->scheme != MLFQ || s->options.boost <= 0 || time < s->next_boost){
+		return;
+	}
+
+	for (int q = 0; q < s->num_queues; q++){
+		runqueue_t* rq = &s->queues[q];
+
+		for (int i = 1; i < s->options.levels; i++){
+			job_t* job;
+			while ((job = priqueue_poll(&rq->levels[i])) != NULL){
+				job->level = 0;
+				priqueue_offer(&rq->levels[0],job);
+				rq->nonempty_levels |= 1ULL;
+			}
+		}
+		rq->nonempty_levels &= 1ULL;
+	}
+
+	for (int i = 0; i < s->num_cores; i++){
+		if (s->active_cores[i] != 0){
+			s->active_cores[i]->level = 0;
+		}
+	}
+
+	s->next_boost = (time / s->options.boost + 1) * s->options.boost;
+}
+
+/*
+  CFS: the slice of a job is its weighted share of the scheduling period.
+  The period is the target latency, stretched when there are so many jobs
+  that their slices would drop below the minimum granularity. A run queue
+  shared by several cores offers that many times as much CPU time per
+  period.
+ */
+static int cfs_slice(scheduler_t *s, runqueue_t *rq, job_t *job){
+	long long period = s->options.latency;
+	if (rq->nr_running > s->options.latency / s->options.min_granularity){
+		period = (long long)rq->nr_running * s->options.min_granularity;
 	}
 
+	long long slice = period * rq->cores * job->weight / rq->load_weight;
+	if (slice > period){
+		slice = period;
+	}
+	if (slice < s->options.min_granularity){
+		slice = s->options.min_granularity;
+	}
+	return (int)slice;
 }
 
-void update_remaining_time(int time){
-	for (int i = 0; i < num_cores; i++){
-		if (active_cores[i] != 0){
-			active_cores[i]->remaining_time -= time - curr_time;
+static void update_remaining_time(scheduler_t *s, int time){
+	int elapsed = time - s->curr_time;
+
+	// Many events may share a time unit; only the first has anything to do.
+	if (elapsed == 0){
+		return;
+	}
+
+	for (int i = 0; i < s->num_cores; i++){
+		if (s->active_cores[i] != 0){
+			job_t* job = s->active_cores[i];
+
+			// Work is done in thousandths; the fraction left over carries on.
+			long long work = (long long)elapsed * s->speeds[i] + job->progress;
+			job->remaining_time -= work / SCHEDULER_SPEED_UNIT;
+			s->backlog_work -= work / SCHEDULER_SPEED_UNIT;
+			job->progress = work % SCHEDULER_SPEED_UNIT;
+			job->core_time += elapsed;
+			s->busy_time += elapsed;
+			// A running job does not age; it would rank as if it had just been queued.
+			job->aged_priority = (long long)job->priority * s->options.aging + time;
+			// A STRIDE job's pass advances by its stride, the same constant over its tickets.
+			if (s->scheme == CFS || s->scheme == STRIDE){
+				job->vruntime += (long long)elapsed * CFS_NICE_0_LOAD * CFS_NICE_0_LOAD / job->weight;
+			}
+			if (s->groups != NULL){
+				group_t* g = &s->groups[job->queue];
+				g->vtime += (long long)elapsed * CFS_NICE_0_LOAD / g->weight;
+				g->cpu_time += elapsed;
+				update_balance(s, job->queue);
+			}
 		}
 	}
-	curr_time = time;
+	s->curr_time = time;
 }
 
 int fcfs(const void *a, const void *b){
@@ -421,3 +2814,87 @@ int rr(const void *a, const void *b){
 	}
 	return 1;
 }
+
+int mlfq(const void *a, const void *b){
+	job_t* job_a = (job_t*)a;
+	job_t* job_b = (job_t*)b;
+	
+	if (job_a->id == job_b->id){
+		return 0;
+	}
+	if (job_a->level != job_b->level){
+		return job_a->level - job_b->level;
+	}
+	else{
+		return job_a->arrival_time - job_b->arrival_time;
+	}
+}
+
+/*
+  CFS: smallest virtual runtime first. Ties, such as jobs that arrived at the
+  same minimum virtual runtime, go by arrival and then by id so that the
+  order is total and stable.
+ */
+int cfs(const void *a, const void *b){
+	job_t* job_a = (job_t*)a;
+	job_t* job_b = (job_t*)b;
+	
+	if (job_a->id == job_b->id){
+		return 0;
+	}
+	if (job_a->vruntime != job_b->vruntime){
+		return (job_a->vruntime < job_b->vruntime ? -1 : 1);
+	}
+	if (job_a->arrival_time != job_b->arrival_time){
+		return job_a->arrival_time - job_b->arrival_time;
+	}
+	return job_a->id - job_b->id;
+}
+
+/*
+  EDF: earliest deadline first, with jobs that have no deadline after all
+  that do. Ties go by arrival and then by id, so that the order is total
+  and a heap always yields the same job.
+ */
+int edf(const void *a, const void *b){
+	job_t* job_a = (job_t*)a;
+	job_t* job_b = (job_t*)b;
+	
+	if (job_a->id == job_b->id){
+		return 0;
+	}
+	if (job_a->deadline != job_b->deadline){
+		if (job_a->deadline == 0 || job_b->deadline == 0){
+			return (job_a->deadline == 0 ? 1 : -1);
+		}
+		return job_a->deadline - job_b->deadline;
+	}
+	if (job_a->arrival_time != job_b->arrival_time){
+		return job_a->arrival_time - job_b->arrival_time;
+	}
+	return job_a->id - job_b->id;
+}
+
+/*
+  PRI and PPRI with aging: a waiting job gains one level of priority every
+  aging time units, so its effective priority is
+
+    priority - (epoch - enqueued) / aging
+
+  with the epoch being the current time. The epoch is the same for every
+  job, so comparing two jobs only needs priority * aging + enqueued, which
+  is fixed from the moment a job is queued. The queue therefore stays in
+  order as time goes by, without ever being re-sorted.
+ */
+int aged(const void *a, const void *b){
+	job_t* job_a = (job_t*)a;
+	job_t* job_b = (job_t*)b;
+	
+	if (job_a->id == job_b->id){
+		return 0;
+	}
+	if (job_a->aged_priority != job_b->aged_priority){
+		return (job_a->aged_priority < job_b->aged_priority ? -1 : 1);
+	}
+	return job_a->arrival_time - job_b->arrival_time;
+}
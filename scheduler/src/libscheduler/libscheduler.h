@@ -4,21 +4,172 @@
 #ifndef LIBSCHEDULER_H_
 #define LIBSCHEDULER_H_
 
+#include <stdio.h>
+
+#include "../libpriqueue/libpriqueue.h"
+
 /**
   Constants which represent the different scheduling algorithms
 */
-typedef enum {FCFS = 0, SJF, PSJF, PRI, PPRI, RR} scheme_t;
+typedef enum {FCFS = 0, SJF, PSJF, PRI, PPRI, RR, MLFQ, CFS, EDF, PEDF, STRIDE, LOTTERY} scheme_t;
+
+/**
+  Where a new job goes when several cores are idle
+*/
+typedef enum {PLACE_LOWEST = 0, PLACE_FASTEST, PLACE_SHORT, PLACE_PRIORITY} placement_t;
+
+/**
+  Which arriving jobs are admitted: every one, or while fewer jobs than a
+  limit wait, while the estimated work left on the runnable jobs stays
+  within a limit, or while the token bucket of the job's priority class
+  holds a token
+*/
+typedef enum {ADMIT_ALL = 0, ADMIT_QUEUE, ADMIT_BACKLOG, ADMIT_TOKENS} admission_t;
+
+/**
+  Returned by scheduler_new_job() for a job the admission policy turned
+  away for good, and for one it deferred, which the caller should offer
+  again later
+*/
+#define SCHEDULER_REJECTED -2
+#define SCHEDULER_DEFERRED -3
+
+/**
+  Returned by scheduler_job_blocked() when the job is not the one running
+  on the core, in which case nothing changes
+*/
+#define SCHEDULER_MISMATCH -4
+
+#define SCHEDULER_MAX_LEVELS 64
+
+/**
+  Core speeds are given in thousandths of the nominal speed, at which a job
+  does one time unit of work per time unit.
+*/
+#define SCHEDULER_SPEED_UNIT 1000
+
+/**
+  Parameters of the schemes that need more than a comparison function.
+  Fill in with scheduler_options_init() and then override the fields of
+  interest.
+*/
+typedef struct _scheduler_options_t
+{
+	int quantum;                              ///< RR, STRIDE and LOTTERY: time units per slice
+	unsigned int seed;                        ///< LOTTERY: seed of the ticket draws
+	int levels;                               ///< MLFQ: number of levels, at most SCHEDULER_MAX_LEVELS
+	int level_quantum[SCHEDULER_MAX_LEVELS];  ///< MLFQ: time units per slice on each level
+	int boost;                                ///< MLFQ: time units between priority boosts, 0 for none
+	int aging;                                ///< PRI and PPRI: time units of waiting that raise a job's priority by one, 0 for none
+	int latency;                              ///< CFS: time units in which every runnable job should run once
+	int min_granularity;                      ///< CFS: shortest time slice a job is given
+	int per_core_queues;                      ///< Give every core its own run queue, with idle cores stealing work
+	int migration_cost;                       ///< Time units a job loses each time it moves to another core's queue
+	int cache_penalty;                        ///< Time units a job loses to a cold cache when it resumes on a core other than its last
+	int affinity;                             ///< Waiting jobs a freed core looks through for one that last ran on it, 0 for none
+	const int *speeds;                        ///< Speed of each core in SCHEDULER_SPEED_UNITs, NULL when every core runs at nominal speed
+	placement_t placement;                    ///< Which idle core a new job is placed on
+	int groups;                               ///< Groups of jobs the cores are shared between by weight, each with its own run queue, 0 for none
+	const int *group_weights;                 ///< Weight of each group, NULL when every group weighs 1
+	admission_t admission;                    ///< Which arriving jobs are admitted
+	int admission_limit;                      ///< Most jobs waiting, most time units of work left on the runnable jobs, or tokens a bucket holds
+	int admission_rate;                       ///< ADMIT_TOKENS: time units it takes a bucket to gain a token
+	int admission_defer;                      ///< Defer the jobs not admitted rather than reject them
+} scheduler_options_t;
+
+/**
+  Attributes of a job beyond its running time and priority. Fill in with
+  scheduler_job_attr_init() and then override the fields of interest.
+*/
+typedef struct _scheduler_job_attr_t
+{
+	int deadline;                             ///< Time by which the job should have finished, 0 for none
+	int group;                                ///< Group the job belongs to when the cores are shared between groups
+	int arrival_time;                         ///< Time a deferred job first arrived, -1 for a job arriving now
+} scheduler_job_attr_t;
+
+/**
+  The state of a scheduler instance at one point in time, as filled in by
+  scheduler_stats_snapshot_r(). The averages are over the jobs finished so
+  far, so unlike scheduler_average_waiting_time() and its kin they make
+  sense while jobs are still running.
+*/
+typedef struct _scheduler_stats_t
+{
+	int time;                                 ///< Time the snapshot was taken at
+	int arrived_jobs;                         ///< Jobs that have arrived so far
+	int finished_jobs;                        ///< Jobs that have finished so far
+	int running_jobs;                         ///< Jobs running on a core
+	int waiting_jobs;                         ///< Jobs waiting in a run queue
+	int blocked_jobs;                         ///< Jobs blocked on I/O
+	long long busy_time;                      ///< Time units the cores spent running jobs, added up over the cores
+	float cpu_utilization;                    ///< Share of the cores' time since the first arrival spent running jobs, from 0 to 1
+	float average_waiting_time;               ///< Average waiting time of the finished jobs
+	float average_turnaround_time;            ///< Average turnaround time of the finished jobs
+	float average_response_time;              ///< Average response time of the finished jobs
+	int deadline_misses;                      ///< Finished jobs that missed their deadline
+} scheduler_stats_t;
+
+/**
+  A scheduler instance. Every instance is independent of every other, so
+  instances may be driven concurrently from different threads.
+*/
+typedef struct _scheduler_t scheduler_t;
 
 void  scheduler_start_up               (int cores, scheme_t scheme);
 int   scheduler_new_job                (int job_number, int time, int running_time, int priority);
 int   scheduler_job_finished           (int core_id, int job_number, int time);
+int   scheduler_job_blocked            (int core_id, int job_number, int time);
+int   scheduler_job_woke               (int job_number, int time, int running_time);
 int   scheduler_quantum_expired        (int core_id, int time);
 float scheduler_average_turnaround_time();
 float scheduler_average_waiting_time   ();
 float scheduler_average_response_time  ();
+void  scheduler_stats_snapshot         (int time, scheduler_stats_t *stats);
 void  scheduler_clean_up               ();
 
 void  scheduler_show_queue             ();
-void update_remaining_time();
+
+void         scheduler_options_init             (scheduler_options_t *options);
+void         scheduler_job_attr_init            (scheduler_job_attr_t *attr);
+scheduler_t *scheduler_create                   (int cores, scheme_t scheme, const scheduler_options_t *options);
+int          scheduler_new_job_r                (scheduler_t *s, int job_number, int time, int running_time, int priority);
+int          scheduler_new_job_attr_r           (scheduler_t *s, int job_number, int time, int running_time, int priority, const scheduler_job_attr_t *attr);
+int          scheduler_job_finished_r           (scheduler_t *s, int core_id, int job_number, int time);
+int          scheduler_job_blocked_r            (scheduler_t *s, int core_id, int job_number, int time);
+int          scheduler_job_woke_r               (scheduler_t *s, int job_number, int time, int running_time);
+int          scheduler_quantum_expired_r        (scheduler_t *s, int core_id, int time);
+int          scheduler_quantum_r                (scheduler_t *s, int core_id);
+int          scheduler_migration_cost_r         (scheduler_t *s, int core_id);
+int          scheduler_steals_r                 (scheduler_t *s);
+int          scheduler_migrations_r             (scheduler_t *s);
+int          scheduler_queue_stats_r            (scheduler_t *s, priqueue_stats_t *stats);
+int          scheduler_cache_misses_r           (scheduler_t *s);
+int          scheduler_penalty_time_r           (scheduler_t *s);
+int          scheduler_core_speed_r             (scheduler_t *s, int core_id);
+int          scheduler_deadline_jobs_r          (scheduler_t *s);
+int          scheduler_deadline_misses_r        (scheduler_t *s);
+int          scheduler_tardiness_percentile_r   (scheduler_t *s, float percentile);
+int          scheduler_rejected_jobs_r          (scheduler_t *s);
+int          scheduler_deferrals_r              (scheduler_t *s);
+float        scheduler_average_admission_delay_r(scheduler_t *s);
+int          scheduler_max_waiting_time_r       (scheduler_t *s);
+float        scheduler_cpu_utilization_r        (scheduler_t *s);
+long long    scheduler_busy_time_r              (scheduler_t *s);
+int          scheduler_group_weight_r           (scheduler_t *s, int group);
+int          scheduler_group_jobs_r             (scheduler_t *s, int group);
+long long    scheduler_group_cpu_time_r         (scheduler_t *s, int group);
+float        scheduler_group_average_waiting_time_r   (scheduler_t *s, int group);
+float        scheduler_group_average_turnaround_time_r(scheduler_t *s, int group);
+float        scheduler_group_average_response_time_r  (scheduler_t *s, int group);
+float        scheduler_average_turnaround_time_r(scheduler_t *s);
+float        scheduler_average_waiting_time_r   (scheduler_t *s);
+float        scheduler_average_response_time_r  (scheduler_t *s);
+void         scheduler_stats_snapshot_r         (scheduler_t *s, int time, scheduler_stats_t *stats);
+void         scheduler_show_queue_r             (scheduler_t *s, FILE *out);
+void         scheduler_destroy                  (scheduler_t *s);
+
+int          scheduler_save_r                   (scheduler_t *s, FILE *out);
+scheduler_t *scheduler_restore                  (FILE *in);
 
 #endif /* LIBSCHEDULER_H_ */
@@ -0,0 +1,2350 @@
+/** @file libsimulator.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <ctype.h>
+#include <math.h>
+#include <assert.h>
+
+#include "libsimulator.h"
+#include "../libheap/libheap.h"
+
+
+typedef struct _simulator_job_list_t
+{
+	int job_id, arrival_time, run_time, priority, deadline, group;
+	int core_id, arrived, first_run;
+	int progress;
+	int *bursts, burst_ct, next_burst;
+} simulator_job_list_t;
+
+typedef struct _simulator_order_t
+{
+	int key, job_id;
+} simulator_order_t;
+
+static int compare_order(const void *a, const void *b);
+static int write_checkpoint(simulator_t *sim);
+static void write_series(simulator_t *sim, int time, int last);
+static void log_event(simulator_t *sim, event_type_t type, int job_id, int core_id);
+
+/**
+  Stores the complete state of one simulation.
+*/
+struct _simulator_t
+{
+	scheduler_t *scheduler;
+	scheme_t scheme;
+	scheduler_options_t options;
+	int cores;
+
+	simulator_job_list_t *jobs;
+	int jobs_ct;
+	int total_jobs;
+	int active_jobs;
+	int jobs_alive;
+	int time;
+	int has_deadlines;
+	int has_bursts;
+
+	/* Time units of work left on the jobs not yet finished, and a time not to skip past, -1 for none */
+	long long backlog;
+	int horizon;
+
+	/* Jobs blocked on I/O, and when each finishes it, earliest first */
+	int jobs_blocked;
+	heap_t io;
+
+	/*
+	 * Indexes that spare each time unit from scanning every job: where each
+	 * job sits in jobs (-1 once finished), which job each core runs (-1 when
+	 * idle) and the jobs that have yet to arrive, by arrival time.
+	 */
+	int *position;
+	int *core_job;
+	simulator_order_t *arrivals;
+	int arrivals_ct;
+	int next_arrival;
+	int arrivals_sorted;
+
+	int *quantum_clock;
+
+	FILE *trace;
+	int show_queue;
+	char **core_timing_diagram;
+	int *core_timing_diagram_len;
+	int *core_timing_diagram_size;
+
+	/*
+	 * Snapshots: how often to write one and where, and whether this
+	 * simulation was restored from one, with its own copy of the core
+	 * speeds if so.
+	 */
+	int checkpoint_every;
+	int next_checkpoint;
+	const char *checkpoint_path;
+	int resumed;
+	int *speeds;
+
+	/*
+	 * Time series: where to write a row every so many time units, when the
+	 * current window started, the busy time of the cores then, and the
+	 * response times of the jobs that finished in it.
+	 */
+	FILE *series;
+	int series_every;
+	int next_series;
+	int series_start;
+	long long series_busy;
+	int *series_responses;
+	int series_responses_ct;
+	int series_responses_size;
+
+	/* Binary log of every scheduling event, or NULL for none */
+	eventlog_t *events;
+
+	/* Function told of every scheduling event as it happens, or NULL, and what it is passed */
+	simulator_listener_t listener;
+	void *listener_context;
+
+	/* Where the response and turnaround time of each job go when it finishes, or NULL */
+	int *response_times;
+	int *turnaround_times;
+
+	/* Jobs the scheduler deferred, by job number, in the order they arrived */
+	int *deferred;
+	int deferred_ct;
+	int deferred_size;
+};
+
+
+/**
+  Reads a workload file. The first line is a header and is ignored; every
+  other line holds the arrival time, running time and priority of a job,
+  optionally followed by its deadline, the time by which it should finish,
+  or 0 for none, then by the group it belongs to and then by the number of
+  cores it needs at the same time. A job that does I/O
+  gives its bursts in place of the running time, separated by semicolons:
+  5;3;2 runs for 5 time units, blocks on I/O for 3 and then runs for 2.
+
+  @param file the workload file
+  @param count receives the number of jobs read, or -1 if the file is not
+  in the expected format
+  @return an array of count jobs, which the caller must free with
+  simulator_free_jobs()
+  @return NULL if the file is not in the expected format or memory ran out
+ */
+simulator_job_t *simulator_read_jobs(FILE *file, int *count)
+{
+	int job_id = 0;
+	int jobs_ct = 10;
+	simulator_job_t *jobs = malloc(jobs_ct * sizeof(simulator_job_t));
+
+	*count = -1;
+
+	char line[1024 + 1];
+	if (fgets(line, 1024, file) == NULL)  // Ignore the first (header) line
+	{
+		*count = 0;
+		return jobs;
+	}
+
+	while (fgets(line, 1024, file) != NULL)
+	{
+		char *save;
+		char *arrival_time = strtok_r(line, ",", &save);
+		char *run_time = strtok_r(NULL, ",", &save);
+		char *priority = strtok_r(NULL, ",", &save);
+		char *deadline = strtok_r(NULL, ",", &save);
+		char *group = strtok_r(NULL, ",", &save);
+		char *cores = strtok_r(NULL, ",", &save);
+
+		if (arrival_time != NULL && run_time != NULL && priority != NULL)
+		{
+			if (job_id == jobs_ct)
+			{
+				jobs_ct *= 2;
+				simulator_job_t *grown = realloc(jobs, jobs_ct * sizeof(simulator_job_t));
+
+				if (!grown)
+				{
+					simulator_free_jobs(jobs, job_id);
+					*count = 0;
+					return NULL;
+				}
+				jobs = grown;
+			}
+
+			int burst_ct = 1;
+			for (char *p = run_time; *p != '\0'; p++)
+				if (*p == ';')
+					burst_ct++;
+
+			jobs[job_id].burst_ct = burst_ct;
+			jobs[job_id].bursts = NULL;
+			if (burst_ct > 1)
+			{
+				// CPU and I/O bursts alternate, and the last one is CPU.
+				int *bursts = malloc(burst_ct * sizeof(int));
+				char *p = run_time, *end;
+
+				for (int k = 0; bursts != NULL && k < burst_ct; k++, p = end + 1)
+				{
+					bursts[k] = strtol(p, &end, 10);
+					if (end == p || bursts[k] < 0)
+						burst_ct = 0;
+				}
+				if (bursts == NULL || burst_ct % 2 == 0)
+				{
+					free(bursts);
+					simulator_free_jobs(jobs, job_id);
+					*count = (bursts == NULL ? 0 : -1);
+					return NULL;
+				}
+				jobs[job_id].bursts = bursts;
+			}
+
+			jobs[job_id].arrival_time = atoi(arrival_time);
+			jobs[job_id].run_time = atoi(run_time);
+			jobs[job_id].priority = atoi(priority);
+			jobs[job_id].deadline = (deadline != NULL ? atoi(deadline) : 0);
+			jobs[job_id].group = (group != NULL && atoi(group) > 0 ? atoi(group) : 0);
+			jobs[job_id].cores = (cores != NULL && atoi(cores) > 1 ? atoi(cores) : 1);
+
+			job_id++;
+		}
+		else
+		{
+			simulator_free_jobs(jobs, job_id);
+			return NULL;
+		}
+	}
+
+	*count = job_id;
+	return jobs;
+}
+
+
+/**
+  Frees the jobs read by simulator_read_jobs().
+
+  @param jobs the jobs
+  @param count the number of jobs
+ */
+void simulator_free_jobs(simulator_job_t *jobs, int count)
+{
+	if (jobs == NULL)
+		return;
+
+	for (int i = 0; i < count; i++)
+		free(jobs[i].bursts);
+	free(jobs);
+}
+
+
+/**
+  Parses a scheme name as given to the simulator's -s option: fcfs, sjf,
+  psjf, pri, ppri, edf, pedf, rr followed by the quantum, mlfq optionally followed
+  by the quanta of its levels and the boost period, as in mlfq:2,4,8:100,
+  cfs optionally followed by the target latency and the minimum
+  granularity, as in cfs:24:3, stride optionally followed by the quantum,
+  or lottery optionally followed by the quantum and the seed, as in
+  lottery2:7. Case is ignored.
+
+  @param name the scheme name
+  @param scheme receives the scheme
+  @param options receives the parameters of the scheme
+  @return 0 on success
+  @return -1 if the parameters of the scheme are not valid
+  @return -2 if the name is not a known scheme
+ */
+int simulator_parse_scheme(const char *name, scheme_t *scheme, scheduler_options_t *options)
+{
+	scheduler_options_init(options);
+
+	if (strcasecmp(name, "FCFS") == 0) { *scheme = FCFS; }
+	else if (strcasecmp(name, "SJF") == 0) { *scheme = SJF; }
+	else if (strcasecmp(name, "PSJF") == 0) { *scheme = PSJF; }
+	else if (strcasecmp(name, "PRI") == 0) { *scheme = PRI; }
+	else if (strcasecmp(name, "PPRI") == 0) { *scheme = PPRI; }
+	else if (strcasecmp(name, "EDF") == 0) { *scheme = EDF; }
+	else if (strcasecmp(name, "PEDF") == 0) { *scheme = PEDF; }
+	else if (strncasecmp(name, "MLFQ", 4) == 0 && (name[4] == '\0' || name[4] == ':'))
+	{
+		*scheme = MLFQ;
+
+		if (name[4] == '\0')
+			return 0;
+
+		const char *p = name + 5;
+		char *end;
+
+		options->levels = 0;
+		do
+		{
+			if (options->levels == SCHEDULER_MAX_LEVELS)
+				return -1;
+
+			long quantum = strtol(p, &end, 10);
+			if (end == p || quantum <= 0)
+				return -1;
+
+			options->level_quantum[options->levels++] = quantum;
+			p = end + 1;
+		} while (*end == ',');
+
+		if (*end == ':')
+		{
+			options->boost = strtol(p, &end, 10);
+			if (end == p || options->boost < 0)
+				return -1;
+		}
+
+		if (*end != '\0')
+			return -1;
+	}
+	else if (strncasecmp(name, "CFS", 3) == 0 && (name[3] == '\0' || name[3] == ':'))
+	{
+		*scheme = CFS;
+
+		if (name[3] == '\0')
+			return 0;
+
+		char *end;
+		options->latency = strtol(name + 4, &end, 10);
+		if (end == name + 4 || options->latency <= 0)
+			return -1;
+
+		if (*end == ':')
+		{
+			const char *p = end + 1;
+			options->min_granularity = strtol(p, &end, 10);
+			if (end == p || options->min_granularity <= 0)
+				return -1;
+		}
+
+		if (*end != '\0' || options->min_granularity > options->latency)
+			return -1;
+	}
+	else if (strncasecmp(name, "STRIDE", 6) == 0 || strncasecmp(name, "LOTTERY", 7) == 0)
+	{
+		*scheme = (toupper((unsigned char)name[0]) == 'S' ? STRIDE : LOTTERY);
+
+		const char *p = name + (*scheme == STRIDE ? 6 : 7);
+		char *end = (char *)p;
+
+		options->quantum = 1;
+		if (isdigit((unsigned char)*p))
+		{
+			options->quantum = strtol(p, &end, 10);
+			if (options->quantum <= 0)
+				return -1;
+		}
+
+		if (*scheme == LOTTERY && *end == ':')
+		{
+			p = end + 1;
+			options->seed = strtoul(p, &end, 10);
+			if (end == p)
+				return -1;
+		}
+
+		if (*end != '\0')
+			return -1;
+	}
+	else if (strncasecmp(name, "RR", 2) == 0)
+	{
+		*scheme = RR;
+		options->quantum = atoi(name + 2);
+
+		if (options->quantum <= 0)
+			return -1;
+	}
+	else
+		return -2;
+
+	return 0;
+}
+
+
+/**
+  Parses the cores as given to the simulator's -c option: either a number
+  of cores, or groups of cores that run at the same speed, as in
+  4:2.0,4:1.0 for four cores twice as fast as the other four. A group
+  without a speed runs at nominal speed, 1.0.
+
+  @param spec the cores
+  @param cores receives the total number of cores
+  @param speeds receives the speed of each core in SCHEDULER_SPEED_UNITs,
+  which the caller must free, or NULL if no speed was given
+  @return 0 on success
+  @return -1 if the cores are not valid
+ */
+int simulator_parse_cores(const char *spec, int *cores, int **speeds)
+{
+	const char *p = spec;
+	char *end;
+	int count = 0, size = 0;
+	int *list = NULL;
+
+	*speeds = NULL;
+	do
+	{
+		long group = strtol(p, &end, 10);
+		int speed = SCHEDULER_SPEED_UNIT;
+
+		if (end == p || group <= 0 || group > 1 << 20)
+			break;
+
+		if (*end == ':')
+		{
+			p = end + 1;
+			double factor = strtod(p, &end);
+
+			if (end == p || !(factor * SCHEDULER_SPEED_UNIT >= 1.0 && factor <= 1000.0))
+				break;
+			speed = (int)(factor * SCHEDULER_SPEED_UNIT + 0.5);
+		}
+
+		if (count + group > size)
+		{
+			size = 2 * (count + group);
+			int *grown = realloc(list, size * sizeof(int));
+			if (grown == NULL)
+				break;
+			list = grown;
+		}
+		for (int i = 0; i < group; i++)
+			list[count++] = speed;
+
+		p = end + 1;
+	} while (*end == ',');
+
+	if (count == 0 || *end != '\0')
+	{
+		free(list);
+		return -1;
+	}
+
+	*cores = count;
+	for (int i = 0; i < count; i++)
+		if (list[i] != SCHEDULER_SPEED_UNIT)
+		{
+			*speeds = list;
+			return 0;
+		}
+
+	free(list);
+	return 0;
+}
+
+
+/**
+  Parses the weights of the groups as given to the simulator's -G option, a
+  list of positive numbers such as 2,1,1 for group 0 to get twice the share
+  of groups 1 and 2.
+
+  @param spec the weights
+  @param count receives the number of weights
+  @param weights receives the weight of each group, which the caller must free
+  @return 0 on success
+  @return -1 if the weights are not valid
+ */
+int simulator_parse_weights(const char *spec, int *count, int **weights)
+{
+	const char *p = spec;
+	char *end;
+	int size = 0;
+	int *list = NULL;
+
+	*count = 0;
+	do
+	{
+		long weight = strtol(p, &end, 10);
+
+		if (end == p || weight <= 0 || weight > 1 << 20)
+			break;
+
+		if (*count == size)
+		{
+			size = (size > 0 ? 2 * size : 8);
+			int *grown = realloc(list, size * sizeof(int));
+			if (grown == NULL)
+				break;
+			list = grown;
+		}
+		list[(*count)++] = weight;
+
+		p = end + 1;
+	} while (*end == ',');
+
+	if (*count == 0 || *end != '\0')
+	{
+		free(list);
+		*count = 0;
+		return -1;
+	}
+
+	*weights = list;
+	return 0;
+}
+
+
+/**
+  Parses an admission policy as given to the simulator's -A option:
+  queue:N to admit jobs while fewer than N wait, backlog:N while at most N
+  time units of work are left on the runnable jobs, or tokens:N:R for a
+  bucket per priority class holding up to N tokens and gaining one every R
+  time units. A trailing :defer defers the jobs not admitted rather than
+  reject them.
+
+  @param spec the policy
+  @param options receives the policy
+  @return 0 on success
+  @return -1 if the policy is not valid
+ */
+int simulator_parse_admission(const char *spec, scheduler_options_t *options)
+{
+	const char *p;
+	char *end;
+	long limit, rate = 0;
+
+	if (strncasecmp(spec, "queue:", 6) == 0)
+		options->admission = ADMIT_QUEUE;
+	else if (strncasecmp(spec, "backlog:", 8) == 0)
+		options->admission = ADMIT_BACKLOG;
+	else if (strncasecmp(spec, "tokens:", 7) == 0)
+		options->admission = ADMIT_TOKENS;
+	else
+		return -1;
+
+	p = strchr(spec, ':') + 1;
+	limit = strtol(p, &end, 10);
+	if (end == p || limit < 0 || limit > 1 << 30 || (options->admission == ADMIT_TOKENS && limit == 0))
+		return -1;
+
+	if (options->admission == ADMIT_TOKENS)
+	{
+		p = end + 1;
+		rate = (*end == ':' ? strtol(p, &end, 10) : 0);
+		if (end == p || rate <= 0 || rate > 1 << 20)
+			return -1;
+	}
+
+	options->admission_limit = limit;
+	options->admission_rate = rate;
+	options->admission_defer = (strcasecmp(end, ":defer") == 0);
+	if (*end != '\0' && !options->admission_defer)
+		return -1;
+
+	return 0;
+}
+
+
+/**
+  Returns the number of groups the jobs of a workload fall into, which is
+  one more than the highest group of any job.
+
+  @param jobs the jobs
+  @param count the number of jobs
+ */
+int simulator_count_groups(const simulator_job_t *jobs, int count)
+{
+	int groups = 1;
+
+	for (int i = 0; i < count; i++)
+		if (jobs[i].group >= groups)
+			groups = jobs[i].group + 1;
+
+	return groups;
+}
+
+
+static int compare_arrival(const void *a, const void *b)
+{
+	const simulator_job_t *job_a = *(const simulator_job_t **)a;
+	const simulator_job_t *job_b = *(const simulator_job_t **)b;
+
+	return job_a->arrival_time - job_b->arrival_time;
+}
+
+
+static int compare_remaining(const void *a, const void *b)
+{
+	double remaining_a = *(const double *)a;
+	double remaining_b = *(const double *)b;
+
+	return (remaining_a < remaining_b ? -1 : remaining_a > remaining_b);
+}
+
+
+/**
+  Computes lower bounds on the average turnaround and waiting times, and on
+  the time the last job finishes, that no scheme can beat on a workload.
+
+  No schedule on the cores finishes its jobs sooner in total than SRPT
+  does on a single core as fast as all of them together, which runs
+  whichever job has the least work left. That is simulated event by event
+  over a heap of the work left, in O(n log n), rather than time unit by
+  time unit. Nor can a job finish sooner than if it had the fastest core to
+  itself, with its I/O. Only the CPU bursts of jobs that do I/O count as
+  work.
+
+  @param jobs the jobs
+  @param count the number of jobs
+  @param cores the number of cores
+  @param speeds the speed of each core in SCHEDULER_SPEED_UNITs, or NULL
+  when every core runs at nominal speed
+  @param bounds receives the bounds
+  @return 0 on success
+  @return -1 if memory ran out
+ */
+int simulator_bounds(const simulator_job_t *jobs, int count, int cores, const int *speeds, simulator_bounds_t *bounds)
+{
+	const simulator_job_t **order = malloc(count * sizeof(simulator_job_t *));
+	double *remaining = malloc(count * sizeof(double));
+	double capacity = cores, fastest = 1;
+	int i;
+
+	memset(bounds, 0, sizeof(*bounds));
+	if (count == 0 || order == NULL || remaining == NULL)
+	{
+		free(order);
+		free(remaining);
+		return (count == 0 ? 0 : -1);
+	}
+
+	if (speeds != NULL)
+	{
+		capacity = fastest = 0;
+		for (i = 0; i < cores; i++)
+		{
+			capacity += speeds[i] / (double)SCHEDULER_SPEED_UNIT;
+			if (speeds[i] / (double)SCHEDULER_SPEED_UNIT > fastest)
+				fastest = speeds[i] / (double)SCHEDULER_SPEED_UNIT;
+		}
+	}
+
+	// The work of each job, and what it takes it alone.
+	double alone = 0, own = 0, work_left = 0;
+	for (i = 0; i < count; i++)
+	{
+		int work = jobs[i].run_time, io = 0;
+
+		for (int b = 1; b < jobs[i].burst_ct; b++)
+		{
+			if (b % 2 == 0)
+				work += jobs[i].bursts[b];
+			else
+				io += jobs[i].bursts[b];
+		}
+
+		order[i] = &jobs[i];
+		remaining[i] = work;
+		work_left += work;
+		alone += work / fastest + io;
+		own += work + io;
+
+		if (jobs[i].arrival_time + work / fastest + io > bounds->critical_makespan)
+			bounds->critical_makespan = ceil(jobs[i].arrival_time + work / fastest + io);
+	}
+	qsort(order, count, sizeof(simulator_job_t *), compare_arrival);
+
+	/*
+	 * SRPT on the fast core: between arrivals, the job with the least work
+	 * left runs, finishing if it can before the next arrival. Working flat
+	 * out from each arrival on with the work still to come also gives the
+	 * makespan bound.
+	 */
+	heap_t heap;
+	double now = order[0]->arrival_time, flow = 0;
+	int next = 0;
+
+	heap_init(&heap, compare_remaining);
+	while (next < count || heap_size(&heap) > 0)
+	{
+		double until = (next < count ? order[next]->arrival_time : INFINITY);
+
+		while (heap_size(&heap) > 0 && now < until)
+		{
+			double *job = heap_peek(&heap);
+
+			if (now + *job / capacity <= until)
+			{
+				now += *job / capacity;
+				flow += now - jobs[job - remaining].arrival_time;
+				heap_poll(&heap);
+			}
+			else
+			{
+				*job -= (until - now) * capacity;
+				now = until;
+			}
+		}
+
+		if (next < count)
+		{
+			int arrival = order[next]->arrival_time;
+
+			if (now < arrival)
+				now = arrival;
+			if (arrival + work_left / capacity > bounds->work_makespan)
+				bounds->work_makespan = ceil(arrival + work_left / capacity - 1e-9);
+
+			for (; next < count && order[next]->arrival_time == arrival; next++)
+			{
+				heap_offer(&heap, &remaining[order[next] - jobs]);
+				work_left -= remaining[order[next] - jobs];
+			}
+		}
+	}
+	heap_destroy(&heap);
+
+	bounds->srpt_turnaround_time = flow / count;
+	bounds->alone_turnaround_time = alone / count;
+	bounds->turnaround_time = fmax(bounds->srpt_turnaround_time, bounds->alone_turnaround_time);
+	bounds->waiting_time = (speeds == NULL ? fmax(bounds->turnaround_time - own / count, 0) : 0);
+	bounds->makespan = (bounds->work_makespan > bounds->critical_makespan ? bounds->work_makespan : bounds->critical_makespan);
+
+	free(order);
+	free(remaining);
+	return 0;
+}
+
+
+/**
+  Returns the descriptive name of a scheme, as printed in the trace header.
+
+  @param scheme the scheme
+ */
+const char *simulator_scheme_name(scheme_t scheme)
+{
+	switch (scheme)
+	{
+		case FCFS: return "First Come First Served (FCFS)";
+		case SJF: return "Non-preemptive Shortest Job First (SJF)";
+		case PSJF: return "Preemptive Shortest Job First (PSJF)";
+		case PRI: return "Non-preemptive Priority (PRI)";
+		case PPRI: return "Preemptive Priority (PPRI)";
+		case RR: return "Round Robin (RR)";
+		case MLFQ: return "Multi-Level Feedback Queue (MLFQ)";
+		case CFS: return "Completely Fair Scheduler (CFS)";
+		case EDF: return "Non-preemptive Earliest Deadline First (EDF)";
+		case PEDF: return "Preemptive Earliest Deadline First (PEDF)";
+		case STRIDE: return "Stride Scheduling (STRIDE)";
+		case LOTTERY: return "Lottery Scheduling (LOTTERY)";
+	}
+	return "";
+}
+
+
+/**
+  Creates a simulation with no jobs. The simulation owns its own scheduler
+  instance.
+
+  @param cores the number of cores to simulate
+  @param scheme the scheduling scheme
+  @param options parameters of the scheme, or NULL for the defaults
+  @return the new simulation
+ */
+simulator_t *simulator_create(int cores, scheme_t scheme, const scheduler_options_t *options)
+{
+	simulator_t *sim = calloc(1, sizeof(simulator_t));
+
+	if (options != NULL)
+		sim->options = *options;
+	else
+		scheduler_options_init(&sim->options);
+
+	// Every core serves every group, as the scheduler does, so no per-core queues.
+	if (sim->options.groups > 0)
+		sim->options.per_core_queues = 0;
+
+	sim->scheduler = scheduler_create(cores, scheme, &sim->options);
+	sim->scheme = scheme;
+	sim->cores = cores;
+
+	sim->jobs_ct = 10;
+	sim->jobs = malloc(sim->jobs_ct * sizeof(simulator_job_list_t));
+
+	sim->arrivals_ct = 10;
+	sim->arrivals = malloc(sim->arrivals_ct * sizeof(simulator_order_t));
+	sim->position = malloc(sim->arrivals_ct * sizeof(int));
+	sim->arrivals_sorted = 1;
+	sim->horizon = -1;
+	heap_init(&sim->io, compare_order);
+
+	sim->quantum_clock = malloc(cores * sizeof(int));
+	sim->core_job = malloc(cores * sizeof(int));
+	for (int i = 0; i < cores; i++)
+	{
+		sim->quantum_clock[i] = -1;
+		sim->core_job[i] = -1;
+	}
+
+	return sim;
+}
+
+
+/**
+  Enables the human readable trace of the simulation. Without a trace the
+  simulation prints nothing and skips building the timing diagram.
+
+  @param sim the simulation
+  @param trace the stream to write the trace to, or NULL to disable it
+  @param show_queue whether to print the scheduler's queue after each event
+ */
+void simulator_set_trace(simulator_t *sim, FILE *trace, int show_queue)
+{
+	sim->trace = trace;
+	sim->show_queue = show_queue;
+
+	if (trace != NULL && sim->core_timing_diagram == NULL)
+	{
+		sim->core_timing_diagram = malloc(sim->cores * sizeof(char *));
+		sim->core_timing_diagram_len = calloc(sim->cores, sizeof(int));
+		sim->core_timing_diagram_size = malloc(sim->cores * sizeof(int));
+
+		for (int i = 0; i < sim->cores; i++)
+		{
+			sim->core_timing_diagram_size[i] = 1024;
+			sim->core_timing_diagram[i] = malloc(sim->core_timing_diagram_size[i] + 1);
+			sim->core_timing_diagram[i][0] = '\0';
+		}
+	}
+}
+
+/**
+  Writes a time series of the simulation to a stream, as CSV: a row every
+  so many time units, and one for the last, shorter window when the last
+  job finishes. Each row gives the jobs waiting in the run queues, running
+  and blocked at its time, the share of the cores' time spent running jobs
+  during the window, the jobs that finished in it, and the mean and 99th
+  percentile of the response times of those jobs, empty when none did.
+
+  @param sim the simulation
+  @param out the stream to write the series to, or NULL to disable it
+  @param every time units between rows
+ */
+void simulator_set_series(simulator_t *sim, FILE *out, int every)
+{
+	scheduler_stats_t stats;
+
+	sim->series = (every > 0 ? out : NULL);
+	sim->series_every = every;
+	if (sim->series == NULL)
+		return;
+
+	scheduler_stats_snapshot_r(sim->scheduler, sim->time, &stats);
+	sim->next_series = (sim->time / every + 1) * every;
+	sim->series_start = sim->time;
+	sim->series_busy = stats.busy_time;
+	sim->series_responses_ct = 0;
+
+	fprintf(out, "time,waiting,running,blocked,utilization,completions,mean_response,p99_response\n");
+}
+
+
+/**
+  Logs every scheduling event of the simulation from now on: arrivals,
+  jobs dispatched to cores and leaving them when preempted, when their
+  quantum expires, when they block on I/O or finish, and wakeups. Unlike
+  the trace, the log does not keep the simulation from skipping idle
+  stretches.
+
+  @param sim the simulation
+  @param events the event log, or NULL to disable it; the caller closes it
+  after the simulation is done
+ */
+void simulator_set_eventlog(simulator_t *sim, eventlog_t *events)
+{
+	sim->events = events;
+}
+
+
+/**
+  Tells a function of every scheduling event of the simulation from now
+  on, as it happens: the same events the event log records, in the same
+  order. Like the log, the listener does not keep the simulation from
+  skipping idle stretches. A listener is not part of a snapshot.
+
+  @param sim the simulation
+  @param listener the function, or NULL to stop telling one
+  @param context passed to the function with every event
+ */
+void simulator_set_listener(simulator_t *sim, simulator_listener_t listener, void *context)
+{
+	sim->listener = listener;
+	sim->listener_context = context;
+}
+
+
+/**
+  Records the response and turnaround time of every job as it finishes, by
+  job id, which is the order the jobs were added in. Jobs that have not
+  finished, or were rejected, are left as they are.
+
+  @param sim the simulation
+  @param response_times receives the response times, or NULL
+  @param turnaround_times receives the turnaround times, or NULL
+ */
+void simulator_record_jobs(simulator_t *sim, int *response_times, int *turnaround_times)
+{
+	sim->response_times = response_times;
+	sim->turnaround_times = turnaround_times;
+}
+
+
+static void log_event(simulator_t *sim, event_type_t type, int job_id, int core_id)
+{
+	if (sim->events != NULL)
+		eventlog_write(sim->events, type, sim->time, job_id, core_id);
+	if (sim->listener != NULL)
+		sim->listener(sim->listener_context, type, sim->time, job_id, core_id);
+}
+
+
+static int compare_response(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+ * Writes the rows of the windows that ended by the given time, and of the
+ * window in progress if it is the last. Rows are written once the jobs
+ * that finish at their time have, so that those count in their window.
+ */
+static void write_series(simulator_t *sim, int time, int last)
+{
+	while (sim->next_series <= time || (last && sim->series_start < time))
+	{
+		int end = (sim->next_series <= time ? sim->next_series : time);
+		int count = sim->series_responses_ct;
+		scheduler_stats_t stats;
+
+		scheduler_stats_snapshot_r(sim->scheduler, end, &stats);
+		fprintf(sim->series, "%d,%d,%d,%d,%.3f,%d,", end, stats.waiting_jobs, stats.running_jobs, stats.blocked_jobs,
+				(stats.busy_time - sim->series_busy) / (double)(end - sim->series_start) / sim->cores, count);
+
+		if (count > 0)
+		{
+			long long sum = 0;
+
+			for (int i = 0; i < count; i++)
+				sum += sim->series_responses[i];
+			qsort(sim->series_responses, count, sizeof(int), compare_response);
+
+			// The nearest rank, as for tardiness.
+			int rank = (int)(0.99 * count + 0.999999);
+			fprintf(sim->series, "%.2f,%d\n", sum / (double)count, sim->series_responses[(rank > count ? count : rank) - 1]);
+		}
+		else
+			fprintf(sim->series, ",\n");
+
+		if (end == sim->next_series)
+			sim->next_series += sim->series_every;
+		sim->series_start = end;
+		sim->series_busy = stats.busy_time;
+		sim->series_responses_ct = 0;
+	}
+}
+
+
+/**
+  Adds a job to the simulation. Jobs are numbered in the order they are
+  added, starting at 0.
+
+  @param sim the simulation
+  @param job the job to add
+  @return the job number
+  @return -1 if memory ran out
+ */
+int simulator_add_job(simulator_t *sim, const simulator_job_t *job)
+{
+	if (sim->active_jobs == sim->jobs_ct)
+	{
+		simulator_job_list_t *grown = realloc(sim->jobs, 2 * sim->jobs_ct * sizeof(simulator_job_list_t));
+
+		if (!grown)
+			return -1;
+
+		sim->jobs = grown;
+		sim->jobs_ct *= 2;
+	}
+
+	if (sim->total_jobs == sim->arrivals_ct)
+	{
+		simulator_order_t *grown = realloc(sim->arrivals, 2 * sim->arrivals_ct * sizeof(simulator_order_t));
+
+		if (!grown)
+			return -1;
+		sim->arrivals = grown;
+
+		int *grown_position = realloc(sim->position, 2 * sim->arrivals_ct * sizeof(int));
+
+		if (!grown_position)
+			return -1;
+		sim->position = grown_position;
+
+		sim->arrivals_ct *= 2;
+	}
+
+	if (sim->total_jobs > sim->next_arrival && job->arrival_time < sim->arrivals[sim->total_jobs - 1].key)
+		sim->arrivals_sorted = 0;
+
+	sim->arrivals[sim->total_jobs].key = job->arrival_time;
+	sim->arrivals[sim->total_jobs].job_id = sim->total_jobs;
+	sim->position[sim->total_jobs] = sim->active_jobs;
+
+	simulator_job_list_t *entry = &sim->jobs[sim->active_jobs++];
+	entry->job_id = sim->total_jobs++;
+	entry->arrival_time = job->arrival_time;
+	entry->run_time = job->run_time;
+	entry->priority = job->priority;
+	entry->deadline = (job->deadline > 0 ? job->deadline : 0);
+	if (entry->deadline > 0)
+		sim->has_deadlines = 1;
+	entry->group = (job->group > 0 ? job->group : 0);
+	entry->core_id = -1;
+	entry->arrived = 0;
+	entry->first_run = -1;
+	entry->progress = 0;
+
+	entry->bursts = NULL;
+	entry->burst_ct = 1;
+	entry->next_burst = 1;
+	if (job->burst_ct > 1 && job->bursts != NULL)
+	{
+		entry->bursts = malloc(job->burst_ct * sizeof(int));
+		if (entry->bursts == NULL)
+			return -1;
+		memcpy(entry->bursts, job->bursts, job->burst_ct * sizeof(int));
+		entry->burst_ct = job->burst_ct;
+		sim->has_bursts = 1;
+
+		for (int k = 2; k < entry->burst_ct; k += 2)
+			sim->backlog += entry->bursts[k];
+	}
+	sim->backlog += entry->run_time;
+
+	return entry->job_id;
+}
+
+
+static FILE *error_stream(simulator_t *sim)
+{
+	return (sim->trace != NULL ? sim->trace : stderr);
+}
+
+
+static void print_queue(simulator_t *sim)
+{
+	if (sim->show_queue)
+	{
+		fprintf(sim->trace, "  Queue: ");
+		scheduler_show_queue_r(sim->scheduler, sim->trace);
+		fprintf(sim->trace, "\n\n");
+	}
+}
+
+
+/*
+ * Restarts the quantum timer of a core for whatever job the scheduler
+ * placed on it. Schemes that are not time sliced never expire.
+ */
+static void start_quantum(simulator_t *sim, int core_id)
+{
+	int quantum = scheduler_quantum_r(sim->scheduler, core_id);
+	sim->quantum_clock[core_id] = (quantum > 0 ? quantum : -1);
+}
+
+
+/*
+ * Makes the job the scheduler placed on a core pay for migrating there and
+ * for a cold cache, by running that much longer. With a cache penalty, which
+ * is paid on every move, the time slice only starts once it is paid, or a
+ * job whose penalty is as long as its slice would never get anywhere.
+ */
+static void charge_migration(simulator_t *sim, int core_id)
+{
+	int cost = scheduler_migration_cost_r(sim->scheduler, core_id);
+
+	if (cost > 0 && sim->core_job[core_id] != -1)
+	{
+		sim->jobs[sim->position[sim->core_job[core_id]]].run_time += cost;
+		sim->backlog += cost;
+		if (sim->options.cache_penalty > 0 && sim->quantum_clock[core_id] > 0)
+			sim->quantum_clock[core_id] += cost;
+	}
+}
+
+
+static int set_active_job(simulator_t *sim, int job_id, int core_id)
+{
+	if (job_id < 0 || job_id >= sim->total_jobs || sim->position[job_id] < 0)
+		return 0;
+
+	simulator_job_list_t *job = &sim->jobs[sim->position[job_id]];
+
+	if (!job->arrived)
+		return 0;
+
+	if (job->core_id != -1 && sim->core_job[job->core_id] == job_id)
+		sim->core_job[job->core_id] = -1;
+
+	job->core_id = core_id;
+	if (job->first_run == -1)
+		job->first_run = sim->time;
+	sim->core_job[core_id] = job_id;
+	log_event(sim, EVENT_DISPATCH, job_id, core_id);
+	return 1;
+}
+
+
+static int compare_order(const void *a, const void *b)
+{
+	const simulator_order_t *order_a = a;
+	const simulator_order_t *order_b = b;
+
+	if (order_a->key != order_b->key)
+		return (order_a->key < order_b->key ? -1 : 1);
+	return order_a->job_id - order_b->job_id;
+}
+
+
+/*
+ * Puts a job the scheduler placed on a core there, taking the core from
+ * any job it preempted.
+ */
+static void place_job(simulator_t *sim, int i, int core_id)
+{
+	simulator_job_list_t *jobs = sim->jobs;
+
+	// Find if anyone is currently using the core. A job preempted the moment it started has not run yet.
+	if (sim->core_job[core_id] != -1)
+	{
+		simulator_job_list_t *preempted = &jobs[sim->position[sim->core_job[core_id]]];
+
+		preempted->core_id = -1;
+		if (preempted->first_run == sim->time)
+			preempted->first_run = -1;
+		log_event(sim, EVENT_PREEMPT, preempted->job_id, core_id);
+	}
+
+	// Assign the core to the new job
+	jobs[i].core_id = core_id;
+	if (jobs[i].first_run == -1)
+		jobs[i].first_run = sim->time;
+	sim->core_job[core_id] = jobs[i].job_id;
+	log_event(sim, EVENT_DISPATCH, jobs[i].job_id, core_id);
+
+	start_quantum(sim, core_id);
+	charge_migration(sim, core_id);
+}
+
+
+/*
+ * Orders the jobs yet to arrive by arrival time, for when they were not
+ * added in that order.
+ */
+static void sort_arrivals(simulator_t *sim)
+{
+	if (!sim->arrivals_sorted)
+	{
+		qsort(sim->arrivals + sim->next_arrival, sim->total_jobs - sim->next_arrival, sizeof(simulator_order_t), compare_order);
+		sim->arrivals_sorted = 1;
+	}
+}
+
+
+/*
+ * Removes a finished job. Like the list it replaces, the last job takes
+ * the freed slot, which decides the order in which jobs that finish or
+ * arrive in the same time unit are handed to the scheduler.
+ */
+static void remove_job(simulator_t *sim, int i)
+{
+	simulator_job_list_t *jobs = sim->jobs;
+
+	sim->position[jobs[i].job_id] = -1;
+	free(jobs[i].bursts);
+
+	if (i != sim->active_jobs - 1)
+	{
+		memcpy(&jobs[i], &jobs[sim->active_jobs - 1], sizeof(simulator_job_list_t));
+		sim->position[jobs[i].job_id] = i;
+	}
+	sim->active_jobs--;
+}
+
+
+static void print_available_jobs(FILE *out, simulator_job_list_t *jobs, int active_jobs)
+{
+	fprintf(out, "Active jobs are: ");
+
+	int i, first = 1;
+	for (i = 0; i < active_jobs; i++)
+	{
+		if (jobs[i].arrived)
+		{
+			if (first)
+			{
+				fprintf(out, "%d", jobs[i].job_id);
+				first = 0;
+			}
+			else
+				fprintf(out, ", %d", jobs[i].job_id);
+		}
+	}
+
+	if (!first)
+		fprintf(out, "\n");
+}
+
+
+static void print_available_cores(FILE *out, int cores)
+{
+	fprintf(out, "Active cores are: ");
+
+	int i;
+	for (i = 0; i < cores; i++)
+	{
+		if (i == cores - 1)
+			fprintf(out, "%d\n", i);
+		else
+			fprintf(out, "%d, ", i);
+	}
+}
+
+
+static int append_timing_diagram(simulator_t *sim, int core, const char *s)
+{
+	int len = strlen(s);
+
+	// Ensure we have enough memory
+	while (sim->core_timing_diagram_len[core] + len >= sim->core_timing_diagram_size[core])
+	{
+		char *grown = realloc(sim->core_timing_diagram[core], 2 * sim->core_timing_diagram_size[core] + 1);
+
+		if (grown == NULL)
+			return -1;
+
+		sim->core_timing_diagram[core] = grown;
+		sim->core_timing_diagram_size[core] *= 2;
+	}
+
+	memcpy(sim->core_timing_diagram[core] + sim->core_timing_diagram_len[core], s, len + 1);
+	sim->core_timing_diagram_len[core] += len;
+	return 0;
+}
+
+
+/*
+ * Blocks a job that finished a CPU burst on I/O: the scheduler frees its
+ * core, and the job wakes with its next CPU burst once the I/O is done.
+ */
+static int block_job(simulator_t *sim, int i, int time)
+{
+	simulator_job_list_t *jobs = sim->jobs;
+	int job_id = jobs[i].job_id;
+	int core_id = jobs[i].core_id;
+	simulator_order_t *event = malloc(sizeof(simulator_order_t));
+
+	if (event == NULL)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return -1;
+	}
+	event->key = time + jobs[i].bursts[jobs[i].next_burst];
+	event->job_id = job_id;
+	heap_offer(&sim->io, event);
+
+	// A fast core may have done more than the burst asked for.
+	sim->backlog -= jobs[i].run_time;
+	jobs[i].run_time = jobs[i].bursts[jobs[i].next_burst + 1];
+	jobs[i].progress = 0;
+	jobs[i].next_burst += 2;
+	jobs[i].core_id = -1;
+	sim->core_job[core_id] = -1;
+	sim->jobs_blocked++;
+	log_event(sim, EVENT_BLOCK, job_id, core_id);
+
+	int new_job_id = scheduler_job_blocked_r(sim->scheduler, core_id, job_id, time);
+
+	if (new_job_id == SCHEDULER_MISMATCH)
+	{
+		fprintf(error_stream(sim), "The scheduler does not have job %d running on core %d.\n", job_id, core_id);
+		return -1;
+	}
+
+	start_quantum(sim, core_id);
+
+	if ( new_job_id != -1 && !set_active_job(sim, new_job_id, core_id) )
+	{
+		fprintf(error_stream(sim), "The scheduler_job_blocked() selected an invalid job (job_id == %d).\n", new_job_id);
+		print_available_jobs(error_stream(sim), jobs, sim->active_jobs);
+		return -1;
+	}
+
+	charge_migration(sim, core_id);
+
+	if (sim->trace)
+	{
+		fprintf(sim->trace, "Job %d, running on core %d, blocked on I/O until time %d. Core %d is now running job %d.\n", job_id, core_id, event->key, core_id, new_job_id);
+		print_queue(sim);
+	}
+	return 0;
+}
+
+
+/*
+ * Offers a job that arrives, or one deferred before, to the scheduler, and
+ * puts it on the core the scheduler picks, if any. Under an admission
+ * policy, a rejected job leaves the simulation and a deferred job is held
+ * back, to be offered again in the next time unit, counting its waiting
+ * from when it first arrived. Returns 1 if the job was deferred again, 0
+ * otherwise, or -1 if the scheduler picked an invalid core or memory ran
+ * out.
+ */
+static int offer_job(simulator_t *sim, int i, int time, int again)
+{
+	simulator_job_list_t *jobs = sim->jobs;
+	FILE *trace = sim->trace;
+	int cores = sim->cores;
+	int job_id = jobs[i].job_id;
+
+	scheduler_job_attr_t attr;
+	scheduler_job_attr_init(&attr);
+	attr.deadline = jobs[i].deadline;
+	attr.group = jobs[i].group;
+	if (again)
+		attr.arrival_time = jobs[i].arrival_time;
+
+	int new_job_core_id = scheduler_new_job_attr_r(sim->scheduler, job_id, time, jobs[i].run_time, jobs[i].priority, &attr);
+
+	if (new_job_core_id == SCHEDULER_DEFERRED)
+	{
+		if (again)
+			return 1;
+
+		if (sim->deferred_ct == sim->deferred_size)
+		{
+			int size = (sim->deferred_size > 0 ? 2 * sim->deferred_size : 64);
+			int *grown = realloc(sim->deferred, size * sizeof(int));
+
+			if (grown == NULL)
+				return -1;
+			sim->deferred = grown;
+			sim->deferred_size = size;
+		}
+		sim->deferred[sim->deferred_ct++] = job_id;
+	}
+	else if (new_job_core_id != SCHEDULER_REJECTED)
+	{
+		jobs[i].arrived = 1;
+		sim->jobs_alive++;
+		log_event(sim, EVENT_ARRIVE, job_id, -1);
+	}
+
+	char arrived[160];
+	int length;
+	if (again)
+		length = snprintf(arrived, sizeof(arrived), "Job %d, deferred since time %d, was admitted.", job_id, jobs[i].arrival_time);
+	else
+	{
+		length = snprintf(arrived, sizeof(arrived), "A new job, job %d (running time=%d, priority=%d", job_id, jobs[i].run_time, jobs[i].priority);
+		if (jobs[i].deadline > 0)
+			length += snprintf(arrived + length, sizeof(arrived) - length, ", deadline=%d", jobs[i].deadline);
+		if (sim->options.groups > 0)
+			length += snprintf(arrived + length, sizeof(arrived) - length, ", group=%d", jobs[i].group);
+		snprintf(arrived + length, sizeof(arrived) - length, "), arrived.");
+	}
+
+	if (new_job_core_id >= 0 && new_job_core_id < cores)
+	{
+		if (trace)
+		{
+			fprintf(trace, "%s Job %d is now running on core %d.\n", arrived, job_id, new_job_core_id);
+			print_queue(sim);
+		}
+
+		place_job(sim, i, new_job_core_id);
+	}
+	else if (new_job_core_id == -1)
+	{
+		if (trace)
+		{
+			fprintf(trace, "%s Job %d is set to idle (-1).\n", arrived, job_id);
+			print_queue(sim);
+		}
+	}
+	else if (new_job_core_id == SCHEDULER_REJECTED || new_job_core_id == SCHEDULER_DEFERRED)
+	{
+		if (trace)
+		{
+			if (again)
+				fprintf(trace, "Job %d, deferred since time %d, is rejected.\n", job_id, jobs[i].arrival_time);
+			else
+				fprintf(trace, "%s Job %d is %s.\n", arrived, job_id, (new_job_core_id == SCHEDULER_REJECTED ? "rejected" : "deferred"));
+			print_queue(sim);
+		}
+
+		if (new_job_core_id == SCHEDULER_REJECTED)
+		{
+			for (int k = 2; k < jobs[i].burst_ct; k += 2)
+				sim->backlog -= jobs[i].bursts[k];
+			sim->backlog -= jobs[i].run_time;
+			remove_job(sim, i);
+		}
+	}
+	else
+	{
+		fprintf(error_stream(sim), "The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
+		print_available_cores(error_stream(sim), cores);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+/**
+  Simulates a single time unit.
+
+  @param sim the simulation
+  @return 1 if the time unit was simulated and jobs remain
+  @return 0 if every job has finished
+  @return -1 if the scheduler made an invalid decision, the reason for
+  which is written to the trace, or to stderr when there is no trace, or
+  if memory ran out
+ */
+int simulator_step(simulator_t *sim)
+{
+	simulator_job_list_t *jobs = sim->jobs;
+	FILE *trace = sim->trace;
+	int cores = sim->cores;
+	int time = sim->time;
+	int i, j;
+
+	if (sim->active_jobs == 0)
+		return 0;
+
+	if (trace)
+		fprintf(trace, "=== [TIME %d] ===\n", time);
+
+	/*
+	 * 1. Check if any jobs finished in the last time unit, or finished a CPU
+	 *    burst and block on I/O. Only running jobs make progress, so only the
+	 *    cores need to be looked at; the jobs are then handed to the
+	 *    scheduler in the order they sit in the job list.
+	 */
+	int finished[cores];
+	int finished_ct = 0;
+
+	for (i = 0; i < cores; i++)
+		if (sim->core_job[i] != -1 && jobs[sim->position[sim->core_job[i]]].run_time <= 0)
+			finished[finished_ct++] = sim->core_job[i];
+
+	while (finished_ct > 0)
+	{
+		int first = 0;
+		for (j = 1; j < finished_ct; j++)
+			if (sim->position[finished[j]] < sim->position[finished[first]])
+				first = j;
+
+		i = sim->position[finished[first]];
+		finished[first] = finished[--finished_ct];
+
+		if (jobs[i].next_burst < jobs[i].burst_ct)
+		{
+			if (block_job(sim, i, time) != 0)
+				return -1;
+			continue;
+		}
+
+		// Notify the scheduler has finished
+		int job_id = jobs[i].job_id;
+		int core_id = jobs[i].core_id;
+		int new_job_id = scheduler_job_finished_r(sim->scheduler, jobs[i].core_id, jobs[i].job_id, time);
+
+		log_event(sim, EVENT_FINISH, job_id, core_id);
+		start_quantum(sim, core_id);
+
+		if (sim->series != NULL)
+		{
+			if (sim->series_responses_ct == sim->series_responses_size)
+			{
+				int size = (sim->series_responses_size > 0 ? 2 * sim->series_responses_size : 64);
+				int *grown = realloc(sim->series_responses, size * sizeof(int));
+
+				if (grown == NULL)
+					return -1;
+				sim->series_responses = grown;
+				sim->series_responses_size = size;
+			}
+			sim->series_responses[sim->series_responses_ct++] = jobs[i].first_run - jobs[i].arrival_time;
+		}
+		if (sim->response_times != NULL)
+			sim->response_times[job_id] = jobs[i].first_run - jobs[i].arrival_time;
+		if (sim->turnaround_times != NULL)
+			sim->turnaround_times[job_id] = time - jobs[i].arrival_time;
+
+		// Delete the finished jobs, decrease the number of active jobs
+		sim->backlog -= jobs[i].run_time;
+		remove_job(sim, i);
+		sim->core_job[core_id] = -1;
+		sim->jobs_alive--;
+
+		// Set the new job
+		if ( new_job_id != -1 && !set_active_job(sim, new_job_id, core_id) )
+		{
+			fprintf(error_stream(sim), "The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
+			print_available_jobs(error_stream(sim), jobs, sim->active_jobs);
+			return -1;
+		}
+
+		charge_migration(sim, core_id);
+
+		if (trace)
+		{
+			fprintf(trace, "Job %d, running on core %d, finished. Core %d is now running job %d.\n", job_id, core_id, core_id, new_job_id);
+			print_queue(sim);
+		}
+	}
+
+	if (sim->series != NULL)
+		write_series(sim, time, sim->active_jobs == 0);
+
+	/*
+	 * Check to see if we finished our last job.  (If we don't check here, we would run an extra time unit that will be totally idle.)
+	 */
+	if (sim->active_jobs == 0)
+		return 0;
+
+	/*
+	 * 2. Check of any quantums expired in the last time unit.
+	 */
+	for (i = 0; i < cores; i++)
+	{
+		if (sim->quantum_clock[i] == 0 && sim->core_job[i] != -1)
+		{
+			j = sim->position[sim->core_job[i]];
+
+			// Notify the scheduler the quantum has expired
+			int core_id = jobs[j].core_id;
+			int old_job_id = jobs[j].job_id;
+			int new_job_id = scheduler_quantum_expired_r(sim->scheduler, jobs[j].core_id, time);
+
+			jobs[j].core_id = -1;
+			sim->core_job[core_id] = -1;
+			log_event(sim, EVENT_QUANTUM_EXPIRE, old_job_id, core_id);
+
+			start_quantum(sim, core_id);
+
+			// Set the new job
+			if ( new_job_id != -1 && !set_active_job(sim, new_job_id, core_id) )
+			{
+				fprintf(error_stream(sim), "The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
+				print_available_jobs(error_stream(sim), jobs, sim->active_jobs);
+				return -1;
+			}
+
+			charge_migration(sim, core_id);
+
+			if (trace)
+			{
+				fprintf(trace, "Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
+				print_queue(sim);
+			}
+		}
+	}
+
+
+	/*
+	 * 3. Wake the jobs whose I/O completed by now, earliest first.
+	 */
+	while (heap_size(&sim->io) > 0 && ((simulator_order_t *)heap_peek(&sim->io))->key <= time)
+	{
+		simulator_order_t *event = heap_poll(&sim->io);
+		i = sim->position[event->job_id];
+		free(event);
+
+		int woke_core_id = scheduler_job_woke_r(sim->scheduler, jobs[i].job_id, time, jobs[i].run_time);
+		sim->jobs_blocked--;
+		log_event(sim, EVENT_WAKE, jobs[i].job_id, -1);
+
+		if (woke_core_id >= 0 && woke_core_id < cores)
+		{
+			if (trace)
+			{
+				fprintf(trace, "Job %d (running time=%d) finished its I/O. Job %d is now running on core %d.\n",
+						jobs[i].job_id, jobs[i].run_time, jobs[i].job_id, woke_core_id);
+				print_queue(sim);
+			}
+			place_job(sim, i, woke_core_id);
+		}
+		else if (woke_core_id == -1)
+		{
+			if (trace)
+			{
+				fprintf(trace, "Job %d (running time=%d) finished its I/O. Job %d is set to idle (-1).\n",
+						jobs[i].job_id, jobs[i].run_time, jobs[i].job_id);
+				print_queue(sim);
+			}
+		}
+		else
+		{
+			fprintf(error_stream(sim), "The scheduler_job_woke() selected an invalid core (core_id == %d).\n", woke_core_id);
+			print_available_cores(error_stream(sim), cores);
+			return -1;
+		}
+	}
+
+
+	/*
+	 * 4. Offer the jobs deferred so far again, in the order they arrived, up
+	 *    to the first that is deferred once more. Then check for any new
+	 *    jobs that arrive in this time unit, in the order they sit in the
+	 *    job list.
+	 */
+	int offered = 0;
+	while (offered < sim->deferred_ct)
+	{
+		int status = offer_job(sim, sim->position[sim->deferred[offered]], time, 1);
+
+		if (status < 0)
+			return -1;
+		if (status == 1)
+			break;
+		offered++;
+	}
+	if (offered > 0)
+	{
+		sim->deferred_ct -= offered;
+		memmove(sim->deferred, sim->deferred + offered, sim->deferred_ct * sizeof(int));
+	}
+
+	sort_arrivals(sim);
+
+	int arriving_ct = 0;
+	while (sim->next_arrival + arriving_ct < sim->total_jobs && sim->arrivals[sim->next_arrival + arriving_ct].key <= time)
+		arriving_ct++;
+
+	simulator_order_t *arriving = sim->arrivals + sim->next_arrival;
+	sim->next_arrival += arriving_ct;
+
+	for (j = 0; j < arriving_ct; j++)
+		arriving[j].key = sim->position[arriving[j].job_id];
+	if (arriving_ct > 1)
+		qsort(arriving, arriving_ct, sizeof(simulator_order_t), compare_order);
+
+	// Rejected jobs leave the list, moving others in it, so positions are looked up afresh.
+	for (j = 0; j < arriving_ct; j++)
+		if (offer_job(sim, sim->position[arriving[j].job_id], time, 0) < 0)
+			return -1;
+
+
+	/*
+	 * 5. Run the time unit.
+	 */
+	char time_string[cores][14];
+	int cores_working = 0;
+
+	for (i = 0; i < cores; i++)
+		time_string[i][0] = '\0';
+
+	for (int core = 0; core < cores; core++)
+	{
+		if (sim->core_job[core] != -1)
+		{
+			i = sim->position[sim->core_job[core]];
+
+			cores_working++;
+			if (sim->options.speeds == NULL)
+			{
+				jobs[i].run_time--;
+				sim->backlog--;
+			}
+			else
+			{
+				// Cores faster or slower than nominal do part of a time unit of work at a time.
+				int work = jobs[i].progress + scheduler_core_speed_r(sim->scheduler, core);
+				jobs[i].run_time -= work / SCHEDULER_SPEED_UNIT;
+				sim->backlog -= work / SCHEDULER_SPEED_UNIT;
+				jobs[i].progress = work % SCHEDULER_SPEED_UNIT;
+			}
+			sim->quantum_clock[jobs[i].core_id]--;
+
+			assert(jobs[i].core_id == core);
+
+			if (!trace)
+				time_string[jobs[i].core_id][0] = '*';
+			else if (jobs[i].job_id < 10)
+				sprintf(time_string[jobs[i].core_id], "%d", jobs[i].job_id);
+			else if (jobs[i].job_id < 10 + 26)
+				sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 + 'a');
+			else if (jobs[i].job_id < 10 + 26 + 26)
+				sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 - 26 + 'A');
+			else
+				snprintf(time_string[jobs[i].core_id], sizeof(time_string[0]), "(%d)", jobs[i].job_id);
+		}
+	}
+
+	if (trace)
+	{
+		for (i = 0; i < cores; i++)
+		{
+			// If the core is idle, print a '-'
+			if (time_string[i][0] == '\0')
+				strcpy(time_string[i], "-");
+
+			if (append_timing_diagram(sim, i, time_string[i]) != 0)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				return -1;
+			}
+		}
+
+
+		/*
+		 * 6. Print data!
+		 */
+		fprintf(trace, "At the end of time unit %d...\n", time);
+
+		for (i = 0; i < cores; i++)
+			fprintf(trace, "  Core %2d: %s\n", i, sim->core_timing_diagram[i]);
+
+		fprintf(trace, "\n");
+
+		print_queue(sim);
+	}
+
+
+	/*
+	 * 7. Sanity Checking
+	 *
+	 * - If there's a job alive (needing to be ran) and all CPUs are idle, the scheduler failed to schedule properly.
+	 *   Jobs blocked on I/O do not need a core.
+	 */
+	if (sim->jobs_alive > sim->jobs_blocked && cores_working == 0)
+	{
+		fprintf(error_stream(sim), "All cores are idle and at least one job remains unscheduled.\n");
+		print_available_jobs(error_stream(sim), jobs, sim->active_jobs);
+		return -1;
+	}
+
+
+	/*
+	 * 8. Increase time. Without a trace, stretches where nothing has arrived
+	 *    or is left to run, other than I/O, are skipped in one go.
+	 */
+	sim->time++;
+
+	if (!trace && sim->jobs_alive == sim->jobs_blocked && sim->deferred_ct == 0)
+	{
+		int next = -1;
+
+		if (sim->next_arrival < sim->total_jobs)
+		{
+			sort_arrivals(sim);
+			next = sim->arrivals[sim->next_arrival].key;
+		}
+		if (heap_size(&sim->io) > 0)
+		{
+			int wake = ((simulator_order_t *)heap_peek(&sim->io))->key;
+			if (next == -1 || wake < next)
+				next = wake;
+		}
+		if (sim->horizon >= 0 && next > sim->horizon)
+			next = sim->horizon;
+		if (next > sim->time)
+			sim->time = next;
+	}
+
+	return 1;
+}
+
+
+/**
+  Prints the averages and the other statistics of a finished simulation
+  that apply to its scheme, options and workload.
+
+  @param sim the simulation
+  @param out the stream to print to
+ */
+void simulator_print_summary(simulator_t *sim, FILE *out)
+{
+	priqueue_stats_t queue_stats;
+
+	fprintf(out, "Average Waiting Time: %.2f\n", scheduler_average_waiting_time_r(sim->scheduler));
+	fprintf(out, "Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time_r(sim->scheduler));
+	fprintf(out, "Average Response Time: %.2f\n", scheduler_average_response_time_r(sim->scheduler));
+
+	if (sim->options.per_core_queues)
+	{
+		fprintf(out, "Work Steals: %d\n", scheduler_steals_r(sim->scheduler));
+		fprintf(out, "Migrations: %d\n", scheduler_migrations_r(sim->scheduler));
+	}
+	if (sim->options.cache_penalty > 0 || sim->options.affinity > 0)
+		fprintf(out, "Cache Misses: %d\n", scheduler_cache_misses_r(sim->scheduler));
+	if (sim->options.cache_penalty > 0)
+		fprintf(out, "Penalty Time: %d\n", scheduler_penalty_time_r(sim->scheduler));
+	if (sim->options.aging > 0)
+		fprintf(out, "Maximum Waiting Time: %d\n", scheduler_max_waiting_time_r(sim->scheduler));
+	if (sim->has_bursts)
+		fprintf(out, "CPU Utilization: %.2f%%\n", 100 * scheduler_cpu_utilization_r(sim->scheduler));
+	if (sim->options.admission != ADMIT_ALL)
+	{
+		fprintf(out, "Rejected Jobs: %d\n", scheduler_rejected_jobs_r(sim->scheduler));
+		fprintf(out, "Deferrals: %d\n", scheduler_deferrals_r(sim->scheduler));
+		fprintf(out, "Average Admission Delay: %.2f\n", scheduler_average_admission_delay_r(sim->scheduler));
+	}
+	if (sim->has_deadlines)
+	{
+		int deadline_jobs = scheduler_deadline_jobs_r(sim->scheduler);
+		int misses = scheduler_deadline_misses_r(sim->scheduler);
+
+		fprintf(out, "Deadline Misses: %d of %d\n", misses, deadline_jobs);
+		fprintf(out, "Deadline Miss Ratio: %.2f\n", (deadline_jobs > 0 ? misses / (float)deadline_jobs : 0.0));
+		fprintf(out, "Tardiness p50/p95/p99/max: %d/%d/%d/%d\n",
+				scheduler_tardiness_percentile_r(sim->scheduler, 50), scheduler_tardiness_percentile_r(sim->scheduler, 95),
+				scheduler_tardiness_percentile_r(sim->scheduler, 99), scheduler_tardiness_percentile_r(sim->scheduler, 100));
+	}
+	for (int i = 0; i < sim->options.groups; i++)
+	{
+		fprintf(out, "\nGroup %d (weight %d): %d job(s), %lld time unit(s) of CPU\n", i,
+				scheduler_group_weight_r(sim->scheduler, i), scheduler_group_jobs_r(sim->scheduler, i), scheduler_group_cpu_time_r(sim->scheduler, i));
+		fprintf(out, "  Average Waiting Time: %.2f\n", scheduler_group_average_waiting_time_r(sim->scheduler, i));
+		fprintf(out, "  Average Turnaround Time: %.2f\n", scheduler_group_average_turnaround_time_r(sim->scheduler, i));
+		fprintf(out, "  Average Response Time: %.2f\n", scheduler_group_average_response_time_r(sim->scheduler, i));
+	}
+
+	// Only builds with PRIQUEUE_STATS count the work of the queues, since the scheduler started or was restored.
+	if (scheduler_queue_stats_r(sim->scheduler, &queue_stats) == 0)
+	{
+		fprintf(out, "\nQueue Comparisons: %lld\n", queue_stats.comparisons);
+		fprintf(out, "Queue Offers: %lld (%.2f node(s) traversed per offer)\n", queue_stats.offers,
+				(queue_stats.offers > 0 ? queue_stats.traversed / (double)queue_stats.offers : 0.0));
+		fprintf(out, "Queue Allocations: %lld\n", queue_stats.allocations);
+		fprintf(out, "Queue High-Water Mark: %d\n", queue_stats.high_water);
+	}
+}
+
+
+/**
+  Runs the simulation until every job has finished, writing the header,
+  the per time unit trace and the final timing diagram and averages to the
+  trace stream if one is set. A simulation restored from a snapshot only
+  notes the time it resumes at in place of the header.
+
+  @param sim the simulation
+  @return 0 if every job finished
+  @return 2 if a checkpoint could not be written
+  @return 3 if the scheduler made an invalid decision
+ */
+int simulator_run(simulator_t *sim)
+{
+	FILE *trace = sim->trace;
+	int i, status;
+
+	if (trace && sim->resumed)
+		fprintf(trace, "Resumed %d core(s) and %d job(s) using %s at time %d...\n\n", sim->cores, sim->active_jobs, simulator_scheme_name(sim->scheme), sim->time);
+	else if (trace)
+	{
+		fprintf(trace, "Loaded %d core(s) and %d job(s) using %s", sim->cores, sim->total_jobs, simulator_scheme_name(sim->scheme));
+		if (sim->scheme == RR || sim->scheme == STRIDE)
+			fprintf(trace, " with a quantum of %d", sim->options.quantum);
+		else if (sim->scheme == LOTTERY)
+			fprintf(trace, " with a quantum of %d and a seed of %u", sim->options.quantum, sim->options.seed);
+		else if (sim->scheme == MLFQ)
+		{
+			fprintf(trace, " with quanta of ");
+			for (i = 0; i < sim->options.levels; i++)
+				fprintf(trace, (i == 0 ? "%d" : ", %d"), sim->options.level_quantum[i]);
+			if (sim->options.boost > 0)
+				fprintf(trace, " and a boost every %d", sim->options.boost);
+		}
+		else if ((sim->scheme == PRI || sim->scheme == PPRI) && sim->options.aging > 0)
+			fprintf(trace, " aging priorities by one every %d time unit(s)", sim->options.aging);
+		else if (sim->scheme == CFS)
+			fprintf(trace, " with a target latency of %d and a minimum granularity of %d", sim->options.latency, sim->options.min_granularity);
+		if (sim->options.per_core_queues)
+			fprintf(trace, " on per-core run queues with a migration cost of %d", sim->options.migration_cost);
+		if (sim->options.cache_penalty > 0)
+			fprintf(trace, " with a cache penalty of %d", sim->options.cache_penalty);
+		if (sim->options.affinity > 0)
+			fprintf(trace, " preferring affinity within %d job(s)", sim->options.affinity);
+		if (sim->options.speeds != NULL)
+		{
+			fprintf(trace, " on cores of speed ");
+			for (i = 0; i < sim->cores; )
+			{
+				int speed = scheduler_core_speed_r(sim->scheduler, i);
+				int first = i;
+
+				while (i < sim->cores && scheduler_core_speed_r(sim->scheduler, i) == speed)
+					i++;
+				fprintf(trace, (first == 0 ? "%dx%g" : ", %dx%g"), i - first, speed / (double)SCHEDULER_SPEED_UNIT);
+			}
+		}
+		if (sim->options.placement == PLACE_FASTEST)
+			fprintf(trace, " placing jobs on the fastest idle core");
+		else if (sim->options.placement == PLACE_SHORT)
+			fprintf(trace, " placing shorter than average jobs on the fastest idle core");
+		else if (sim->options.placement == PLACE_PRIORITY)
+			fprintf(trace, " placing higher than average priority jobs on the fastest idle core");
+		if (sim->options.groups > 0)
+		{
+			fprintf(trace, " sharing the cores between %d group(s) weighted ", sim->options.groups);
+			for (i = 0; i < sim->options.groups; i++)
+				fprintf(trace, (i == 0 ? "%d" : ":%d"), scheduler_group_weight_r(sim->scheduler, i));
+		}
+		if (sim->options.admission == ADMIT_QUEUE)
+			fprintf(trace, " admitting jobs while fewer than %d wait", sim->options.admission_limit);
+		else if (sim->options.admission == ADMIT_BACKLOG)
+			fprintf(trace, " admitting jobs while at most %d time unit(s) of work are left", sim->options.admission_limit);
+		else if (sim->options.admission == ADMIT_TOKENS)
+			fprintf(trace, " admitting jobs with %d token(s) per priority, one more every %d time unit(s)",
+					sim->options.admission_limit, sim->options.admission_rate);
+		if (sim->options.admission != ADMIT_ALL)
+			fprintf(trace, (sim->options.admission_defer ? " and deferring the rest" : " and rejecting the rest"));
+		fprintf(trace, " scheduling...\n\n");
+	}
+
+	do
+	{
+		if (sim->checkpoint_every > 0 && sim->time >= sim->next_checkpoint && sim->active_jobs > 0 && write_checkpoint(sim) != 0)
+		{
+			fprintf(stderr, "Unable to write checkpoint \"%s\".\n", sim->checkpoint_path);
+			return 2;
+		}
+	} while ((status = simulator_step(sim)) > 0);
+
+	if (status < 0)
+		return 3;
+
+	if (trace)
+	{
+		fprintf(trace, "FINAL TIMING DIAGRAM:\n");
+		for (i = 0; i < sim->cores; i++)
+			fprintf(trace, "  Core %2d: %s\n", i, sim->core_timing_diagram[i]);
+
+		fprintf(trace, "\n");
+		simulator_print_summary(sim, trace);
+	}
+
+	return 0;
+}
+
+
+/**
+  Simulates time units until the simulated time reaches end or every job
+  added so far has finished. Stretches with nothing to run are not skipped
+  past end, so jobs that arrive from end on may still be added, as when
+  several simulations are advanced in lockstep.
+
+  @param sim the simulation
+  @param end the time to stop at
+  @return 1 if jobs remain
+  @return 0 if every job has finished
+  @return -1 if the scheduler made an invalid decision
+ */
+int simulator_run_until(simulator_t *sim, int end)
+{
+	int status = 1;
+
+	sim->horizon = end;
+	while (sim->time < end && (status = simulator_step(sim)) > 0)
+		;
+	sim->horizon = -1;
+
+	return (status < 0 ? -1 : sim->active_jobs > 0);
+}
+
+
+/**
+  Returns the current simulated time.
+
+  @param sim the simulation
+ */
+int simulator_time(simulator_t *sim)
+{
+	return sim->time;
+}
+
+
+/**
+  Returns the number of cores of the simulation.
+
+  @param sim the simulation
+ */
+int simulator_cores(simulator_t *sim)
+{
+	return sim->cores;
+}
+
+
+/**
+  Returns the number of jobs added to the simulation that have not
+  finished, including those yet to arrive.
+
+  @param sim the simulation
+ */
+int simulator_active_jobs(simulator_t *sim)
+{
+	return sim->active_jobs;
+}
+
+
+/**
+  Returns the time units of work left on the jobs that have not finished,
+  including those yet to arrive and any migration costs they were charged.
+
+  @param sim the simulation
+ */
+long long simulator_backlog(simulator_t *sim)
+{
+	return sim->backlog;
+}
+
+
+/**
+  Returns the scheduler instance driven by the simulation, for example to
+  read its averages once the simulation is done.
+
+  @param sim the simulation
+ */
+scheduler_t *simulator_scheduler(simulator_t *sim)
+{
+	return sim->scheduler;
+}
+
+/*
+ * Snapshots hold every field in the machine's own layout, as those of the
+ * scheduler do, so they are read back by the same build on the same kind of
+ * machine.
+ */
+#define SIMULATOR_SNAPSHOT_MAGIC 0x53494d32
+
+static void save_value(FILE *out, const void *value, size_t size)
+{
+	if (size > 0)
+		fwrite(value, size, 1, out);
+}
+
+
+static int load_value(FILE *in, void *value, size_t size)
+{
+	return size == 0 || fread(value, size, 1, in) == 1;
+}
+
+
+/**
+  Writes the complete state of a simulation to a compact binary snapshot:
+  its configuration, its scheduler instance, every job not yet finished,
+  including those yet to arrive or blocked on I/O, which job each core runs
+  and how much of its time slice is left, and the timing diagram so far.
+  simulator_restore() reads it back into a simulation that carries on
+  exactly as this one would have.
+
+  @param sim the simulation
+  @param out the stream to write to
+  @return 0 on success
+  @return -1 if writing failed
+ */
+int simulator_save(simulator_t *sim, FILE *out)
+{
+	int magic = SIMULATOR_SNAPSHOT_MAGIC;
+	int has_speeds = (sim->options.speeds != NULL);
+	int has_diagram = (sim->core_timing_diagram != NULL);
+	int i;
+
+	save_value(out, &magic, sizeof(magic));
+	save_value(out, &sim->cores, sizeof(sim->cores));
+	save_value(out, &sim->scheme, sizeof(sim->scheme));
+	save_value(out, &sim->options, sizeof(sim->options));
+	save_value(out, &has_speeds, sizeof(has_speeds));
+	if (scheduler_save_r(sim->scheduler, out) != 0)
+		return -1;
+
+	save_value(out, &sim->total_jobs, sizeof(sim->total_jobs));
+	save_value(out, &sim->active_jobs, sizeof(sim->active_jobs));
+	save_value(out, &sim->jobs_alive, sizeof(sim->jobs_alive));
+	save_value(out, &sim->time, sizeof(sim->time));
+	save_value(out, &sim->has_deadlines, sizeof(sim->has_deadlines));
+	save_value(out, &sim->has_bursts, sizeof(sim->has_bursts));
+	save_value(out, &sim->backlog, sizeof(sim->backlog));
+	save_value(out, &sim->jobs_blocked, sizeof(sim->jobs_blocked));
+	save_value(out, &sim->next_arrival, sizeof(sim->next_arrival));
+	save_value(out, &sim->arrivals_sorted, sizeof(sim->arrivals_sorted));
+
+	// The jobs, in the order of the list, each followed by its bursts.
+	for (i = 0; i < sim->active_jobs; i++)
+	{
+		save_value(out, &sim->jobs[i], sizeof(simulator_job_list_t));
+		if (sim->jobs[i].bursts != NULL)
+			save_value(out, sim->jobs[i].bursts, sim->jobs[i].burst_ct * sizeof(int));
+	}
+	save_value(out, sim->position, sim->total_jobs * sizeof(int));
+	save_value(out, sim->arrivals, sim->total_jobs * sizeof(simulator_order_t));
+	save_value(out, sim->core_job, sim->cores * sizeof(int));
+	save_value(out, sim->quantum_clock, sim->cores * sizeof(int));
+
+	// I/O completions, in the order of the heap so that it comes back alike.
+	int io_ct = heap_size(&sim->io);
+	save_value(out, &io_ct, sizeof(io_ct));
+	for (i = 0; i < io_ct; i++)
+		save_value(out, heap_at(&sim->io, i), sizeof(simulator_order_t));
+	save_value(out, &sim->deferred_ct, sizeof(sim->deferred_ct));
+	save_value(out, sim->deferred, sim->deferred_ct * sizeof(int));
+
+	save_value(out, &has_diagram, sizeof(has_diagram));
+	for (i = 0; has_diagram && i < sim->cores; i++)
+	{
+		save_value(out, &sim->core_timing_diagram_len[i], sizeof(int));
+		save_value(out, sim->core_timing_diagram[i], sim->core_timing_diagram_len[i]);
+	}
+	save_value(out, &magic, sizeof(magic));
+
+	return (ferror(out) ? -1 : 0);
+}
+
+
+/**
+  Creates a simulation from a snapshot written by simulator_save(). It has
+  no trace until one is set, and its run carries on from the time of the
+  snapshot, without the header. More jobs may be added to it before it
+  runs, as long as they arrive no earlier than that time, to see how the
+  rest of the run would go with them.
+
+  @param in the stream to read from
+  @return the restored simulation
+  @return NULL if the stream does not hold a valid snapshot or memory ran out
+ */
+simulator_t *simulator_restore(FILE *in)
+{
+	int magic, cores, has_speeds, has_diagram, io_ct, i;
+	scheme_t scheme;
+	scheduler_options_t options;
+
+	if (!load_value(in, &magic, sizeof(magic)) || magic != SIMULATOR_SNAPSHOT_MAGIC
+			|| !load_value(in, &cores, sizeof(cores)) || !load_value(in, &scheme, sizeof(scheme))
+			|| !load_value(in, &options, sizeof(options)) || !load_value(in, &has_speeds, sizeof(has_speeds)))
+		return NULL;
+
+	scheduler_t *scheduler = scheduler_restore(in);
+	if (scheduler == NULL)
+		return NULL;
+
+	// The scheduler kept the speeds and weights the pointers led to.
+	options.speeds = NULL;
+	options.group_weights = NULL;
+
+	simulator_t *sim = simulator_create(cores, scheme, &options);
+	scheduler_destroy(sim->scheduler);
+	sim->scheduler = scheduler;
+	sim->resumed = 1;
+
+	if (has_speeds)
+	{
+		sim->speeds = malloc(cores * sizeof(int));
+		for (i = 0; i < cores; i++)
+			sim->speeds[i] = scheduler_core_speed_r(scheduler, i);
+		sim->options.speeds = sim->speeds;
+	}
+
+	int ok = load_value(in, &sim->total_jobs, sizeof(sim->total_jobs))
+			&& load_value(in, &sim->active_jobs, sizeof(sim->active_jobs))
+			&& load_value(in, &sim->jobs_alive, sizeof(sim->jobs_alive))
+			&& load_value(in, &sim->time, sizeof(sim->time))
+			&& load_value(in, &sim->has_deadlines, sizeof(sim->has_deadlines))
+			&& load_value(in, &sim->has_bursts, sizeof(sim->has_bursts))
+			&& load_value(in, &sim->backlog, sizeof(sim->backlog))
+			&& load_value(in, &sim->jobs_blocked, sizeof(sim->jobs_blocked))
+			&& load_value(in, &sim->next_arrival, sizeof(sim->next_arrival))
+			&& load_value(in, &sim->arrivals_sorted, sizeof(sim->arrivals_sorted))
+			&& sim->active_jobs >= 0 && sim->total_jobs >= sim->active_jobs
+			&& sim->next_arrival >= 0 && sim->next_arrival <= sim->total_jobs;
+
+	int active_jobs = (ok ? sim->active_jobs : 0);
+	sim->active_jobs = 0;
+	if (ok && active_jobs > sim->jobs_ct)
+	{
+		free(sim->jobs);
+		sim->jobs_ct = active_jobs;
+		sim->jobs = malloc(sim->jobs_ct * sizeof(simulator_job_list_t));
+	}
+	if (ok && sim->total_jobs > sim->arrivals_ct)
+	{
+		free(sim->arrivals);
+		free(sim->position);
+		sim->arrivals_ct = sim->total_jobs;
+		sim->arrivals = malloc(sim->arrivals_ct * sizeof(simulator_order_t));
+		sim->position = malloc(sim->arrivals_ct * sizeof(int));
+	}
+	if (sim->jobs == NULL || sim->arrivals == NULL || sim->position == NULL)
+		ok = 0;
+
+	for (i = 0; ok && i < active_jobs; i++)
+	{
+		simulator_job_list_t *job = &sim->jobs[i];
+
+		if (!(ok = load_value(in, job, sizeof(simulator_job_list_t))))
+			break;
+
+		int has_bursts = (job->bursts != NULL);
+		job->bursts = NULL;
+		sim->active_jobs++;
+		if (has_bursts)
+		{
+			job->bursts = (job->burst_ct > 1 ? malloc(job->burst_ct * sizeof(int)) : NULL);
+			ok = (job->bursts != NULL && load_value(in, job->bursts, job->burst_ct * sizeof(int)));
+		}
+	}
+
+	ok = ok && load_value(in, sim->position, sim->total_jobs * sizeof(int))
+			&& load_value(in, sim->arrivals, sim->total_jobs * sizeof(simulator_order_t))
+			&& load_value(in, sim->core_job, cores * sizeof(int))
+			&& load_value(in, sim->quantum_clock, cores * sizeof(int))
+			&& load_value(in, &io_ct, sizeof(io_ct));
+
+	for (i = 0; ok && i < io_ct; i++)
+	{
+		simulator_order_t *event = malloc(sizeof(simulator_order_t));
+
+		ok = (event != NULL && load_value(in, event, sizeof(simulator_order_t)));
+		if (ok)
+			heap_offer(&sim->io, event);
+		else
+			free(event);
+	}
+
+	ok = ok && load_value(in, &sim->deferred_ct, sizeof(sim->deferred_ct)) && sim->deferred_ct >= 0 && sim->deferred_ct <= sim->total_jobs;
+	if (ok && sim->deferred_ct > 0)
+	{
+		sim->deferred_size = sim->deferred_ct;
+		sim->deferred = malloc(sim->deferred_size * sizeof(int));
+		ok = (sim->deferred != NULL && load_value(in, sim->deferred, sim->deferred_ct * sizeof(int)));
+	}
+
+	ok = ok && load_value(in, &has_diagram, sizeof(has_diagram));
+	if (ok && has_diagram)
+	{
+		sim->core_timing_diagram = malloc(cores * sizeof(char *));
+		sim->core_timing_diagram_len = calloc(cores, sizeof(int));
+		sim->core_timing_diagram_size = malloc(cores * sizeof(int));
+
+		for (i = 0; i < cores; i++)
+		{
+			int len = 0;
+
+			ok = ok && load_value(in, &len, sizeof(len)) && len >= 0;
+			sim->core_timing_diagram_size[i] = 1024;
+			while (ok && sim->core_timing_diagram_size[i] <= len)
+				sim->core_timing_diagram_size[i] *= 2;
+			sim->core_timing_diagram[i] = malloc(sim->core_timing_diagram_size[i] + 1);
+			sim->core_timing_diagram[i][0] = '\0';
+
+			if (ok && load_value(in, sim->core_timing_diagram[i], len))
+			{
+				sim->core_timing_diagram[i][len] = '\0';
+				sim->core_timing_diagram_len[i] = len;
+			}
+			else
+				ok = 0;
+		}
+	}
+
+	if (!ok || !load_value(in, &magic, sizeof(magic)) || magic != SIMULATOR_SNAPSHOT_MAGIC)
+	{
+		simulator_destroy(sim);
+		return NULL;
+	}
+
+	return sim;
+}
+
+
+/**
+  Makes simulator_run() write a snapshot of the simulation every so many
+  time units, each replacing the one before only once it is complete, so
+  that a run cut short can be picked up with simulator_restore().
+
+  @param sim the simulation
+  @param every time units between snapshots, 0 for none
+  @param path the file to write the snapshots to, which must stay valid
+  while the simulation runs
+ */
+void simulator_set_checkpoint(simulator_t *sim, int every, const char *path)
+{
+	sim->checkpoint_every = (every > 0 ? every : 0);
+	sim->checkpoint_path = path;
+	if (every > 0)
+		sim->next_checkpoint = (sim->time / every + 1) * every;
+}
+
+
+/*
+ * Writes a snapshot next to the checkpoint file and moves it in place, so
+ * that the file always holds a complete snapshot.
+ */
+static int write_checkpoint(simulator_t *sim)
+{
+	char temp_path[strlen(sim->checkpoint_path) + 5];
+	sprintf(temp_path, "%s.tmp", sim->checkpoint_path);
+
+	FILE *out = fopen(temp_path, "wb");
+	if (out == NULL)
+		return -1;
+
+	int status = simulator_save(sim, out);
+	if (fclose(out) != 0 || status != 0 || rename(temp_path, sim->checkpoint_path) != 0)
+	{
+		remove(temp_path);
+		return -1;
+	}
+
+	sim->next_checkpoint = (sim->time / sim->checkpoint_every + 1) * sim->checkpoint_every;
+	return 0;
+}
+
+
+
+/**
+  Frees a simulation and its scheduler instance.
+
+  @param sim the simulation
+ */
+void simulator_destroy(simulator_t *sim)
+{
+	scheduler_destroy(sim->scheduler);
+
+	if (sim->core_timing_diagram != NULL)
+	{
+		for (int i = 0; i < sim->cores; i++)
+			free(sim->core_timing_diagram[i]);
+		free(sim->core_timing_diagram);
+		free(sim->core_timing_diagram_len);
+		free(sim->core_timing_diagram_size);
+	}
+
+	for (int i = 0; i < sim->active_jobs; i++)
+		free(sim->jobs[i].bursts);
+	while (heap_size(&sim->io) > 0)
+		free(heap_poll(&sim->io));
+	heap_destroy(&sim->io);
+
+	free(sim->quantum_clock);
+	free(sim->speeds);
+	free(sim->series_responses);
+	free(sim->deferred);
+	free(sim->core_job);
+	free(sim->position);
+	free(sim->arrivals);
+	free(sim->jobs);
+	free(sim);
+}
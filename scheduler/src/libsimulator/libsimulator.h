@@ -0,0 +1,92 @@
+/** @file libsimulator.h
+ */
+
+#ifndef LIBSIMULATOR_H_
+#define LIBSIMULATOR_H_
+
+#include <stdio.h>
+
+#include "../libscheduler/libscheduler.h"
+#include "../libeventlog/libeventlog.h"
+
+/**
+  A job as described by one line of a workload file. A deadline of 0 means
+  the job has none, and jobs of workloads without groups are all in group 0.
+  A job that does I/O has burst_ct bursts, alternately CPU and I/O and
+  starting and ending with CPU, whose lengths are in bursts; run_time is the
+  first. Other jobs have a single burst and bursts is NULL. A job needs
+  cores cores at the same time, which only gang scheduling supports; 0 or 1
+  means a single one.
+*/
+typedef struct _simulator_job_t
+{
+	int arrival_time;
+	int run_time;
+	int priority;
+	int deadline;
+	int group;
+	int burst_ct;
+	int *bursts;
+	int cores;
+} simulator_job_t;
+
+/**
+  Lower bounds on what any scheme can achieve on a workload, as filled in
+  by simulator_bounds(). The simulator counts time in whole units, so no
+  schedule it runs beats them.
+*/
+typedef struct _simulator_bounds_t
+{
+	double srpt_turnaround_time;   ///< Average turnaround time of SRPT on a single core as fast as all the cores together
+	double alone_turnaround_time;  ///< Average turnaround time of the jobs if each had the fastest core to itself
+	double turnaround_time;        ///< Lower bound on the average turnaround time, the higher of the two above
+	double waiting_time;           ///< Lower bound on the average waiting time, 0 when the cores differ in speed
+	int work_makespan;             ///< Time the cores need for all the work, working flat out from each arrival on
+	int critical_makespan;         ///< Latest arrival plus running time, and I/O, of any job
+	int makespan;                  ///< Lower bound on when the last job finishes, the higher of the two above
+} simulator_bounds_t;
+
+/**
+  A function told of a scheduling event: what happened, when, to which job
+  and on which core, -1 for events that do not happen on one.
+*/
+typedef void (*simulator_listener_t)(void *context, event_type_t type, int time, int job, int core);
+
+/**
+  A simulation of one scheduler instance over a set of jobs. Simulations do
+  not share any state, so several may run concurrently.
+*/
+typedef struct _simulator_t simulator_t;
+
+simulator_job_t *simulator_read_jobs   (FILE *file, int *count);
+void             simulator_free_jobs   (simulator_job_t *jobs, int count);
+int              simulator_parse_scheme(const char *name, scheme_t *scheme, scheduler_options_t *options);
+int              simulator_parse_cores (const char *spec, int *cores, int **speeds);
+int              simulator_parse_weights(const char *spec, int *count, int **weights);
+int              simulator_parse_admission(const char *spec, scheduler_options_t *options);
+int              simulator_count_groups(const simulator_job_t *jobs, int count);
+const char      *simulator_scheme_name (scheme_t scheme);
+int              simulator_bounds      (const simulator_job_t *jobs, int count, int cores, const int *speeds, simulator_bounds_t *bounds);
+
+simulator_t *simulator_create   (int cores, scheme_t scheme, const scheduler_options_t *options);
+void         simulator_set_trace(simulator_t *sim, FILE *trace, int show_queue);
+void         simulator_set_series(simulator_t *sim, FILE *out, int every);
+void         simulator_set_eventlog(simulator_t *sim, eventlog_t *events);
+void         simulator_set_listener(simulator_t *sim, simulator_listener_t listener, void *context);
+void         simulator_record_jobs(simulator_t *sim, int *response_times, int *turnaround_times);
+int          simulator_add_job  (simulator_t *sim, const simulator_job_t *job);
+int          simulator_step     (simulator_t *sim);
+int          simulator_run      (simulator_t *sim);
+void         simulator_print_summary(simulator_t *sim, FILE *out);
+int          simulator_run_until(simulator_t *sim, int end);
+int          simulator_time     (simulator_t *sim);
+int          simulator_cores    (simulator_t *sim);
+int          simulator_active_jobs(simulator_t *sim);
+long long    simulator_backlog  (simulator_t *sim);
+scheduler_t *simulator_scheduler(simulator_t *sim);
+int          simulator_save     (simulator_t *sim, FILE *out);
+simulator_t *simulator_restore  (FILE *in);
+void         simulator_set_checkpoint(simulator_t *sim, int every, const char *path);
+void         simulator_destroy  (simulator_t *sim);
+
+#endif /* LIBSIMULATOR_H_ */
@@ -0,0 +1,564 @@
+/** @file libtune.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "libtune.h"
+
+/* Share of the larger side of the bracket the next quantum lies in, 2 - the golden ratio */
+#define GOLDEN_SECTION 0.3819660112501051
+
+/* Times a simulation is checked for being sure to lose, roughly */
+#define CHECKS_PER_RUN 32
+
+/*
+ * How far the search for one scheme has got: the objective under every
+ * quantum simulated so far, and the best of them.
+ */
+typedef struct _tune_scheme_t
+{
+	scheme_t scheme;
+	double *values;
+	char *states;
+	double best;
+	int best_quantum;
+	tune_result_t *result;
+} tune_scheme_t;
+
+/* What is known of the objective under a quantum */
+enum {QUANTUM_UNKNOWN = 0, QUANTUM_EXACT, QUANTUM_WORSE};
+
+typedef struct _tune_task_t
+{
+	int scheme;
+	int quantum;
+} tune_task_t;
+
+/**
+  Stores the state of a search, shared by its threads.
+*/
+typedef struct _tune_t
+{
+	const simulator_job_t *jobs;
+	int count;
+	int cores;
+	const scheduler_options_t *common;
+	tune_objective_t objective;
+	int min_quantum, max_quantum;
+	int chunk;
+
+	tune_scheme_t *schemes;
+	int schemes_ct;
+	double best;
+
+	tune_task_t *tasks;
+	int tasks_ct;
+	atomic_int next;
+	void (*run_task)(struct _tune_t *t, tune_task_t *task);
+
+	pthread_mutex_t lock;
+	int failed;
+} tune_t;
+
+
+/**
+  Parses the name of an objective: mean-response, p99-response,
+  mean-turnaround or p99-turnaround.
+
+  @param name the name of the objective
+  @param objective receives the objective
+  @return 0 on success
+  @return -1 if the name is not an objective
+ */
+int tune_parse_objective(const char *name, tune_objective_t *objective)
+{
+	for (tune_objective_t o = TUNE_MEAN_RESPONSE; o <= TUNE_P99_TURNAROUND; o++)
+	{
+		if (strcasecmp(name, tune_objective_name(o)) == 0)
+		{
+			*objective = o;
+			return 0;
+		}
+	}
+	return -1;
+}
+
+
+/**
+  Returns the name of an objective, as taken by tune_parse_objective().
+
+  @param objective the objective
+ */
+const char *tune_objective_name(tune_objective_t objective)
+{
+	switch (objective)
+	{
+		case TUNE_MEAN_RESPONSE: return "mean-response";
+		case TUNE_P99_RESPONSE: return "p99-response";
+		case TUNE_MEAN_TURNAROUND: return "mean-turnaround";
+		case TUNE_P99_TURNAROUND: return "p99-turnaround";
+	}
+	return "";
+}
+
+
+/**
+  Returns whether a scheme has a quantum to tune: RR, STRIDE and LOTTERY.
+
+  @param scheme the scheme
+ */
+int tune_has_quantum(scheme_t scheme)
+{
+	return (scheme == RR || scheme == STRIDE || scheme == LOTTERY);
+}
+
+
+/*
+ * The name simulator_parse_scheme() takes for a scheme, with its default
+ * parameters, and the prefix of its name with a quantum.
+ */
+static const char *base_name(scheme_t scheme)
+{
+	switch (scheme)
+	{
+		case FCFS: return "fcfs";
+		case SJF: return "sjf";
+		case PSJF: return "psjf";
+		case PRI: return "pri";
+		case PPRI: return "ppri";
+		case RR: return "rr";
+		case MLFQ: return "mlfq";
+		case CFS: return "cfs";
+		case EDF: return "edf";
+		case PEDF: return "pedf";
+		case STRIDE: return "stride";
+		case LOTTERY: return "lottery";
+	}
+	return "";
+}
+
+
+/**
+  Writes the name of the scheme of a result as the simulator's -s option
+  takes it, with the quantum found, as in rr7.
+
+  @param result the result
+  @param label receives the name
+  @param size the size of label
+  @return the length of the name, as snprintf()
+ */
+int tune_scheme_label(const tune_result_t *result, char *label, size_t size)
+{
+	if (tune_has_quantum(result->scheme))
+		return snprintf(label, size, "%s%d", base_name(result->scheme), result->quantum);
+	return snprintf(label, size, "%s", base_name(result->scheme));
+}
+
+
+/*
+ * Whether the jobs finished so far already make the objective exceed the
+ * threshold, whatever the others do: their times only add to a mean, and
+ * once more jobs than lie above the 99th percentile exceed the threshold,
+ * so does the percentile.
+ */
+static int sure_to_exceed(tune_t *t, const int *times, double threshold)
+{
+	long long sum = 0;
+	int above = 0;
+	int rank = (int)ceil(0.99 * t->count);
+
+	for (int i = 0; i < t->count; i++)
+	{
+		if (times[i] >= 0)
+		{
+			sum += times[i];
+			above += (times[i] > threshold);
+		}
+	}
+
+	if (t->objective == TUNE_MEAN_RESPONSE || t->objective == TUNE_MEAN_TURNAROUND)
+		return sum / (double)t->count > threshold;
+	return above >= t->count - rank + 1;
+}
+
+
+static int compare_int(const void *a, const void *b)
+{
+	return *(const int *)a - *(const int *)b;
+}
+
+
+/*
+ * Simulates the workload under a scheme and quantum, stopping as soon as
+ * the objective is sure to exceed the threshold. Returns QUANTUM_EXACT with
+ * the objective, QUANTUM_WORSE if stopped, or -1 if the simulation failed.
+ */
+static int evaluate(tune_t *t, scheme_t scheme, int quantum, double threshold, double *value)
+{
+	scheduler_options_t options;
+	int *times = malloc(t->count * sizeof(int));
+	int status;
+
+	simulator_parse_scheme(scheme == RR ? "rr1" : base_name(scheme), &scheme, &options);
+	if (tune_has_quantum(scheme))
+		options.quantum = quantum;
+	options.per_core_queues = t->common->per_core_queues;
+	options.migration_cost = t->common->migration_cost;
+	options.cache_penalty = t->common->cache_penalty;
+	options.affinity = t->common->affinity;
+	options.speeds = t->common->speeds;
+	options.placement = t->common->placement;
+	options.aging = t->common->aging;
+	options.groups = t->common->groups;
+	options.group_weights = t->common->group_weights;
+
+	simulator_t *sim = simulator_create(t->cores, scheme, &options);
+	if (sim == NULL || times == NULL)
+	{
+		if (sim != NULL)
+			simulator_destroy(sim);
+		free(times);
+		return -1;
+	}
+
+	for (int i = 0; i < t->count; i++)
+	{
+		times[i] = -1;
+		if (simulator_add_job(sim, &t->jobs[i]) < 0)
+		{
+			simulator_destroy(sim);
+			free(times);
+			return -1;
+		}
+	}
+
+	if (t->objective == TUNE_MEAN_RESPONSE || t->objective == TUNE_P99_RESPONSE)
+		simulator_record_jobs(sim, times, NULL);
+	else
+		simulator_record_jobs(sim, NULL, times);
+
+	while ((status = simulator_run_until(sim, simulator_time(sim) + t->chunk)) > 0)
+		if (sure_to_exceed(t, times, threshold))
+			break;
+
+	if (status > 0)
+		status = QUANTUM_WORSE;
+	else if (status == 0)
+	{
+		status = QUANTUM_EXACT;
+		if (t->objective == TUNE_MEAN_RESPONSE || t->objective == TUNE_MEAN_TURNAROUND)
+		{
+			long long sum = 0;
+			for (int i = 0; i < t->count; i++)
+				sum += times[i];
+			*value = sum / (double)t->count;
+		}
+		else
+		{
+			qsort(times, t->count, sizeof(int), compare_int);
+			*value = times[(int)ceil(0.99 * t->count) - 1];
+		}
+	}
+
+	simulator_destroy(sim);
+	free(times);
+	return status;
+}
+
+
+/*
+ * Simulates a quantum of a scheme against the best of that scheme so far,
+ * or for a scheme without a quantum against the best of every scheme, and
+ * notes what came of it. Lower quanta win ties, so that the outcome does
+ * not depend on the order the threads finish in.
+ */
+static int try_quantum(tune_t *t, tune_scheme_t *ts, int quantum)
+{
+	int index = quantum - t->min_quantum;
+	double value = 0;
+
+	pthread_mutex_lock(&t->lock);
+	double threshold = (tune_has_quantum(ts->scheme) ? ts->best : t->best);
+	pthread_mutex_unlock(&t->lock);
+
+	int state = evaluate(t, ts->scheme, quantum, threshold, &value);
+
+	pthread_mutex_lock(&t->lock);
+	if (state < 0)
+		t->failed = 1;
+	else
+	{
+		ts->result->evaluations++;
+		if (state == QUANTUM_WORSE)
+		{
+			ts->result->stopped++;
+			value = threshold;
+		}
+		ts->states[index] = state;
+		ts->values[index] = value;
+
+		if (state == QUANTUM_EXACT && (value < ts->best || (value == ts->best && quantum < ts->best_quantum)))
+		{
+			ts->best = value;
+			ts->best_quantum = quantum;
+		}
+		if (state == QUANTUM_EXACT && value < t->best)
+			t->best = value;
+	}
+	pthread_mutex_unlock(&t->lock);
+
+	return state;
+}
+
+
+static void run_grid_task(tune_t *t, tune_task_t *task)
+{
+	try_quantum(t, &t->schemes[task->scheme], task->quantum);
+}
+
+
+/*
+ * Narrows the quantum of a scheme down around the best point of the grid,
+ * by golden-section search over the bracket between its neighbours: the
+ * next quantum tried lies in the larger side of the bracket, and the side
+ * of the worse of the two points is dropped. A quantum that loses is
+ * stopped as soon as it is sure to, as it only needs to be known to be
+ * worse than the best.
+ */
+static void run_refine_task(tune_t *t, tune_task_t *task)
+{
+	tune_scheme_t *ts = &t->schemes[task->scheme];
+	int x = ts->best_quantum;
+	double fx = ts->best;
+	int a = t->min_quantum - 1, b = t->max_quantum + 1;
+
+	if (x == 0)
+		return;
+
+	// The bracket ends at the grid points on either side, or just past the range.
+	for (int q = x - 1; q >= t->min_quantum; q--)
+	{
+		if (ts->states[q - t->min_quantum] != QUANTUM_UNKNOWN)
+		{
+			a = q;
+			break;
+		}
+	}
+	for (int q = x + 1; q <= t->max_quantum; q++)
+	{
+		if (ts->states[q - t->min_quantum] != QUANTUM_UNKNOWN)
+		{
+			b = q;
+			break;
+		}
+	}
+
+	while (b - a > 2 && !t->failed)
+	{
+		int step, y;
+
+		if (x - a > b - x)
+		{
+			step = (int)lround(GOLDEN_SECTION * (x - a));
+			y = x - (step > 0 ? step : 1);
+		}
+		else
+		{
+			step = (int)lround(GOLDEN_SECTION * (b - x));
+			y = x + (step > 0 ? step : 1);
+		}
+
+		int state = ts->states[y - t->min_quantum];
+		if (state == QUANTUM_UNKNOWN)
+			state = try_quantum(t, ts, y);
+		if (state < 0)
+			return;
+
+		double fy = ts->values[y - t->min_quantum];
+		if (state == QUANTUM_EXACT && (fy < fx || (fy == fx && y < x)))
+		{
+			if (y < x)
+				b = x;
+			else
+				a = x;
+			x = y;
+			fx = fy;
+		}
+		else if (y < x)
+			a = y;
+		else
+			b = y;
+	}
+}
+
+
+static void *worker(void *arg)
+{
+	tune_t *t = arg;
+	int i;
+
+	while ((i = atomic_fetch_add(&t->next, 1)) < t->tasks_ct && !t->failed)
+		t->run_task(t, &t->tasks[i]);
+	return NULL;
+}
+
+
+/*
+ * Runs the tasks on up to the given number of threads, the calling thread
+ * among them, and waits for all of them.
+ */
+static void run_tasks(tune_t *t, void (*run_task)(tune_t *, tune_task_t *), int threads)
+{
+	if (threads > t->tasks_ct)
+		threads = t->tasks_ct;
+
+	pthread_t ids[threads > 1 ? threads - 1 : 1];
+	int started = 0;
+
+	t->run_task = run_task;
+	atomic_store(&t->next, 0);
+	for (int i = 0; i < threads - 1; i++)
+		if (pthread_create(&ids[started], NULL, worker, t) == 0)
+			started++;
+
+	worker(t);
+	for (int i = 0; i < started; i++)
+		pthread_join(ids[i], NULL);
+}
+
+
+/**
+  Searches for the scheme, and the quantum of those that have one, that
+  minimizes an objective on a workload.
+
+  The quantum of each scheme that has one is first simulated on a coarse
+  grid, doubling from the lowest quantum, then narrowed down by
+  golden-section search around the best point of the grid. The grid
+  points, and then the schemes, are simulated in parallel, each in its own
+  simulation, and every simulation stops as soon as the jobs it has
+  finished make it sure to be worse than the best so far. Schemes without a
+  quantum are simulated once. The objective is unlikely to be unimodal in
+  the quantum, so the search finds a good quantum, not always the best.
+
+  @param jobs the jobs
+  @param count the number of jobs
+  @param cores the number of cores
+  @param common the options every scheme runs with on top of its own, as
+  for a cluster's nodes
+  @param schemes the schemes to search
+  @param schemes_ct the number of schemes
+  @param objective what to minimize
+  @param min_quantum the lowest quantum to try
+  @param max_quantum the highest quantum to try
+  @param threads the number of threads to simulate with
+  @param results receives the outcome for each scheme, in the same order
+  @return 0 on success
+  @return -1 if memory ran out or a scheduler made an invalid decision
+ */
+int tune_search(const simulator_job_t *jobs, int count, int cores, const scheduler_options_t *common,
+		const scheme_t *schemes, int schemes_ct, tune_objective_t objective,
+		int min_quantum, int max_quantum, int threads, tune_result_t *results)
+{
+	tune_t t;
+	simulator_bounds_t bounds;
+	int range = max_quantum - min_quantum + 1;
+	int grid[64], grid_ct = 0;
+	int i;
+
+	if (count == 0 || min_quantum < 1 || range < 1 || simulator_bounds(jobs, count, cores, common->speeds, &bounds) != 0)
+		return -1;
+
+	memset(&t, 0, sizeof(t));
+	t.jobs = jobs;
+	t.count = count;
+	t.cores = cores;
+	t.common = common;
+	t.objective = objective;
+	t.min_quantum = min_quantum;
+	t.max_quantum = max_quantum;
+	t.chunk = (bounds.makespan / CHECKS_PER_RUN > 0 ? bounds.makespan / CHECKS_PER_RUN : 1);
+	t.best = INFINITY;
+	t.schemes_ct = schemes_ct;
+	t.schemes = calloc(schemes_ct, sizeof(tune_scheme_t));
+	pthread_mutex_init(&t.lock, NULL);
+
+	// A few ranges are small enough to try every quantum of.
+	if (range <= 8)
+		for (int q = min_quantum; q <= max_quantum; q++)
+			grid[grid_ct++] = q;
+	else
+	{
+		for (long long q = min_quantum; q < max_quantum; q *= 2)
+			grid[grid_ct++] = q;
+		grid[grid_ct++] = max_quantum;
+	}
+
+	t.tasks = malloc(schemes_ct * grid_ct * sizeof(tune_task_t));
+	for (i = 0; i < schemes_ct; i++)
+	{
+		tune_scheme_t *ts = &t.schemes[i];
+		int quanta = (tune_has_quantum(schemes[i]) ? range : 1);
+
+		ts->scheme = schemes[i];
+		ts->values = malloc(quanta * sizeof(double));
+		ts->states = calloc(quanta, sizeof(char));
+		ts->best = INFINITY;
+		ts->result = &results[i];
+		memset(ts->result, 0, sizeof(tune_result_t));
+		ts->result->scheme = schemes[i];
+	}
+
+	/*
+	 * 1. The grid of every scheme with a quantum, interleaved so that the
+	 *    threads work on every scheme at once, then the schemes without.
+	 */
+	for (int g = 0; g < grid_ct; g++)
+		for (i = 0; i < schemes_ct; i++)
+			if (tune_has_quantum(schemes[i]))
+				t.tasks[t.tasks_ct++] = (tune_task_t){ i, grid[g] };
+	for (i = 0; i < schemes_ct; i++)
+		if (!tune_has_quantum(schemes[i]))
+			t.tasks[t.tasks_ct++] = (tune_task_t){ i, min_quantum };
+	run_tasks(&t, run_grid_task, threads);
+
+	/*
+	 * 2. The golden-section search of every scheme with a quantum, each
+	 *    scheme on its own thread.
+	 */
+	t.tasks_ct = 0;
+	for (i = 0; i < schemes_ct; i++)
+		if (tune_has_quantum(schemes[i]))
+			t.tasks[t.tasks_ct++] = (tune_task_t){ i, 0 };
+	if (!t.failed && t.tasks_ct > 0)
+		run_tasks(&t, run_refine_task, threads);
+
+	for (i = 0; i < schemes_ct; i++)
+	{
+		tune_scheme_t *ts = &t.schemes[i];
+
+		if (tune_has_quantum(ts->scheme))
+		{
+			ts->result->quantum = ts->best_quantum;
+			ts->result->value = ts->best;
+			ts->result->exact = 1;
+		}
+		else
+		{
+			ts->result->value = ts->values[0];
+			ts->result->exact = (ts->states[0] == QUANTUM_EXACT);
+		}
+		free(ts->values);
+		free(ts->states);
+	}
+
+	free(t.tasks);
+	free(t.schemes);
+	pthread_mutex_destroy(&t.lock);
+	return (t.failed ? -1 : 0);
+}
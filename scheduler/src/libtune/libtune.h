@@ -0,0 +1,39 @@
+/** @file libtune.h
+ */
+
+#ifndef LIBTUNE_H_
+#define LIBTUNE_H_
+
+#include "../libsimulator/libsimulator.h"
+
+/**
+  What a search minimizes, over the jobs of the workload
+*/
+typedef enum {TUNE_MEAN_RESPONSE = 0, TUNE_P99_RESPONSE, TUNE_MEAN_TURNAROUND, TUNE_P99_TURNAROUND} tune_objective_t;
+
+/**
+  The outcome of a search for one scheme: the best quantum found and the
+  objective under it. A scheme without a quantum is simulated once, and
+  that run may be stopped early once it is sure to lose to another scheme,
+  in which case the value is only a lower bound.
+*/
+typedef struct _tune_result_t
+{
+	scheme_t scheme;
+	int quantum;       ///< Best quantum found, 0 for schemes without one
+	double value;      ///< Objective under that quantum
+	int exact;         ///< 0 if the run stopped early and value is a lower bound
+	int evaluations;   ///< Simulations run for this scheme
+	int stopped;       ///< Simulations stopped early, sure to be worse than the best so far
+} tune_result_t;
+
+int         tune_parse_objective(const char *name, tune_objective_t *objective);
+const char *tune_objective_name (tune_objective_t objective);
+int         tune_has_quantum    (scheme_t scheme);
+int         tune_scheme_label   (const tune_result_t *result, char *label, size_t size);
+
+int         tune_search         (const simulator_job_t *jobs, int count, int cores, const scheduler_options_t *common,
+                                 const scheme_t *schemes, int schemes_ct, tune_objective_t objective,
+                                 int min_quantum, int max_quantum, int threads, tune_result_t *results);
+
+#endif /* LIBTUNE_H_ */
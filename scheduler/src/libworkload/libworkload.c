@@ -0,0 +1,428 @@
+/** @file libworkload.c
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <limits.h>
+#include <math.h>
+
+#include "libworkload.h"
+
+
+/**
+  Fills in the default workload: Poisson arrivals at 70% utilization of a
+  single core, exponential running times with a mean of 10 and priorities 1
+  through 5 in equal proportion.
+
+  @param config the configuration to initialize
+ */
+void workload_config_init(workload_config_t *config)
+{
+	memset(config, 0, sizeof(*config));
+
+	config->seed = 1;
+	config->jobs = 0;
+	config->cores = 1;
+	config->utilization = 0.7;
+
+	config->arrival = ARRIVAL_POISSON;
+	config->burst_factor = 10.0;
+	config->burst_fraction = 0.1;
+	config->burst_length = 100.0;
+
+	config->runtime = RUNTIME_EXP;
+	config->mean_run_time = 10.0;
+	config->shape = 0.0;
+	config->max_run_time = 0;
+
+	config->unique_arrivals = 0;
+
+	config->num_priorities = 5;
+	for (int i = 0; i < config->num_priorities; i++){
+		config->priorities[i] = i + 1;
+		config->weights[i] = 1.0;
+	}
+}
+
+
+/**
+  Parses a priority mix of the form "priority[:weight],...", for example
+  "1:10,2:30,3:60". A missing weight counts as 1.
+
+  @param config the configuration to store the mix in
+  @param mix the textual priority mix
+  @return 0 on success
+  @return -1 if the mix is malformed
+ */
+int workload_parse_mix(workload_config_t *config, const char *mix)
+{
+	int count = 0;
+	const char *p = mix;
+
+	while (*p != '\0'){
+		char *end;
+
+		if (count == WORKLOAD_MAX_PRIORITIES){
+			return -1;
+		}
+
+		long priority = strtol(p, &end, 10);
+		if (end == p){
+			return -1;
+		}
+		p = end;
+
+		double weight = 1.0;
+		if (*p == ':'){
+			weight = strtod(p + 1, &end);
+			if (end == p + 1 || weight < 0.0){
+				return -1;
+			}
+			p = end;
+		}
+
+		config->priorities[count] = (int)priority;
+		config->weights[count] = weight;
+		count++;
+
+		if (*p == ','){
+			p++;
+		}
+		else if (*p != '\0'){
+			return -1;
+		}
+	}
+
+	if (count == 0){
+		return -1;
+	}
+
+	config->num_priorities = count;
+	return 0;
+}
+
+
+/**
+  Parses an arrival process: "poisson", or "mmpp[:factor[:fraction[:length]]]"
+  with the fields of the MMPP that are given overriding those in config.
+
+  @param config the configuration to store the arrival process in
+  @param spec the textual arrival process
+  @return 0 on success
+  @return -1 if the arrival process is malformed
+ */
+int workload_parse_arrivals(workload_config_t *config, const char *spec)
+{
+	if (strcasecmp(spec, "poisson") == 0){
+		config->arrival = ARRIVAL_POISSON;
+		return 0;
+	}
+
+	if (strncasecmp(spec, "mmpp", 4) != 0 || (spec[4] != '\0' && spec[4] != ':')){
+		return -1;
+	}
+
+	config->arrival = ARRIVAL_MMPP;
+
+	const char *p = spec + 4;
+	double *fields[] = { &config->burst_factor, &config->burst_fraction, &config->burst_length };
+	for (int i = 0; i < 3 && *p == ':'; i++){
+		char *end;
+		*fields[i] = strtod(p + 1, &end);
+		if (end == p + 1){
+			return -1;
+		}
+		p = end;
+	}
+
+	return (*p == '\0' ? 0 : -1);
+}
+
+
+/**
+  Parses a running time distribution: "exp", "pareto[:alpha]" or
+  "lognormal[:sigma]". The shape defaults to 1.5 for Pareto and 1 for
+  lognormal.
+
+  @param config the configuration to store the distribution in
+  @param spec the textual distribution
+  @return 0 on success
+  @return -1 if the distribution is malformed
+ */
+int workload_parse_run_times(workload_config_t *config, const char *spec)
+{
+	const char *shape = strchr(spec, ':');
+	size_t length = (shape != NULL ? (size_t)(shape - spec) : strlen(spec));
+
+	if (length == 3 && strncasecmp(spec, "exp", 3) == 0){
+		config->runtime = RUNTIME_EXP;
+		config->shape = 0.0;
+	}
+	else if (length == 6 && strncasecmp(spec, "pareto", 6) == 0){
+		config->runtime = RUNTIME_PARETO;
+		config->shape = 1.5;
+	}
+	else if (length == 9 && strncasecmp(spec, "lognormal", 9) == 0){
+		config->runtime = RUNTIME_LOGNORMAL;
+		config->shape = 1.0;
+	}
+	else{
+		return -1;
+	}
+
+	if (shape != NULL){
+		if (config->runtime == RUNTIME_EXP){
+			return -1;
+		}
+		config->shape = atof(shape + 1);
+	}
+
+	return 0;
+}
+
+
+static uint64_t rotl(uint64_t x, int k)
+{
+	return (x << k) | (x >> (64 - k));
+}
+
+
+/**
+  Returns the next 64 random bits from a xoshiro256** generator.
+
+  @param state the generator state
+  @return 64 uniformly distributed bits
+ */
+uint64_t workload_rand(uint64_t state[4])
+{
+	uint64_t result = rotl(state[1] * 5, 7) * 9;
+	uint64_t t = state[1] << 17;
+
+	state[2] ^= state[0];
+	state[3] ^= state[1];
+	state[1] ^= state[2];
+	state[0] ^= state[3];
+	state[2] ^= t;
+	state[3] = rotl(state[3], 45);
+
+	return result;
+}
+
+
+/**
+  Returns a uniformly distributed double in the open interval (0, 1).
+
+  @param state the generator state
+ */
+double workload_uniform(uint64_t state[4])
+{
+	return ((workload_rand(state) >> 11) + 0.5) * (1.0 / 9007199254740992.0);
+}
+
+
+/**
+  Seeds a generator state by expanding seed with splitmix64, so that nearby
+  seeds still produce unrelated streams.
+
+  @param state the generator state
+  @param seed any 64-bit value
+ */
+void workload_seed(uint64_t state[4], uint64_t seed)
+{
+	for (int i = 0; i < 4; i++){
+		uint64_t z = (seed += 0x9e3779b97f4a7c15ULL);
+		z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+		z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+		state[i] = z ^ (z >> 31);
+	}
+}
+
+
+static double exponential(workload_t *w, double mean)
+{
+	return -mean * log(workload_uniform(w->rng));
+}
+
+
+static double normal(workload_t *w)
+{
+	double u1 = workload_uniform(w->rng);
+	double u2 = workload_uniform(w->rng);
+	return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
+
+
+/**
+  Initializes a generator.
+
+  The arrival rate is chosen so that the offered load, arrival rate times
+  mean running time, equals utilization times cores.
+
+  @param w the generator to initialize
+  @param config the workload parameters
+  @return 0 on success
+  @return -1 if the parameters are out of range
+ */
+int workload_init(workload_t *w, const workload_config_t *config)
+{
+	memset(w, 0, sizeof(*w));
+	w->config = *config;
+
+	if (config->cores <= 0 || config->utilization <= 0.0 || config->mean_run_time < 1.0){
+		return -1;
+	}
+	if (config->num_priorities <= 0 || config->num_priorities > WORKLOAD_MAX_PRIORITIES){
+		return -1;
+	}
+	if (config->runtime == RUNTIME_PARETO && config->shape <= 1.0){
+		return -1;
+	}
+	if (config->runtime == RUNTIME_LOGNORMAL && config->shape <= 0.0){
+		return -1;
+	}
+
+	double total = 0.0;
+	for (int i = 0; i < config->num_priorities; i++){
+		total += config->weights[i];
+		w->cumulative[i] = total;
+	}
+	if (total <= 0.0){
+		return -1;
+	}
+	for (int i = 0; i < config->num_priorities; i++){
+		w->cumulative[i] /= total;
+	}
+
+	double rate = config->utilization * config->cores / config->mean_run_time;
+
+	if (config->arrival == ARRIVAL_MMPP){
+		double f = config->burst_fraction;
+		double b = config->burst_factor;
+
+		if (f <= 0.0 || f >= 1.0 || b < 1.0 || config->burst_length <= 0.0){
+			return -1;
+		}
+
+		// State 0 is calm, state 1 is the burst. Weighting the two rates by
+		// the time spent in each keeps the long run rate at the target.
+		w->rate[0] = rate / (f * b + (1.0 - f));
+		w->rate[1] = w->rate[0] * b;
+		w->dwell[1] = config->burst_length;
+		w->dwell[0] = config->burst_length * (1.0 - f) / f;
+	}
+	else{
+		w->rate[0] = w->rate[1] = rate;
+		w->dwell[0] = w->dwell[1] = INFINITY;
+	}
+
+	workload_seed(w->rng, config->seed);
+
+	w->state = 0;
+	w->state_left = (config->arrival == ARRIVAL_MMPP ? exponential(w, w->dwell[0]) : INFINITY);
+	w->last_arrival = -1;
+	return 0;
+}
+
+
+static double next_gap(workload_t *w)
+{
+	double gap = 0.0;
+
+	for (;;){
+		double step = exponential(w, 1.0 / w->rate[w->state]);
+
+		if (step <= w->state_left){
+			w->state_left -= step;
+			return gap + step;
+		}
+
+		// Both the arrival and the state change are memoryless, so the
+		// unused part of the draw can simply be discarded.
+		gap += w->state_left;
+		w->state ^= 1;
+		w->state_left = exponential(w, w->dwell[w->state]);
+	}
+}
+
+
+static int next_run_time(workload_t *w)
+{
+	double mean = w->config.mean_run_time;
+	double shape = w->config.shape;
+	double x;
+
+	switch (w->config.runtime){
+		case RUNTIME_PARETO:
+			x = mean * (shape - 1.0) / shape / pow(workload_uniform(w->rng), 1.0 / shape);
+			break;
+		case RUNTIME_LOGNORMAL:
+			x = exp(log(mean) - shape * shape / 2.0 + shape * normal(w));
+			break;
+		default:
+			x = exponential(w, mean);
+			break;
+	}
+
+	if (x > INT_MAX){
+		x = INT_MAX;
+	}
+
+	int run_time = (int)llround(x);
+	if (run_time < 1){
+		run_time = 1;
+	}
+	if (w->config.max_run_time > 0 && run_time > w->config.max_run_time){
+		run_time = w->config.max_run_time;
+	}
+	return run_time;
+}
+
+
+static int next_priority(workload_t *w)
+{
+	double u = workload_uniform(w->rng);
+	int i;
+
+	for (i = 0; i < w->config.num_priorities - 1; i++){
+		if (u < w->cumulative[i]){
+			break;
+		}
+	}
+	return w->config.priorities[i];
+}
+
+
+/**
+  Produces the next job of the workload. Jobs are returned in nondecreasing
+  order of arrival time, the first one arriving at time 0.
+
+  @param w the generator
+  @param job receives the generated job
+  @return 1 if a job was produced
+  @return 0 if the configured number of jobs has already been produced
+ */
+int workload_next(workload_t *w, workload_job_t *job)
+{
+	if (w->config.jobs > 0 && w->emitted >= w->config.jobs){
+		return 0;
+	}
+
+	if (w->emitted > 0){
+		w->clock += next_gap(w);
+	}
+
+	int arrival_time = (w->clock > INT_MAX ? INT_MAX : (int)w->clock);
+	if (w->config.unique_arrivals && arrival_time <= w->last_arrival){
+		arrival_time = w->last_arrival + 1;
+		w->clock = arrival_time;
+	}
+	w->last_arrival = arrival_time;
+
+	job->arrival_time = arrival_time;
+	job->run_time = next_run_time(w);
+	job->priority = next_priority(w);
+
+	w->emitted++;
+	return 1;
+}
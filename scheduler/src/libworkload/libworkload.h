@@ -0,0 +1,91 @@
+/** @file libworkload.h
+ */
+
+#ifndef LIBWORKLOAD_H_
+#define LIBWORKLOAD_H_
+
+#include <stdint.h>
+
+/**
+  Constants which represent the supported job arrival processes
+*/
+typedef enum {ARRIVAL_POISSON = 0, ARRIVAL_MMPP} arrival_t;
+
+/**
+  Constants which represent the supported running time distributions
+*/
+typedef enum {RUNTIME_EXP = 0, RUNTIME_PARETO, RUNTIME_LOGNORMAL} runtime_t;
+
+#define WORKLOAD_MAX_PRIORITIES 32
+
+/**
+  Parameters of a synthetic workload. Fill in with workload_config_init()
+  and then override the fields of interest.
+*/
+typedef struct _workload_config_t
+{
+	uint64_t seed;
+	long long jobs;
+
+	int cores;
+	double utilization;
+
+	arrival_t arrival;
+	double burst_factor;     ///< MMPP: arrival rate in the burst state over the rate in the calm state
+	double burst_fraction;   ///< MMPP: long run fraction of time spent in the burst state
+	double burst_length;     ///< MMPP: mean time units spent in the burst state per visit
+
+	runtime_t runtime;
+	double mean_run_time;
+	double shape;            ///< Pareto alpha or lognormal sigma
+	int max_run_time;        ///< 0 for no cap
+
+	int unique_arrivals;     ///< Force strictly increasing arrival times
+
+	int num_priorities;
+	int priorities[WORKLOAD_MAX_PRIORITIES];
+	double weights[WORKLOAD_MAX_PRIORITIES];
+} workload_config_t;
+
+/**
+  A single generated job
+*/
+typedef struct _workload_job_t
+{
+	int arrival_time;
+	int run_time;
+	int priority;
+} workload_job_t;
+
+/**
+  Generator state. The generator only ever holds the state needed to produce
+  the next job, so traces of any length can be streamed.
+*/
+typedef struct _workload_t
+{
+	workload_config_t config;
+	uint64_t rng[4];
+	long long emitted;
+
+	double clock;
+	double rate[2];
+	double dwell[2];
+	int state;
+	double state_left;
+	int last_arrival;
+
+	double cumulative[WORKLOAD_MAX_PRIORITIES];
+} workload_t;
+
+void     workload_config_init (workload_config_t *config);
+int      workload_parse_mix   (workload_config_t *config, const char *mix);
+int      workload_parse_arrivals(workload_config_t *config, const char *spec);
+int      workload_parse_run_times(workload_config_t *config, const char *spec);
+int      workload_init        (workload_t *w, const workload_config_t *config);
+int      workload_next        (workload_t *w, workload_job_t *job);
+
+uint64_t workload_rand        (uint64_t state[4]);
+double   workload_uniform     (uint64_t state[4]);
+void     workload_seed        (uint64_t state[4], uint64_t seed);
+
+#endif /* LIBWORKLOAD_H_ */
@@ -64,6 +64,13 @@ int main()
 		printf("%d ", *((int *)priqueue_at(&q2, i)) );
 	printf("\n");
 
+	priqueue_stats_t stats;
+	if (priqueue_stats(&q2, &stats) == 0)
+		printf("Reverse order queue offers, comparisons, nodes traversed, allocations, high-water mark: %lld %lld %lld %lld %d (expected 3 5 0 3 3).\n",
+				stats.offers, stats.comparisons, stats.traversed, stats.allocations, stats.high_water);
+	else
+		printf("Queue counters: not kept (built without PRIQUEUE_STATS).\n");
+
 	priqueue_destroy(&q2);
 	priqueue_destroy(&q);
 
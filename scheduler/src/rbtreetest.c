@@ -0,0 +1,107 @@
+/** @file rbtreetest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "librbtree/librbtree.h"
+
+int compare1(const void * a, const void * b)
+{
+	return ( *(int*)a - *(int*)b );
+}
+
+/*
+ * Returns the black height of the subtree, or -1 if a red-black property
+ * or the ordering is violated anywhere in it.
+ */
+int check(rbtree_t *t, rbnode_t *node)
+{
+	if (node == NULL)
+		return 1;
+
+	if (node->left != NULL && (node->left->parent != node || t->comparer(node->left->value, node->value) > 0))
+		return -1;
+	if (node->right != NULL && (node->right->parent != node || t->comparer(node->right->value, node->value) < 0))
+		return -1;
+	if (node->red && ((node->left != NULL && node->left->red) || (node->right != NULL && node->right->red)))
+		return -1;
+
+	int left = check(t, node->left);
+	int right = check(t, node->right);
+
+	if (left < 0 || left != right)
+		return -1;
+	return left + !node->red;
+}
+
+int main()
+{
+	rbtree_t t;
+	int failures = 0;
+
+	rbtree_init(&t, compare1);
+
+	/* Pupulate some data... */
+	int n = 100000;
+	int *values = malloc(n * sizeof(int));
+
+	int i;
+	srand(678);
+	for (i = 0; i < n; i++)
+		values[i] = rand() % (n / 4);
+
+	for (i = 0; i < n; i++)
+		rbtree_insert(&t, &values[i]);
+	printf("Total elements: %d (expected %d).\n", rbtree_size(&t), n);
+	if (rbtree_size(&t) != n)
+		failures++;
+
+	int valid = (check(&t, t.m_root) > 0 && !t.m_root->red);
+	printf("Tree is balanced: %s (expected yes).\n", valid ? "yes" : "no");
+	if (!valid)
+		failures++;
+
+	/* Remove every other value, then make sure polling yields the rest in order. */
+	int removed = 0;
+	for (i = 0; i < n; i += 2)
+		removed += rbtree_remove(&t, &values[i]);
+	printf("Elements removed: %d (expected %d).\n", removed, n / 2);
+	if (removed != n / 2)
+		failures++;
+
+	valid = (check(&t, t.m_root) > 0 && !t.m_root->red);
+	printf("Tree is balanced: %s (expected yes).\n", valid ? "yes" : "no");
+	if (!valid)
+		failures++;
+
+	int last = -1, sorted = 1, polled = 0;
+	while (rbtree_size(&t) > 0)
+	{
+		int min = *(int *)rbtree_min(&t);
+		int val = *(int *)rbtree_poll(&t);
+
+		if (val != min || val < last)
+			sorted = 0;
+		last = val;
+		polled++;
+	}
+	printf("Elements polled in order: %d %s (expected %d yes).\n", polled, sorted ? "yes" : "no", n - n / 2);
+	if (!sorted || polled != n - n / 2)
+		failures++;
+
+	printf("Smallest element of an empty tree: %s (expected NULL).\n", rbtree_min(&t) == NULL ? "NULL" : "not NULL");
+	if (rbtree_min(&t) != NULL)
+		failures++;
+
+	for (i = 0; i < n; i++)
+		rbtree_insert(&t, &values[i]);
+	rbtree_destroy(&t);
+	printf("Total elements after destroy: %d (expected 0).\n", rbtree_size(&t));
+	if (rbtree_size(&t) != 0)
+		failures++;
+
+	free(values);
+
+	return (failures == 0 ? 0 : 1);
+}
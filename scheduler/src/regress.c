@@ -0,0 +1,599 @@
+/** @file regress.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "libsimulator/libsimulator.h"
+
+#define MAX_NAME 256
+
+
+/**
+  One expected output file and the result of checking it
+*/
+typedef struct _regress_case_t
+{
+	char name[MAX_NAME];
+	int proc, cores;
+	char scheme[32];
+	int per_core_queues, migration_cost;
+	int cache_penalty, affinity;
+	int big_cores, placement;
+	int aging;
+	int group_weight;
+	int admission_limit, admission_defer;
+
+	int passed;
+	double elapsed;
+	char message[1024];
+} regress_case_t;
+
+typedef struct _regress_t
+{
+	const char *dir;
+	regress_case_t *cases;
+	int count;
+	atomic_int next;
+} regress_t;
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s [-j <threads>] [examples directory]\n", program_name);
+	fprintf(stderr, "       %s -j 4 examples\n", program_name);
+}
+
+
+/*
+ * Parses what follows the scheme in the name of an expected output file:
+ * any of "-pM" for per-core run queues with a migration cost of M, "-wN"
+ * for a cache penalty of N, "-aK" for an affinity window of K, "-bB" for
+ * the first B cores running at twice the speed of the rest, "-fF" for
+ * placement policy F, "-gG" for priorities aging by one every G time
+ * units, "-hH" for the cores shared between the groups of jobs with
+ * group 0 weighing H and the others 1, and "-qQ" or "-dQ" for jobs
+ * admitted while fewer than Q wait, the rest rejected or deferred, then
+ * ".out".
+ */
+static int parse_variant(const char *rest, regress_case_t *rc)
+{
+	while (strcmp(rest, ".out") != 0)
+	{
+		char flag;
+		int value, length = 0;
+
+		if (sscanf(rest, "-%c%d%n", &flag, &value, &length) != 2 || length == 0 || value < 0)
+			return -1;
+
+		switch (flag)
+		{
+			case 'p':
+				rc->per_core_queues = 1;
+				rc->migration_cost = value;
+				break;
+			case 'w':
+				rc->cache_penalty = value;
+				break;
+			case 'a':
+				rc->affinity = value;
+				break;
+			case 'b':
+				rc->big_cores = value;
+				break;
+			case 'g':
+				rc->aging = value;
+				break;
+			case 'h':
+				if (value == 0)
+					return -1;
+				rc->group_weight = value;
+				break;
+			case 'f':
+				if (value > PLACE_PRIORITY)
+					return -1;
+				rc->placement = value;
+				break;
+			case 'q':
+			case 'd':
+				rc->admission_limit = value;
+				rc->admission_defer = (flag == 'd');
+				break;
+			default:
+				return -1;
+		}
+		rest += length;
+	}
+
+	return 0;
+}
+
+
+static double now()
+{
+	struct timespec ts;
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+
+static char *read_file(const char *path)
+{
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+		return NULL;
+
+	size_t size = 0, capacity = 4096;
+	char *buffer = malloc(capacity);
+	size_t n;
+
+	while ((n = fread(buffer + size, 1, capacity - size - 1, file)) > 0)
+	{
+		size += n;
+		if (capacity - size - 1 == 0)
+		{
+			capacity *= 2;
+			buffer = realloc(buffer, capacity);
+		}
+	}
+
+	buffer[size] = '\0';
+	fclose(file);
+	return buffer;
+}
+
+
+/*
+ * Splits text into lines in place, dropping the scheduler's queue dump, the
+ * queue counters of builds with PRIQUEUE_STATS and blank lines. The queue
+ * format is implementation defined, so only the events, timing diagrams and
+ * averages are compared.
+ */
+static char **significant_lines(char *text, int *count)
+{
+	int capacity = 64;
+	char **lines = malloc(capacity * sizeof(char *));
+	char *save;
+	*count = 0;
+
+	for (char *line = strtok_r(text, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save))
+	{
+		if (strncmp(line, "  Queue:", 8) == 0 || strncmp(line, "ID: ", 4) == 0 || strncmp(line, "Queue ", 6) == 0 ||
+			strspn(line, " \t\r") == strlen(line))
+			continue;
+
+		if (*count == capacity)
+		{
+			capacity *= 2;
+			lines = realloc(lines, capacity * sizeof(char *));
+		}
+		lines[(*count)++] = line;
+	}
+
+	return lines;
+}
+
+
+/*
+ * Runs the simulation again, writing a snapshot about halfway through, and
+ * carries on from that snapshot in a new simulation. From the time it
+ * resumes at, its trace must match the uninterrupted run's. Returns 0 if
+ * it does, and fills in the message otherwise.
+ */
+static int check_checkpoint(int cores, scheme_t scheme, const scheduler_options_t *options,
+		const simulator_job_t *jobs, int jobs_ct, int end_time, char *message, size_t size)
+{
+	char path[] = "/tmp/regress-XXXXXX";
+	char *whole = NULL, *resumed = NULL;
+	size_t whole_size = 0, resumed_size = 0;
+	int every = end_time / 2 + 1;
+
+	if (end_time < 2)
+		return 0;
+
+	int fd = mkstemp(path);
+	if (fd == -1)
+	{
+		snprintf(message, size, "checkpoint could not be created");
+		return -1;
+	}
+	close(fd);
+
+	FILE *trace = open_memstream(&whole, &whole_size);
+	simulator_t *sim = simulator_create(cores, scheme, options);
+	simulator_set_trace(sim, trace, 0);
+	simulator_set_checkpoint(sim, every, path);
+	for (int i = 0; i < jobs_ct; i++)
+		simulator_add_job(sim, &jobs[i]);
+	int status = simulator_run(sim);
+	simulator_destroy(sim);
+	fclose(trace);
+
+	FILE *file = fopen(path, "rb");
+	sim = (status == 0 && file != NULL ? simulator_restore(file) : NULL);
+	if (file != NULL)
+		fclose(file);
+	remove(path);
+
+	if (sim == NULL)
+	{
+		snprintf(message, size, "checkpoint taken at time %d could not be restored", every);
+		free(whole);
+		return -1;
+	}
+
+	trace = open_memstream(&resumed, &resumed_size);
+	simulator_set_trace(sim, trace, 0);
+	status = simulator_run(sim);
+	simulator_destroy(sim);
+	fclose(trace);
+
+	// Both traces go on alike from the first time unit the resumed run simulated, up to the queue counters, which start over.
+	char *counters;
+	if ((counters = strstr(whole, "\nQueue Comparisons:")) != NULL)
+		*counters = '\0';
+	if ((counters = strstr(resumed, "\nQueue Comparisons:")) != NULL)
+		*counters = '\0';
+
+	char header[64] = "";
+	char *from = strstr(resumed, "=== [TIME ");
+	if (from != NULL)
+		snprintf(header, sizeof(header), "%.*s", (int)strcspn(from, "\n"), from);
+	char *in_whole = (from != NULL ? strstr(whole, header) : NULL);
+
+	int failed = (status != 0 || in_whole == NULL || strcmp(in_whole, from) != 0);
+	if (failed)
+		snprintf(message, size, "checkpoint taken at time %d resumes differently", every);
+
+	free(whole);
+	free(resumed);
+	return (failed ? -1 : 0);
+}
+
+
+/*
+ * Runs the simulation again with a time series, and without a trace, so
+ * that idle stretches are skipped. Every job must finish in one of its
+ * windows, with the response times adding up to the scheduler's average,
+ * and a snapshot of the scheduler's statistics at the end must agree with
+ * its averages. Returns 0 if so, and fills in the message otherwise.
+ */
+static int check_series(int cores, scheme_t scheme, const scheduler_options_t *options,
+		const simulator_job_t *jobs, int jobs_ct, char *message, size_t size)
+{
+	char *series = NULL;
+	size_t series_size = 0;
+	scheduler_stats_t stats;
+
+	FILE *out = open_memstream(&series, &series_size);
+	simulator_t *sim = simulator_create(cores, scheme, options);
+	simulator_set_series(sim, out, 5);
+	for (int i = 0; i < jobs_ct; i++)
+		simulator_add_job(sim, &jobs[i]);
+	int status = simulator_run(sim);
+	fclose(out);
+
+	scheduler_t *s = simulator_scheduler(sim);
+	scheduler_stats_snapshot_r(s, simulator_time(sim), &stats);
+
+	int completions = 0;
+	double response = 0;
+	char *save;
+	for (char *line = strtok_r(series, "\n", &save); line != NULL; line = strtok_r(NULL, "\n", &save))
+	{
+		int time, waiting, running, blocked, count;
+		float utilization, mean;
+
+		if (sscanf(line, "%d,%d,%d,%d,%f,%d,%f", &time, &waiting, &running, &blocked, &utilization, &count, &mean) == 7)
+		{
+			completions += count;
+			response += count * mean;
+		}
+	}
+
+	// Rejected jobs never finish.
+	int admitted = jobs_ct - scheduler_rejected_jobs_r(s);
+	float average = scheduler_average_response_time_r(s);
+	double error = (admitted > 0 ? response / admitted - average : 0);
+	int failed = (status != 0 || completions != admitted || error < -0.01 || error > 0.01);
+	if (failed)
+		snprintf(message, size, "time series counts %d job(s) with a mean response of %.2f", completions, (admitted > 0 ? response / admitted : 0));
+	else if (stats.finished_jobs != admitted || stats.waiting_jobs != 0 || stats.running_jobs != 0 || stats.blocked_jobs != 0
+			|| stats.average_waiting_time != scheduler_average_waiting_time_r(s)
+			|| stats.average_turnaround_time != scheduler_average_turnaround_time_r(s)
+			|| stats.average_response_time != average)
+	{
+		snprintf(message, size, "statistics snapshot at the end disagrees with the averages");
+		failed = 1;
+	}
+
+	simulator_destroy(sim);
+	free(series);
+	return (failed ? -1 : 0);
+}
+
+
+/*
+ * Checks the averages and the time the last job finished against the lower
+ * bounds of the workload, which no scheme may beat. Returns 0 if none
+ * does, and fills in the message otherwise. Cases that reject jobs are
+ * not checked, as their averages leave those jobs out.
+ */
+static int check_bounds(int cores, const scheduler_options_t *options, const simulator_job_t *jobs, int jobs_ct,
+		float waiting, float turnaround, int end_time, char *message, size_t size)
+{
+	simulator_bounds_t bounds;
+
+	if (simulator_bounds(jobs, jobs_ct, cores, options->speeds, &bounds) != 0)
+	{
+		snprintf(message, size, "bounds could not be computed");
+		return -1;
+	}
+
+	// The averages are rounded to two places in the trace.
+	if (turnaround < bounds.turnaround_time - 0.005 || waiting < bounds.waiting_time - 0.005 || end_time < bounds.makespan)
+	{
+		snprintf(message, size, "beats the lower bounds: waiting %.2f < %.2f, turnaround %.2f < %.2f or makespan %d < %d",
+				waiting, bounds.waiting_time, turnaround, bounds.turnaround_time, end_time, bounds.makespan);
+		return -1;
+	}
+
+	return 0;
+}
+
+
+static void run_case(regress_t *r, regress_case_t *c)
+{
+	char path[MAX_NAME * 2];
+	scheme_t scheme;
+	scheduler_options_t options;
+	int jobs_ct;
+
+	if (simulator_parse_scheme(c->scheme, &scheme, &options) != 0)
+	{
+		snprintf(c->message, sizeof(c->message), "unknown scheme \"%s\"", c->scheme);
+		return;
+	}
+	options.per_core_queues = c->per_core_queues;
+	options.migration_cost = c->migration_cost;
+	options.cache_penalty = c->cache_penalty;
+	options.affinity = c->affinity;
+	options.placement = c->placement;
+	options.aging = c->aging;
+	if (c->admission_limit > 0)
+	{
+		options.admission = ADMIT_QUEUE;
+		options.admission_limit = c->admission_limit;
+		options.admission_defer = c->admission_defer;
+	}
+
+	int speeds[c->cores];
+	if (c->big_cores > 0)
+	{
+		for (int i = 0; i < c->cores; i++)
+			speeds[i] = (i < c->big_cores ? 2 : 1) * SCHEDULER_SPEED_UNIT;
+		options.speeds = speeds;
+	}
+
+	snprintf(path, sizeof(path), "%s/proc%d.csv", r->dir, c->proc);
+	FILE *file = fopen(path, "r");
+	if (file == NULL)
+	{
+		snprintf(c->message, sizeof(c->message), "unable to open \"%s\"", path);
+		return;
+	}
+	simulator_job_t *jobs = simulator_read_jobs(file, &jobs_ct);
+	fclose(file);
+
+	if (jobs == NULL)
+	{
+		snprintf(c->message, sizeof(c->message), "illegal file format in \"%s\"", path);
+		return;
+	}
+
+	int groups = simulator_count_groups(jobs, jobs_ct);
+	int group_weights[groups];
+	if (c->group_weight > 0)
+	{
+		for (int i = 0; i < groups; i++)
+			group_weights[i] = (i == 0 ? c->group_weight : 1);
+		options.groups = groups;
+		options.group_weights = group_weights;
+	}
+
+	snprintf(path, sizeof(path), "%s/%s", r->dir, c->name);
+	char *expected = read_file(path);
+	if (expected == NULL)
+	{
+		snprintf(c->message, sizeof(c->message), "unable to open \"%s\"", path);
+		simulator_free_jobs(jobs, jobs_ct);
+		return;
+	}
+
+	/*
+	 * Simulate into memory. Every case has its own scheduler instance and
+	 * output buffer, so cases never interfere with each other.
+	 */
+	char *actual = NULL;
+	size_t actual_size = 0;
+	FILE *trace = open_memstream(&actual, &actual_size);
+
+	simulator_t *sim = simulator_create(c->cores, scheme, &options);
+	simulator_set_trace(sim, trace, 0);
+	for (int i = 0; i < jobs_ct; i++)
+		simulator_add_job(sim, &jobs[i]);
+	int status = simulator_run(sim);
+	int end_time = simulator_time(sim);
+	int rejected = scheduler_rejected_jobs_r(simulator_scheduler(sim));
+	float waiting = scheduler_average_waiting_time_r(simulator_scheduler(sim));
+	float turnaround = scheduler_average_turnaround_time_r(simulator_scheduler(sim));
+	simulator_destroy(sim);
+	fclose(trace);
+
+	int expected_ct, actual_ct;
+	char **expected_lines = significant_lines(expected, &expected_ct);
+	char **actual_lines = significant_lines(actual, &actual_ct);
+
+	int i;
+	for (i = 0; i < expected_ct && i < actual_ct; i++)
+		if (strcmp(expected_lines[i], actual_lines[i]) != 0)
+			break;
+
+	if (status != 0)
+	{
+		snprintf(c->message, sizeof(c->message), "simulation failed: %s", (actual_ct > 0 ? actual_lines[actual_ct - 1] : ""));
+	}
+	else if (i < expected_ct || i < actual_ct)
+	{
+		const char *e = (i < expected_ct ? expected_lines[i] : "<end of output>");
+		const char *a = (i < actual_ct ? actual_lines[i] : "<end of output>");
+		int summary = (i < expected_ct && strncmp(e, "Average", 7) == 0);
+
+		snprintf(c->message, sizeof(c->message), "%s differs at line %d\n      expected: %s\n      actual:   %s",
+				(summary ? "summary" : "trace"), i + 1, e, a);
+	}
+	else if (check_checkpoint(c->cores, scheme, &options, jobs, jobs_ct, end_time, c->message, sizeof(c->message)) == 0
+			&& check_series(c->cores, scheme, &options, jobs, jobs_ct, c->message, sizeof(c->message)) == 0
+			&& (rejected > 0 || check_bounds(c->cores, &options, jobs, jobs_ct, waiting, turnaround, end_time, c->message, sizeof(c->message)) == 0))
+		c->passed = 1;
+
+	free(expected_lines);
+	free(actual_lines);
+	free(expected);
+	free(actual);
+	simulator_free_jobs(jobs, jobs_ct);
+}
+
+
+static void *worker(void *arg)
+{
+	regress_t *r = arg;
+	int i;
+
+	while ((i = atomic_fetch_add(&r->next, 1)) < r->count)
+	{
+		double start = now();
+		run_case(r, &r->cases[i]);
+		r->cases[i].elapsed = now() - start;
+	}
+
+	return NULL;
+}
+
+
+static int compare_cases(const void *a, const void *b)
+{
+	return strcmp(((const regress_case_t *)a)->name, ((const regress_case_t *)b)->name);
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	int threads = sysconf(_SC_NPROCESSORS_ONLN);
+
+	while ((c = getopt(argc, argv, "j:")) != -1)
+	{
+		switch (c)
+		{
+			case 'j':
+				threads = atoi(optarg);
+
+				if (threads <= 0)
+				{
+					fprintf(stderr, "Option -j <threads> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	regress_t r;
+	r.dir = (optind < argc ? argv[optind] : "examples");
+	r.count = 0;
+	atomic_init(&r.next, 0);
+
+	/*
+	 * Collect every procN-cC-scheme.out file in the directory, along with
+	 * the variants of each, such as procN-cC-scheme-pM-wN.out.
+	 */
+	DIR *dir = opendir(r.dir);
+	if (dir == NULL)
+	{
+		fprintf(stderr, "Unable to open directory \"%s\".\n", r.dir);
+		return 2;
+	}
+
+	int capacity = 64;
+	r.cases = malloc(capacity * sizeof(regress_case_t));
+
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != NULL)
+	{
+		regress_case_t rc;
+		int length = 0;
+
+		memset(&rc, 0, sizeof(rc));
+		if (strlen(entry->d_name) >= MAX_NAME
+				|| sscanf(entry->d_name, "proc%d-c%d-%31[A-Za-z0-9]%n", &rc.proc, &rc.cores, rc.scheme, &length) != 3
+				|| length == 0 || parse_variant(entry->d_name + length, &rc) != 0)
+			continue;
+
+		strcpy(rc.name, entry->d_name);
+
+		if (r.count == capacity)
+		{
+			capacity *= 2;
+			r.cases = realloc(r.cases, capacity * sizeof(regress_case_t));
+		}
+		r.cases[r.count++] = rc;
+	}
+	closedir(dir);
+
+	qsort(r.cases, r.count, sizeof(regress_case_t), compare_cases);
+
+	if (threads > r.count)
+		threads = (r.count > 0 ? r.count : 1);
+
+
+	/*
+	 * Run the cases on all threads, then report in name order.
+	 */
+	double start = now();
+	pthread_t *workers = malloc(threads * sizeof(pthread_t));
+	for (int i = 0; i < threads; i++)
+		pthread_create(&workers[i], NULL, worker, &r);
+	for (int i = 0; i < threads; i++)
+		pthread_join(workers[i], NULL);
+	double elapsed = now() - start;
+
+	int passed = 0;
+	for (int i = 0; i < r.count; i++)
+	{
+		regress_case_t *rc = &r.cases[i];
+
+		printf("  %-4s %-24s %9.3f ms\n", (rc->passed ? "ok" : "FAIL"), rc->name, rc->elapsed * 1000.0);
+		if (!rc->passed)
+			printf("      %s\n", rc->message);
+
+		passed += rc->passed;
+	}
+
+	printf("\n%d of %d cases passed in %.3f ms using %d thread(s).\n", passed, r.count, elapsed * 1000.0, threads);
+
+	free(workers);
+	free(r.cases);
+
+	return (passed == r.count ? 0 : 1);
+}
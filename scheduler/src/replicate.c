@@ -0,0 +1,202 @@
+/** @file replicate.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "libreplicate/libreplicate.h"
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -n <jobs> -c <cores> -S <scheme>[,<scheme>...] [options]\n", program_name);
+	fprintf(stderr, "       %s -n 2000 -c 2 -u 0.9 -r pareto:1.5 -S rr2,rr8,psjf -R 100 -e 0.02 -j 4\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -S <schemes>     schemes to compare, as the simulator's -s takes them\n");
+	fprintf(stderr, "  -c <cores>       cores the schemes run on, and the utilization is relative to\n");
+	fprintf(stderr, "  -R <replications> most replications of each scheme (default 30)\n");
+	fprintf(stderr, "  -e <precision>   stop once every 95%% interval is within this fraction of its\n");
+	fprintf(stderr, "                   mean, as in 0.05 (default 0, run all replications)\n");
+	fprintf(stderr, "  -i <initial>     replications run before the intervals are first looked at (default 5)\n");
+	fprintf(stderr, "  -b <batch>       replications added while an interval is too wide (default 5)\n");
+	fprintf(stderr, "  -j <threads>     threads the replications are simulated with (default 1)\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Workload options, as for workloadgen:\n");
+	fprintf(stderr, "  -n <jobs>        number of jobs of each replication (default 1000)\n");
+	fprintf(stderr, "  -s <seed>        seed of the first replication; the next ones count up (default 1)\n");
+	fprintf(stderr, "  -u <util>        target utilization of the cores (default 0.7)\n");
+	fprintf(stderr, "  -m <mean>        mean running time (default 10)\n");
+	fprintf(stderr, "  -M <max>         cap on the running time (default none)\n");
+	fprintf(stderr, "  -a <arrivals>    poisson, or mmpp[:factor[:fraction[:length]]] (default poisson)\n");
+	fprintf(stderr, "  -r <run times>   exp, pareto[:alpha] or lognormal[:sigma] (default exp)\n");
+	fprintf(stderr, "  -p <mix>         priority mix as priority:weight,... (default 1,2,3,4,5)\n");
+	fprintf(stderr, "  -U               force strictly increasing arrival times\n");
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	replicate_experiment_t experiment;
+	char *scheme_list = NULL;
+	int *speeds = NULL;
+
+	replicate_experiment_init(&experiment);
+
+	/*
+	 * Parse command line options.
+	 */
+	while ((c = getopt(argc, argv, "S:c:R:e:i:b:j:n:s:u:m:M:a:r:p:U")) != -1)
+	{
+		switch (c)
+		{
+			case 'S': scheme_list = optarg; break;
+			case 'R': experiment.max_replications = atoi(optarg); break;
+			case 'e': experiment.precision = atof(optarg); break;
+			case 'i': experiment.min_replications = atoi(optarg); break;
+			case 'b': experiment.batch = atoi(optarg); break;
+			case 'j': experiment.threads = atoi(optarg); break;
+			case 'n': experiment.workload.jobs = atoll(optarg); break;
+			case 's': experiment.workload.seed = strtoull(optarg, NULL, 0); break;
+			case 'u': experiment.workload.utilization = atof(optarg); break;
+			case 'm': experiment.workload.mean_run_time = atof(optarg); break;
+			case 'M': experiment.workload.max_run_time = atoi(optarg); break;
+			case 'U': experiment.workload.unique_arrivals = 1; break;
+
+			case 'c':
+				if (simulator_parse_cores(optarg, &experiment.cores, &speeds) != 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number, or groups of cores with positive speeds. (Eg: -c 4:2.0,4:1.0)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				experiment.workload.cores = experiment.cores;
+				break;
+
+			case 'a':
+				if (workload_parse_arrivals(&experiment.workload, optarg) != 0)
+				{
+					fprintf(stderr, "Option -a <arrivals> requires poisson or mmpp[:factor[:fraction[:length]]].\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'r':
+				if (workload_parse_run_times(&experiment.workload, optarg) != 0)
+				{
+					fprintf(stderr, "Option -r <run times> requires exp, pareto[:alpha] or lognormal[:sigma].\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'p':
+				if (workload_parse_mix(&experiment.workload, optarg) != 0)
+				{
+					fprintf(stderr, "Option -p <mix> requires a list of priority:weight pairs. (Eg: -p 1:10,2:30,3:60)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (scheme_list == NULL)
+	{
+		fprintf(stderr, "Required option -S <schemes> is missing.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (optind != argc)
+	{
+		fprintf(stderr, "Unexpected argument \"%s\".\n", argv[optind]);
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (experiment.max_replications < 1 || experiment.min_replications < 1 || experiment.batch < 1 ||
+			experiment.threads < 1 || experiment.precision < 0)
+	{
+		fprintf(stderr, "Options -R, -i, -b and -j require positive numbers, and -e one no lower than 0.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+	if (experiment.min_replications > experiment.max_replications)
+		experiment.min_replications = experiment.max_replications;
+
+
+	/*
+	 * Parse the schemes, each with the options of the cores.
+	 */
+	int configs_ct = 1;
+	for (char *p = scheme_list; *p != '\0'; p++)
+		configs_ct += (*p == ',');
+
+	replicate_config_t *configs = calloc(configs_ct, sizeof(replicate_config_t));
+	replicate_result_t *results = calloc(configs_ct, sizeof(replicate_result_t));
+	char **names = calloc(configs_ct, sizeof(char *));
+	char *save;
+	int i = 0;
+
+	for (char *name = strtok_r(scheme_list, ",", &save); name != NULL; name = strtok_r(NULL, ",", &save))
+	{
+		if (simulator_parse_scheme(name, &configs[i].scheme, &configs[i].options) != 0)
+		{
+			fprintf(stderr, "Unknown scheme \"%s\". Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, edf, pedf, rr#, mlfq[:#,#,...[:#]], cfs[:#[:#]], stride[#], lottery[#[:#]]\n", name);
+			return 1;
+		}
+		configs[i].options.speeds = speeds;
+		names[i++] = name;
+	}
+	configs_ct = i;
+
+	if (configs_ct == 0 || replicate_run(&experiment, configs, configs_ct, results) != 0)
+	{
+		fprintf(stderr, "The replications failed. The workload parameters may be invalid: utilization and\n"
+		                "cores must be positive, the mean running time at least 1, the Pareto alpha above 1\n"
+		                "and MMPP fraction in (0, 1).\n");
+		return 2;
+	}
+
+
+	/*
+	 * Report every metric as its mean over the replications, give or take
+	 * the half-width of its 95% confidence interval.
+	 */
+	printf("Replicated %lld job(s) on %d core(s) at %.0f%% utilization, seeded from %llu...\n",
+			experiment.workload.jobs, experiment.cores, 100.0 * experiment.workload.utilization,
+			(unsigned long long)experiment.workload.seed);
+
+	for (i = 0; i < configs_ct; i++)
+	{
+		printf("\n%s: %d replication(s)", names[i], results[i].replications);
+		if (experiment.precision > 0)
+			printf(", %s within %.1f%% of the mean", results[i].converged ? "every interval" : "not every interval",
+					100.0 * experiment.precision);
+		printf("\n");
+
+		for (int m = 0; m < REPLICATE_METRICS; m++)
+		{
+			replicate_stat_t *stat = &results[i].metrics[m];
+
+			printf("  %-32s %10.2f +/- %.2f (%.2f to %.2f)\n", replicate_metric_name(m), stat->mean,
+					stat->half_width, stat->min, stat->max);
+		}
+	}
+
+	free(configs);
+	free(results);
+	free(names);
+	free(speeds);
+
+	return 0;
+}
@@ -0,0 +1,135 @@
+/** @file replicatetest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "libreplicate/libreplicate.h"
+
+
+/*
+ * Returns the average turnaround time of a scheme on the workload of one
+ * replication, generated and simulated on its own.
+ */
+double simulate(const char *name, const workload_config_t *config, int cores)
+{
+	scheme_t scheme;
+	scheduler_options_t options;
+	workload_t workload;
+	workload_job_t generated;
+
+	simulator_parse_scheme(name, &scheme, &options);
+	simulator_t *sim = simulator_create(cores, scheme, &options);
+	workload_init(&workload, config);
+	while (workload_next(&workload, &generated))
+	{
+		simulator_job_t job = { generated.arrival_time, generated.run_time, generated.priority, 0, 0, 1, NULL };
+		simulator_add_job(sim, &job);
+	}
+	simulator_run(sim);
+
+	double turnaround = scheduler_average_turnaround_time_r(simulator_scheduler(sim));
+	simulator_destroy(sim);
+	return turnaround;
+}
+
+int main()
+{
+	replicate_experiment_t experiment;
+	replicate_config_t configs[2];
+	replicate_result_t results[2], again[2];
+	replicate_stat_t stat;
+	int failures = 0;
+	int i;
+
+	/* The quantiles of Student's t, from the table and past it. */
+	double t10 = replicate_t_quantile(10), t40 = replicate_t_quantile(40), t1000 = replicate_t_quantile(1000);
+	printf("t quantiles for 10, 40 and 1000 degrees of freedom: %.4f %.4f %.4f (expected 2.2281 2.0211 1.9623).\n",
+			t10, t40, t1000);
+	if (fabs(t10 - 2.2281) > 0.0001 || fabs(t40 - 2.0211) > 0.0001 || fabs(t1000 - 1.9623) > 0.0001)
+		failures++;
+
+	/* A sample of 1 to 5 has a standard deviation of sqrt(2.5). */
+	double values[] = { 4, 2, 5, 1, 3 };
+	replicate_summarize(values, 5, &stat);
+	printf("Mean %.2f, half-width %.4f, range %.0f to %.0f (expected 3.00, 1.9632, 1 to 5).\n",
+			stat.mean, stat.half_width, stat.min, stat.max);
+	if (stat.mean != 3 || fabs(stat.half_width - 1.9632) > 0.0001 || stat.min != 1 || stat.max != 5)
+		failures++;
+	replicate_summarize(values, 1, &stat);
+	printf("Half-width of a single replication infinite: %s (expected yes).\n", isinf(stat.half_width) ? "yes" : "no");
+	if (!isinf(stat.half_width))
+		failures++;
+
+	/* Replication i is the workload seeded with the seed plus i, simulated on its own. */
+	replicate_experiment_init(&experiment);
+	experiment.workload.jobs = 400;
+	experiment.workload.cores = experiment.cores = 2;
+	experiment.workload.utilization = 0.8;
+	experiment.workload.seed = 7;
+	experiment.min_replications = experiment.max_replications = 1;
+	simulator_parse_scheme("rr4", &configs[0].scheme, &configs[0].options);
+	simulator_parse_scheme("psjf", &configs[1].scheme, &configs[1].options);
+
+	int status = replicate_run(&experiment, configs, 2, results);
+	double direct = simulate("psjf", &experiment.workload, 2);
+	printf("Replicated psjf: %.2f, simulated on its own: %.2f (expected the same).\n",
+			results[1].metrics[REPLICATE_MEAN_TURNAROUND].mean, direct);
+	if (status != 0 || fabs(results[1].metrics[REPLICATE_MEAN_TURNAROUND].mean - direct) > 0.01)
+		failures++;
+
+	/* With no precision, every replication runs; the threads do not change the outcome. */
+	experiment.min_replications = 5;
+	experiment.max_replications = 12;
+	experiment.batch = 3;
+	replicate_run(&experiment, configs, 2, results);
+	experiment.threads = 4;
+	replicate_run(&experiment, configs, 2, again);
+	int same = (memcmp(results, again, sizeof(results)) == 0);
+	printf("Replications run: %d %d, the same with 1 and 4 threads: %s (expected 12 12 yes).\n",
+			results[0].replications, results[1].replications, same ? "yes" : "no");
+	if (results[0].replications != 12 || results[1].replications != 12 || !same)
+		failures++;
+
+	/* PSJF never does worse than RR on average over the same workloads. */
+	printf("Average turnaround time of psjf below rr4: %s (expected yes).\n",
+			results[1].metrics[REPLICATE_MEAN_TURNAROUND].mean < results[0].metrics[REPLICATE_MEAN_TURNAROUND].mean
+			? "yes" : "no");
+	if (results[1].metrics[REPLICATE_MEAN_TURNAROUND].mean >= results[0].metrics[REPLICATE_MEAN_TURNAROUND].mean)
+		failures++;
+
+	/*
+	 * A loose precision stops early, with every interval within it, and a
+	 * tight one runs to the most replications.
+	 */
+	experiment.max_replications = 200;
+	experiment.precision = 0.1;
+	replicate_run(&experiment, configs, 2, results);
+	int within = 1;
+	for (i = 0; i < REPLICATE_METRICS; i++)
+		if (results[0].metrics[i].half_width > 0.1 * results[0].metrics[i].mean)
+			within = 0;
+	printf("Stopped early: %s, converged: %s, every interval within 10%%: %s (expected yes yes yes).\n",
+			results[0].replications < 200 ? "yes" : "no", results[0].converged ? "yes" : "no", within ? "yes" : "no");
+	if (results[0].replications >= 200 || !results[0].converged || !within)
+		failures++;
+
+	int loose = results[0].replications;
+	experiment.precision = 0.0001;
+	replicate_run(&experiment, configs, 1, results);
+	printf("Replications at 10%%: %d, at 0.01%%: %d of 200, converged: %s (expected fewer, 200, no).\n",
+			loose, results[0].replications, results[0].converged ? "yes" : "no");
+	if (results[0].replications != 200 || results[0].converged || loose >= 200)
+		failures++;
+
+	/* An invalid workload is refused. */
+	experiment.workload.utilization = 0;
+	printf("Zero utilization refused: %s (expected yes).\n", replicate_run(&experiment, configs, 1, results) != 0 ? "yes" : "no");
+	if (replicate_run(&experiment, configs, 1, results) == 0)
+		failures++;
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
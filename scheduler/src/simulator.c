@@ -5,488 +5,1075 @@
 
 #include <stdio.h>
 #include <stdlib.h>
-#include <unistd.h>
 #include <string.h>
-#include <assert.h>
+#include <strings.h>
+#include <unistd.h>
+#include <getopt.h>
 
 #include "libscheduler/libscheduler.h"
-
-
-typedef struct _simulator_job_list_t
-{
-	int job_id, arrival_time, run_time, priority;
-	int core_id, arrived;
-} simulator_job_list_t;
+#include "libsimulator/libsimulator.h"
+#include "libcluster/libcluster.h"
+#include "libtune/libtune.h"
+#include "libgang/libgang.h"
+
+/* Long options, which have no single-letter form */
+#define OPT_CHECKPOINT_EVERY 256
+#define OPT_CHECKPOINT       257
+#define OPT_RESUME           258
+#define OPT_SERIES_EVERY     259
+#define OPT_SERIES           260
+#define OPT_EVENTS           261
+#define OPT_BOUNDS           262
+#define OPT_TUNE             263
+#define OPT_TUNE_QUANTA      264
+#define OPT_GANG             265
+
+static const struct option long_options[] = {
+	{ "checkpoint-every", required_argument, NULL, OPT_CHECKPOINT_EVERY },
+	{ "checkpoint",       required_argument, NULL, OPT_CHECKPOINT },
+	{ "resume",           required_argument, NULL, OPT_RESUME },
+	{ "series-every",     required_argument, NULL, OPT_SERIES_EVERY },
+	{ "series",           required_argument, NULL, OPT_SERIES },
+	{ "events",           required_argument, NULL, OPT_EVENTS },
+	{ "bounds",           no_argument,       NULL, OPT_BOUNDS },
+	{ "tune",             required_argument, NULL, OPT_TUNE },
+	{ "tune-quanta",      required_argument, NULL, OPT_TUNE_QUANTA },
+	{ "gang",             required_argument, NULL, OPT_GANG },
+	{ NULL, 0, NULL, 0 }
+};
 
 void print_usage(char *program_name)
 {
-	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> <input file>\n", program_name);
+	fprintf(stderr, "Usage: %s -c <cores> -s <scheme> [-p] [-m <migration cost>] [-w <cache penalty>] [-a <window>] [-P <placement>] [-g <aging>] [-G <weights>] [-A <admission>] <input file>\n", program_name);
 	fprintf(stderr, "       %s -c 2 -s fcfs examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s -c 2:2.0,2:1.0 -s psjf -P short examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s -c 2 -s rr2 -A queue:4:defer examples/proc3.csv\n", program_name);
+	fprintf(stderr, "       %s -N <scheme>@<cores> [-N ...] [-D <dispatch>] [-j <threads>] [-W <window>] [options] <input file>\n", program_name);
+	fprintf(stderr, "       %s -N rr2@4 -N psjf@2 -D jsq examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s --resume <snapshot> [--checkpoint-every <time>] [input file]\n", program_name);
+	fprintf(stderr, "       %s -c 2 -s rr2 --checkpoint-every 1000 --checkpoint run.ckpt examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s --bounds -c <cores> [-s <scheme>] [options] <input file>\n", program_name);
+	fprintf(stderr, "       %s --tune <objective>[:<scheme>,...|:all] -c <cores> [--tune-quanta <lo>:<hi>] [-j <threads>] [options] <input file>\n", program_name);
+	fprintf(stderr, "       %s --tune p99-response:rr,stride,fcfs -c 4 -j 4 examples/proc1.csv\n", program_name);
+	fprintf(stderr, "       %s --gang <policy> -c <cores> <input file>\n", program_name);
+	fprintf(stderr, "       %s --gang easy -c 4 examples/proc7.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "  -p  give every core its own run queue; idle cores steal work\n");
+	fprintf(stderr, "  -m  time units a job loses each time it migrates (default 0)\n");
+	fprintf(stderr, "  -w  time units a job loses resuming on a core other than its last (default 0)\n");
+	fprintf(stderr, "  -a  waiting jobs a freed core looks through for one that last ran on it (default 0)\n");
+	fprintf(stderr, "  -P  idle core a new job goes to: lowest, fastest, short or priority (default lowest)\n");
+	fprintf(stderr, "  -g  pri and ppri: time units of waiting that raise a job's priority by one (default 0, none)\n");
+	fprintf(stderr, "  -G  share the cores between the groups of jobs by weight, as in 2,1 (groups not listed weigh 1)\n");
+	fprintf(stderr, "  -A  admit jobs while fewer than N wait (queue:N), while at most N time units of work are left\n");
+	fprintf(stderr, "      (backlog:N), or with a bucket of N tokens per priority gaining one every R time units\n");
+	fprintf(stderr, "      (tokens:N:R), rejecting the rest or, with :defer appended, deferring them (default all)\n");
+	fprintf(stderr, "  -N  add a node to a cluster, with its own scheme and cores; the options above apply to every node\n");
+	fprintf(stderr, "  -D  node an arriving job goes to: rr, least, jsq or p2[:seed] (default rr)\n");
+	fprintf(stderr, "  -j  threads the nodes, or the candidates of --tune, are simulated with (default 1)\n");
+	fprintf(stderr, "  -W  time units between the dispatcher's looks at the nodes (default 1)\n");
+	fprintf(stderr, "  --checkpoint-every  time units between snapshots of the whole simulation (default 0, none)\n");
+	fprintf(stderr, "  --checkpoint        file the snapshots are written to (default simulator.ckpt)\n");
+	fprintf(stderr, "  --resume            carry on from a snapshot; the jobs of an input file, arriving no earlier\n");
+	fprintf(stderr, "                      than the snapshot, are added to those it holds\n");
+	fprintf(stderr, "  --series-every      time units between rows of a time series of queue depth, utilization,\n");
+	fprintf(stderr, "                      completions and response times (default 0, none)\n");
+	fprintf(stderr, "  --series            CSV file the time series is written to (default series.csv)\n");
+	fprintf(stderr, "  --events            binary file every scheduling event is logged to in place of the trace,\n");
+	fprintf(stderr, "                      which eventlog2json converts for timeline viewers\n");
+	fprintf(stderr, "  --bounds            compare every scheme, or the one given, with lower bounds on the averages\n");
+	fprintf(stderr, "                      and the makespan that no scheme can beat on the workload\n");
+	fprintf(stderr, "  --tune              search for the quantum, and the scheme among those listed (default rr),\n");
+	fprintf(stderr, "                      minimizing mean-response, p99-response, mean-turnaround or p99-turnaround\n");
+	fprintf(stderr, "  --tune-quanta       range of quanta --tune searches (default 1 to the longest CPU burst)\n");
+	fprintf(stderr, "  --gang              run jobs needing several cores on all of them at once, to completion, in\n");
+	fprintf(stderr, "                      order of arrival (fcfs) or backfilling around a reservation (easy)\n");
 	fprintf(stderr, "\n");
-	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, rr#\n");
+	fprintf(stderr, "Cores are a number, or groups of cores by speed such as 4:2.0,4:1.0\n");
+	fprintf(stderr, "Running times may be CPU and I/O bursts in turn, such as 4;6;3 for 4 of CPU, 6 of I/O and 3 of CPU\n");
+	fprintf(stderr, "Jobs may need several cores at once, in a column after the group, which only --gang supports\n");
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Acceptable schemes are: fcfs, sjf, psjf, pri, ppri, edf, pedf, rr#, mlfq[:#,#,...[:#]], cfs[:#[:#]], stride[#], lottery[#[:#]]\n");
 }
 
-int set_active_job(int job_id, int core_id, simulator_job_list_t *jobs, int active_jobs)
+
+/*
+ * Runs the jobs on a cluster of the given nodes, each with the common
+ * options on top of its own scheme and cores, and prints the statistics of
+ * every node and of the cluster.
+ */
+static int run_cluster(char **node_specs, int nodes_ct, const scheduler_options_t *common, dispatch_t dispatch, unsigned int seed,
+		int threads, int window, simulator_job_t *jobs, int jobs_ct)
 {
-	int i;
-	for (i = 0; i < active_jobs; i++)
+	cluster_t *cluster = cluster_create(dispatch, seed);
+	int **node_speeds = calloc(nodes_ct, sizeof(int *));
+
+	for (int n = 0; n < nodes_ct; n++)
 	{
-		if (jobs[i].job_id == job_id && jobs[i].arrived)
+		scheme_t scheme;
+		scheduler_options_t options;
+		int cores;
+
+		cluster_parse_node(node_specs[n], &cores, &node_speeds[n], &scheme, &options);
+		options.per_core_queues = common->per_core_queues;
+		options.migration_cost = common->migration_cost;
+		options.cache_penalty = common->cache_penalty;
+		options.affinity = common->affinity;
+		options.speeds = node_speeds[n];
+		options.placement = common->placement;
+		options.aging = common->aging;
+		options.groups = common->groups;
+		options.group_weights = common->group_weights;
+		options.admission = common->admission;
+		options.admission_limit = common->admission_limit;
+		options.admission_rate = common->admission_rate;
+		options.admission_defer = common->admission_defer;
+
+		if (cluster_add_node(cluster, cores, scheme, &options) < 0)
 		{
-			jobs[i].core_id = core_id;
-			return 1;
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
 		}
 	}
 
-	return 0;
+	for (int i = 0; i < jobs_ct; i++)
+	{
+		if (cluster_add_job(cluster, &jobs[i]) < 0)
+		{
+			fprintf(stderr, "Out of memory.\n");
+			return 2;
+		}
+	}
+
+	printf("Loaded %d node(s) with %d job(s), dispatching by %s every %d time unit(s).\n\n", nodes_ct, jobs_ct, cluster_dispatch_name(dispatch), window);
+
+	int status = cluster_run(cluster, threads, window);
+
+	if (status == 0)
+		cluster_print_summary(cluster, stdout);
+	else
+		fprintf(stderr, (status == 2 ? "Out of memory.\n" : "A node's scheduler made an invalid decision.\n"));
+
+	cluster_destroy(cluster);
+	for (int n = 0; n < nodes_ct; n++)
+		free(node_speeds[n]);
+	free(node_speeds);
+
+	return status;
 }
 
-void print_available_jobs(simulator_job_list_t *jobs, int active_jobs)
+
+/*
+ * Prints a ratio to a bound, or a dash when the bound is 0.
+ */
+static void print_ratio(double value, double bound)
 {
-	printf("Active jobs are: ");
+	if (bound > 0)
+		printf("  %6.2f", value / bound);
+	else
+		printf("  %6s", "-");
+}
 
-	int i, first = 1;
-	for (i = 0; i < active_jobs; i++)
+
+/*
+ * Prints the lower bounds of the workload, then runs it under each of the
+ * schemes, with the common options on top of the scheme's own, and prints
+ * its averages and makespan next to their ratios to the bounds.
+ */
+static int run_bounds(const char **scheme_names, int schemes_ct, const scheduler_options_t *common, int cores,
+		simulator_job_t *jobs, int jobs_ct)
+{
+	simulator_bounds_t bounds;
+
+	if (simulator_bounds(jobs, jobs_ct, cores, common->speeds, &bounds) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	printf("Lower bounds for %d job(s) on %d core(s):\n", jobs_ct, cores);
+	printf("  Average Waiting Time: %.2f\n", bounds.waiting_time);
+	printf("  Average Turnaround Time: %.2f (SRPT on one core as fast as all of them: %.2f, each job alone: %.2f)\n",
+			bounds.turnaround_time, bounds.srpt_turnaround_time, bounds.alone_turnaround_time);
+	printf("  Makespan: %d (all the work on the cores: %d, arrival plus running time: %d)\n\n",
+			bounds.makespan, bounds.work_makespan, bounds.critical_makespan);
+
+	printf("Scheme         Waiting   Ratio  Turnaround   Ratio  Response  Makespan   Ratio\n");
+	for (int n = 0; n < schemes_ct; n++)
 	{
-		if (jobs[i].arrived)
+		scheme_t scheme;
+		scheduler_options_t options;
+
+		simulator_parse_scheme(scheme_names[n], &scheme, &options);
+		options.per_core_queues = common->per_core_queues;
+		options.migration_cost = common->migration_cost;
+		options.cache_penalty = common->cache_penalty;
+		options.affinity = common->affinity;
+		options.speeds = common->speeds;
+		options.placement = common->placement;
+		options.aging = common->aging;
+		options.groups = common->groups;
+		options.group_weights = common->group_weights;
+
+		simulator_t *sim = simulator_create(cores, scheme, &options);
+		for (int i = 0; i < jobs_ct; i++)
 		{
-			if (first)
+			if (simulator_add_job(sim, &jobs[i]) < 0)
 			{
-				printf("%d", jobs[i].job_id);
-				first = 0;
+				fprintf(stderr, "Out of memory.\n");
+				return 2;
 			}
-			else
-				printf(", %d", jobs[i].job_id);
 		}
-	}
 
-	if (!first)
+		if (simulator_run(sim) != 0)
+		{
+			fprintf(stderr, "The scheduler made an invalid decision under %s.\n", scheme_names[n]);
+			simulator_destroy(sim);
+			return 3;
+		}
+
+		scheduler_t *s = simulator_scheduler(sim);
+		float waiting = scheduler_average_waiting_time_r(s);
+		float turnaround = scheduler_average_turnaround_time_r(s);
+
+		printf("%-12s  %8.2f", scheme_names[n], waiting);
+		print_ratio(waiting, bounds.waiting_time);
+		printf("  %10.2f", turnaround);
+		print_ratio(turnaround, bounds.turnaround_time);
+		printf("  %8.2f  %8d", scheduler_average_response_time_r(s), simulator_time(sim));
+		print_ratio(simulator_time(sim), bounds.makespan);
 		printf("\n");
+
+		simulator_destroy(sim);
+	}
+
+	return 0;
 }
 
-void print_available_cores(int cores)
+
+/*
+ * Runs the jobs, each on as many cores as it needs at once, under a gang
+ * scheduling policy, printing when every job starts and finishes and then
+ * the statistics of the run.
+ */
+static int run_gang(gang_policy_t policy, int cores, simulator_job_t *jobs, int jobs_ct)
 {
-	printf("Active cores are: ");
+	gang_result_t result;
 
-	int i;
-	for (i = 0; i < cores; i++)
+	for (int i = 0; i < jobs_ct; i++)
 	{
-		if (i == cores - 1)
-			printf("%d\n", i);
-		else
-			printf("%d, ", i);
+		if (jobs[i].burst_ct > 1)
+		{
+			fprintf(stderr, "Job %d does I/O, which gang scheduling does not support.\n", i);
+			return 2;
+		}
+		if (jobs[i].cores > cores)
+		{
+			fprintf(stderr, "Job %d needs %d cores at once, more than the %d there are.\n", i, jobs[i].cores, cores);
+			return 2;
+		}
 	}
+
+	printf("Loaded %d core(s) and %d job(s) using gang scheduling with %s...\n\n", cores, jobs_ct,
+			(policy == GANG_EASY ? "EASY backfilling" : "First Come First Served (FCFS)"));
+
+	if (gang_simulate(jobs, jobs_ct, cores, policy, stdout, NULL, &result) != 0)
+	{
+		fprintf(stderr, "Out of memory.\n");
+		return 2;
+	}
+
+	printf("\nAverage Waiting Time: %.2f\n", result.average_waiting_time);
+	printf("Average Turnaround Time: %.2f\n", result.average_turnaround_time);
+	printf("Average Response Time: %.2f\n", result.average_waiting_time);
+	printf("Makespan: %d\n", result.makespan);
+	printf("Backfilled Jobs: %d\n", result.backfilled);
+	printf("Maximum Queue Length: %d\n", result.max_queue);
+	printf("Utilization: %.2f%%\n", 100 * result.utilization);
+	printf("Fragmentation: %.2f%%\n", 100 * result.fragmentation);
+
+	return 0;
 }
 
 
-int main(int argc, char **argv)
+/*
+ * Tells whether every job fits on one core, as only --gang runs jobs
+ * needing several at once.
+ */
+static int check_single_core(const simulator_job_t *jobs, int jobs_ct)
 {
-	int c;
-	int cores = 0, scheme = -1, quantum = 0;
-	char *file_name;
+	for (int i = 0; i < jobs_ct; i++)
+	{
+		if (jobs[i].cores > 1)
+		{
+			fprintf(stderr, "Job %d needs %d cores at once, which only --gang supports.\n", i, jobs[i].cores);
+			return 0;
+		}
+	}
+	return 1;
+}
 
-	/*
-	 * Parse command line options.
-	 */
-	while ((c = getopt(argc, argv, "c:s:")) != -1)
+
+/*
+ * Parses the argument of --tune: an objective, then optionally a colon and
+ * the schemes to search, by name without parameters, or all of them.
+ */
+static int parse_tune(const char *spec, tune_objective_t *objective, scheme_t *schemes, int *schemes_ct)
+{
+	char name[64];
+	const char *list = strchr(spec, ':');
+	size_t length = (list != NULL ? (size_t)(list - spec) : strlen(spec));
+
+	if (length >= sizeof(name))
+		return -1;
+	memcpy(name, spec, length);
+	name[length] = '\0';
+	if (tune_parse_objective(name, objective) != 0)
+		return -1;
+
+	*schemes_ct = 0;
+	if (list == NULL)
+		schemes[(*schemes_ct)++] = RR;
+	else if (strcasecmp(list + 1, "all") == 0)
+		for (scheme_t s = FCFS; s <= LOTTERY; s++)
+			schemes[(*schemes_ct)++] = s;
+	else
 	{
-		switch (c)
+		const char *p = list + 1;
+
+		while (*p != '\0')
 		{
-			case 'c':
-				cores = atoi(optarg);
+			scheme_t scheme;
+			scheduler_options_t options;
+
+			length = strcspn(p, ",");
+			if (length == 0 || length >= sizeof(name) || *schemes_ct > LOTTERY)
+				return -1;
+			memcpy(name, p, length);
+			name[length] = '\0';
+
+			if (strcasecmp(name, "rr") == 0)
+				scheme = RR;
+			else if (strpbrk(name, "0123456789:") != NULL || simulator_parse_scheme(name, &scheme, &options) != 0)
+				return -1;
+			schemes[(*schemes_ct)++] = scheme;
+
+			p += length;
+			if (*p == ',' && *++p == '\0')
+				return -1;
+		}
+	}
 
-				if (cores <= 0)
-				{
-					fprintf(stderr, "Option -c <cores> require a positive number.\n");
-					print_usage(argv[0]);
-					return 1;
-				}
-				break;
+	return 0;
+}
 
-			case 's':
-				if (strcasecmp(optarg, "FCFS") == 0) { scheme = FCFS; }
-				else if (strcasecmp(optarg, "SJF") == 0) { scheme = SJF; }
-				else if (strcasecmp(optarg, "PSJF") == 0) { scheme = PSJF; }
-				else if (strcasecmp(optarg, "PRI") == 0) { scheme = PRI; }
-				else if (strcasecmp(optarg, "PPRI") == 0) { scheme = PPRI; }
-				else if (strncasecmp(optarg, "RR", 2) == 0)
-				{
-					scheme = RR;
-					quantum = atoi(optarg + 2);
-
-					if (quantum <= 0)
-					{
-						fprintf(stderr, "Option -s <scheme> requires a positive number for the quantum of RR. (Eg: -s RR2)\n");
-						print_usage(argv[0]);
-						return 1;
-					}
-				}
-				break;
 
-			case '?':
-				print_usage(argv[0]);
-				return 1;
+/*
+ * Searches for the scheme and quantum that minimize the objective on the
+ * workload, with the common options on top of each scheme's own, and
+ * prints the best found for each scheme and overall.
+ */
+static int run_tune(tune_objective_t objective, const scheme_t *schemes, int schemes_ct, int min_quantum, int max_quantum,
+		int threads, const scheduler_options_t *common, int cores, simulator_job_t *jobs, int jobs_ct)
+{
+	tune_result_t results[schemes_ct];
+	char label[32];
+	int best = 0;
 
-			default:
-				printf("...\n");
-				break;
+	// By default, from 1 to the longest CPU burst, past which RR is FCFS.
+	if (max_quantum == 0)
+	{
+		max_quantum = 1;
+		for (int i = 0; i < jobs_ct; i++)
+		{
+			if (jobs[i].run_time > max_quantum)
+				max_quantum = jobs[i].run_time;
+			for (int b = 2; b < jobs[i].burst_ct; b += 2)
+				if (jobs[i].bursts[b] > max_quantum)
+					max_quantum = jobs[i].bursts[b];
 		}
+		if (max_quantum < min_quantum)
+			max_quantum = min_quantum;
 	}
 
-	if (cores == 0)
+	if (tune_search(jobs, jobs_ct, cores, common, schemes, schemes_ct, objective, min_quantum, max_quantum, threads, results) != 0)
 	{
-		fprintf(stderr, "Required option -c <cores> is not present.\n");
-		print_usage(argv[0]);
-		return 1;
+		fprintf(stderr, "Out of memory, or a scheduler made an invalid decision.\n");
+		return 3;
 	}
 
-	if (scheme == -1)
+	printf("Tuning %s for %d job(s) on %d core(s), quanta %d to %d, %d thread(s):\n\n",
+			tune_objective_name(objective), jobs_ct, cores, min_quantum, max_quantum, threads);
+	printf("Scheme        %15s  Evaluations  Stopped Early\n", tune_objective_name(objective));
+	for (int n = 0; n < schemes_ct; n++)
 	{
-		fprintf(stderr, "Required option -s <scheme> is not present.\n");
-		print_usage(argv[0]);
-		return 1;
+		char value[32];
+
+		// A run stopped early only shows that the scheme does worse than this.
+		snprintf(value, sizeof(value), "%s%.2f", (results[n].exact ? "" : ">"), results[n].value);
+		tune_scheme_label(&results[n], label, sizeof(label));
+		printf("%-12s  %15s  %11d  %13d\n", label, value, results[n].evaluations, results[n].stopped);
+
+		if (results[n].exact && (!results[best].exact || results[n].value < results[best].value))
+			best = n;
 	}
 
-	if (optind == argc - 1)
-		file_name = argv[optind];
-	else
+	tune_scheme_label(&results[best], label, sizeof(label));
+	printf("\nBest: %s (%s %.2f)\n", label, tune_objective_name(objective), results[best].value);
+	return 0;
+}
+
+
+/*
+ * Runs a simulation, either with the full trace or, when its events are
+ * logged, printing only the averages once it is done.
+ */
+static int run_simulation(simulator_t *sim, const char *events_path)
+{
+	if (events_path == NULL)
 	{
-		fprintf(stderr, "A single input file is required.\n");
-		print_usage(argv[0]);
-		return 1;
+		simulator_set_trace(sim, stdout, 1);
+		return simulator_run(sim);
 	}
 
-
-	/*
-	 * Open the file, read the file, and populate the jobs data structure.
-	 */
-	FILE *file = fopen(file_name, "r");
+	FILE *file = fopen(events_path, "wb");
 	if (file == NULL)
 	{
-		fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+		fprintf(stderr, "Unable to open file \"%s\".\n", events_path);
+		return 2;
+	}
+
+	eventlog_t *events = eventlog_open(file, simulator_cores(sim), 0);
+	if (events == NULL)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", events_path);
+		fclose(file);
 		return 2;
 	}
 
+	simulator_set_eventlog(sim, events);
+	int status = simulator_run(sim);
+	long long count = eventlog_count(events);
 
-	int job_id = 0;
-	int jobs_ct = 10;
-	simulator_job_list_t* jobs = malloc(jobs_ct * sizeof(simulator_job_list_t));
+	if (eventlog_close(events) != 0 || fclose(file) != 0)
+	{
+		fprintf(stderr, "Unable to write file \"%s\".\n", events_path);
+		return 2;
+	}
 
-	char line[1024 + 1];
-	fgets(line, 1024, file);  // Ignore the first (header) line
-	while (fgets(line, 1024, file) != NULL)
+	if (status == 0)
 	{
-		char *arrival_time = strtok(line, ",");
-		char *run_time = strtok(NULL, ",");
-		char *priority = strtok(NULL, ",");
+		printf("Logged %lld event(s) to \"%s\".\n\n", count, events_path);
+		simulator_print_summary(sim, stdout);
+	}
+	return status;
+}
 
-		if (arrival_time != NULL && run_time != NULL && priority != NULL)
-		{
-			if (job_id == jobs_ct)
-			{
-				jobs_ct *= 2;
-				jobs = realloc(jobs, jobs_ct * sizeof(simulator_job_list_t));
 
-				if (!jobs)
-				{
-					fprintf(stderr, "Out of memory.\n");
-					return 2;
-				}
-			}
+/*
+ * Carries on a simulation from a snapshot, with the jobs of the input file,
+ * if any, added to the ones it holds: a run forked from the snapshot to see
+ * how it would go with them.
+ */
+static int resume(const char *resume_path, const char *file_name, int checkpoint_every, const char *checkpoint_path, FILE *series, int series_every,
+		const char *events_path)
+{
+	FILE *file = fopen(resume_path, "rb");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", resume_path);
+		return 2;
+	}
+
+	simulator_t *sim = simulator_restore(file);
+	fclose(file);
+
+	if (sim == NULL)
+	{
+		fprintf(stderr, "\"%s\" is not a snapshot of a simulation.\n", resume_path);
+		return 2;
+	}
 
-			jobs[job_id].job_id = job_id;
-			jobs[job_id].arrival_time = atoi(arrival_time);
-			jobs[job_id].run_time = atoi(run_time);
-			jobs[job_id].priority = atoi(priority);
-			jobs[job_id].core_id = -1;
-			jobs[job_id].arrived = 0;
+	if (file_name != NULL)
+	{
+		int jobs_ct;
+
+		file = fopen(file_name, "r");
+		if (file == NULL)
+		{
+			fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+			simulator_destroy(sim);
+			return 2;
+		}
+		simulator_job_t *jobs = simulator_read_jobs(file, &jobs_ct);
+		fclose(file);
 
-			job_id++;
+		if (jobs == NULL)
+		{
+			fprintf(stderr, (jobs_ct == -1 ? "Illegal file format.\n" : "Out of memory.\n"));
+			simulator_destroy(sim);
+			return 2;
 		}
-		else
+		if (!check_single_core(jobs, jobs_ct))
 		{
-			fprintf(stderr, "Illegal file format.\n");
+			simulator_free_jobs(jobs, jobs_ct);
+			simulator_destroy(sim);
 			return 2;
 		}
+
+		for (int i = 0; i < jobs_ct; i++)
+		{
+			if (jobs[i].arrival_time < simulator_time(sim))
+			{
+				fprintf(stderr, "Job %d arrives at time %d, before the snapshot was taken at time %d.\n", i, jobs[i].arrival_time, simulator_time(sim));
+				simulator_free_jobs(jobs, jobs_ct);
+				simulator_destroy(sim);
+				return 2;
+			}
+			if (simulator_add_job(sim, &jobs[i]) < 0)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				return 2;
+			}
+		}
+		simulator_free_jobs(jobs, jobs_ct);
 	}
 
-	fclose(file);
+	simulator_set_checkpoint(sim, checkpoint_every, checkpoint_path);
+	simulator_set_series(sim, series, series_every);
+
+	int status = run_simulation(sim, events_path);
+	simulator_destroy(sim);
+	return status;
+}
+
 
+int main(int argc, char **argv)
+{
+	int c;
+	int cores = 0, scheme = -1, parsed;
+	int per_core_queues = 0, migration_cost = 0, cache_penalty = 0, affinity = 0, aging = 0;
+	int *speeds = NULL;
+	int weights_ct = 0, *weights = NULL;
+	placement_t placement = PLACE_LOWEST;
+	char **node_specs = malloc(argc * sizeof(char *));
+	int nodes_ct = 0, threads = 1, window = 1;
+	dispatch_t dispatch = DISPATCH_RR;
+	unsigned int seed = 1;
+	int cluster_only = 0, threads_set = 0;
+	scheme_t parsed_scheme;
+	scheduler_options_t options, admission;
+	char *file_name;
+	int checkpoint_every = 0;
+	const char *checkpoint_path = "simulator.ckpt";
+	const char *resume_path = NULL;
+	int series_every = 0;
+	const char *series_path = "series.csv";
+	FILE *series = NULL;
+	const char *events_path = NULL;
+	int bounds = 0;
+	const char *scheme_name = NULL;
+	int tune = 0, min_quantum = 1, max_quantum = 0, tune_schemes_ct = 0;
+	tune_objective_t objective = TUNE_MEAN_RESPONSE;
+	scheme_t tune_schemes[LOTTERY + 1];
+	int gang = 0;
+	gang_policy_t gang_policy = GANG_FCFS;
+	const char *all_schemes[] = { "fcfs", "sjf", "psjf", "pri", "ppri", "edf", "pedf", "rr1", "rr2", "rr4", "rr8", "mlfq", "cfs", "stride", "lottery" };
+
+	// -s fills these in for its scheme; a cluster only takes the common ones.
+	scheduler_options_init(&options);
+	scheduler_options_init(&admission);
 
 	/*
-	 * Run the simulation.
+	 * Parse command line options.
 	 */
+	while ((c = getopt_long(argc, argv, "c:s:pm:w:a:P:g:G:A:N:D:j:W:", long_options, NULL)) != -1)
+	{
+		switch (c)
+		{
+			case 'c':
+				free(speeds);
 
-	printf("Loaded %d core(s) and %d job(s) using ", cores, job_id);
-	if (scheme == FCFS) { printf("First Come First Served (FCFS)"); }
-	else if (scheme == SJF) { printf("Non-preemptive Shortest Job First (SJF)"); }
-	else if (scheme == PSJF) { printf("Preemptive Shortest Job First (PSJF)"); }
-	else if (scheme == PRI) { printf("Non-preemptive Priority (PRI)"); }
-	else if (scheme == PPRI) { printf("Preemptive Priority (PPRI)"); }
-	else if (scheme == RR) { printf("Round Robin (RR) with a quantum of %d", quantum); }
-	printf(" scheduling...\n\n");
+				if (simulator_parse_cores(optarg, &cores, &speeds) != 0)
+				{
+					fprintf(stderr, "Option -c <cores> require a positive number, or groups of cores with positive speeds. (Eg: -c 4:2.0,4:1.0)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
 
-	scheduler_start_up(cores, scheme);
+			case 's':
+				parsed = simulator_parse_scheme(optarg, &parsed_scheme, &options);
 
+				if (parsed == -1 && parsed_scheme == RR)
+				{
+					fprintf(stderr, "Option -s <scheme> requires a positive number for the quantum of RR. (Eg: -s RR2)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				else if (parsed == -1 && (parsed_scheme == STRIDE || parsed_scheme == LOTTERY))
+				{
+					fprintf(stderr, "Option -s <scheme> requires a positive quantum for STRIDE and LOTTERY, and a seed for LOTTERY. (Eg: -s LOTTERY2:7)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				else if (parsed == -1 && parsed_scheme == CFS)
+				{
+					fprintf(stderr, "Option -s <scheme> requires a positive target latency no smaller than the minimum granularity for CFS. (Eg: -s CFS:24:3)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				else if (parsed == -1)
+				{
+					fprintf(stderr, "Option -s <scheme> requires positive quanta and boost period for MLFQ. (Eg: -s MLFQ:2,4,8:100)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				else if (parsed == 0)
+				{
+					scheme = parsed_scheme;
+					scheme_name = optarg;
+				}
+				break;
 
-	int time = 0, i, j;
-	int active_jobs = job_id, jobs_alive = 0;
+			case 'p':
+				per_core_queues = 1;
+				break;
 
-	int *quantum_clock = malloc(cores * sizeof(int));
-	char **core_timing_diagram = malloc(cores * sizeof(char *));
-	int core_timing_diagram_size = 1024;
+			case 'm':
+				migration_cost = atoi(optarg);
 
-	for (i = 0; i < cores; i++)
-	{
-		quantum_clock[i] = -1;
-		core_timing_diagram[i] = malloc(core_timing_diagram_size + 1);
-		core_timing_diagram[i][0] = '\0';
-	}
+				if (migration_cost < 0)
+				{
+					fprintf(stderr, "Option -m <migration cost> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
 
-	while (active_jobs > 0)
-	{
-		printf("=== [TIME %d] ===\n", time);
+			case 'w':
+				cache_penalty = atoi(optarg);
 
-		/*
-		 * 1. Check if any jobs finished in the last time unit.
-		 */
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].run_time == 0)
-			{
-				// Notify the scheduler has finished
-				int job_id = jobs[i].job_id;
-				int core_id = jobs[i].core_id;
-				int new_job_id = scheduler_job_finished(jobs[i].core_id, jobs[i].job_id, time);
-
-				if (scheme == RR)
-					quantum_clock[jobs[i].core_id] = quantum;
-
-				// Delete the finished jobs, decrease the number of active jobs
-				if (i != active_jobs - 1)
-					memcpy(&jobs[i], &jobs[active_jobs - 1], sizeof(simulator_job_list_t));
-				active_jobs--;
-				jobs_alive--;
-				i--;
-
-				// Set the new job
-				if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
+				if (cache_penalty < 0)
 				{
-					printf("The scheduler_job_finished() selected an invalid job (job_id == %d).\n", new_job_id);
-					print_available_jobs(jobs, active_jobs);
-					return 3;
+					fprintf(stderr, "Option -w <cache penalty> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-				else
+				break;
+
+			case 'a':
+				affinity = atoi(optarg);
+
+				if (affinity < 0)
 				{
-					printf("Job %d, running on core %d, finished. Core %d is now running job %d.\n", job_id, core_id, core_id, new_job_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+					fprintf(stderr, "Option -a <window> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-			}
-		}
+				break;
 
-		/*
-		 * Check to see if we finished our last job.  (If we don't check here, we would run an extra time unit that will be totally idle.)
-		 */
-		if (active_jobs == 0)
-			break;
+			case 'g':
+				aging = atoi(optarg);
 
-		/*
-		 * 2. Check of any quantums expired in the last time unit.
-		 */
-		if (scheme == RR)
-		{
-			for (i = 0; i < cores; i++)
-			{
-				if (quantum_clock[i] == 0)
+				if (aging < 0)
 				{
-					for (j = 0; j < active_jobs; j++)
-					{
-						if (jobs[j].core_id == i)
-						{
-							// Notify the scheduler the quantum has expired
-							int core_id = jobs[j].core_id;
-							int old_job_id = jobs[j].job_id;
-							int new_job_id = scheduler_quantum_expired(jobs[j].core_id, time);
-
-							jobs[j].core_id = -1;
-
-							quantum_clock[core_id] = quantum;
-
-							// Set the new job
-							if ( new_job_id != -1 && !set_active_job(new_job_id, core_id, jobs, active_jobs) )
-							{
-								printf("The scheduler_quantum_expired() selected an invalid job (job_id == %d).\n", new_job_id);
-								print_available_jobs(jobs, active_jobs);
-								return 3;
-							}
-							else
-							{
-								printf("Job %d, running on core %d, had its quantum expire. Core %d is now running job %d.\n", old_job_id, core_id, core_id, new_job_id);
-								printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
-							}
-
-							break;
-						}
-					}
+					fprintf(stderr, "Option -g <aging> requires a non-negative number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-			}
-		}
+				break;
 
+			case 'G':
+				free(weights);
 
-		/*
-		 * 3. Check for any new jobs that arrive in this time unit
-		 */
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].arrival_time == time)
+				if (simulator_parse_weights(optarg, &weights_ct, &weights) != 0)
+				{
+					fprintf(stderr, "Option -G <weights> requires a list of positive numbers. (Eg: -G 2,1)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'A':
+				if (simulator_parse_admission(optarg, &admission) != 0)
+				{
+					fprintf(stderr, "Option -A <admission> requires queue:N, backlog:N or tokens:N:R, optionally followed by :defer.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'N':
 			{
-				int new_job_core_id = scheduler_new_job(jobs[i].job_id, time, jobs[i].run_time, jobs[i].priority);
-				jobs[i].arrived = 1;
-				jobs_alive++;
+				int node_cores, *node_speeds = NULL;
+				scheduler_options_t node_options;
 
-				if (new_job_core_id >= 0 && new_job_core_id < cores)
+				if (cluster_parse_node(optarg, &node_cores, &node_speeds, &parsed_scheme, &node_options) != 0)
 				{
-					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is now running on core %d.\n",
-							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id, new_job_core_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+					fprintf(stderr, "Option -N <scheme>@<cores> requires a valid scheme and cores. (Eg: -N rr2@4)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				free(node_speeds);
+				node_specs[nodes_ct++] = optarg;
+				break;
+			}
 
-					// Find if anyone is currently using the core.
-					for (j = 0; j < active_jobs; j++)
-						if (jobs[j].core_id == new_job_core_id)
-							jobs[j].core_id = -1;
+			case 'D':
+				if (cluster_parse_dispatch(optarg, &dispatch, &seed) != 0)
+				{
+					fprintf(stderr, "Option -D <dispatch> requires one of rr, least, jsq or p2[:seed].\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				cluster_only = 1;
+				break;
 
-					// Assign the core to the new job
-					jobs[i].core_id = new_job_core_id;
+			case 'j':
+				threads = atoi(optarg);
 
-					if (scheme == RR)
-						quantum_clock[new_job_core_id] = quantum;
+				if (threads <= 0)
+				{
+					fprintf(stderr, "Option -j <threads> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-				else if (new_job_core_id == -1)
+				threads_set = 1;
+				break;
+
+			case 'W':
+				window = atoi(optarg);
+
+				if (window <= 0)
 				{
-					printf("A new job, job %d (running time=%d, priority=%d), arrived. Job %d is set to idle (-1).\n",
-							jobs[i].job_id, jobs[i].run_time, jobs[i].priority, jobs[i].job_id);
-					printf("  Queue: "); scheduler_show_queue(); printf("\n\n");
+					fprintf(stderr, "Option -W <window> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
+				cluster_only = 1;
+				break;
+
+			case 'P':
+				if (strcasecmp(optarg, "lowest") == 0)
+					placement = PLACE_LOWEST;
+				else if (strcasecmp(optarg, "fastest") == 0)
+					placement = PLACE_FASTEST;
+				else if (strcasecmp(optarg, "short") == 0)
+					placement = PLACE_SHORT;
+				else if (strcasecmp(optarg, "priority") == 0)
+					placement = PLACE_PRIORITY;
 				else
 				{
-					printf("The scheduler_new_job() selected an invalid core (core_id == %d).\n", new_job_core_id);
-					print_available_cores(cores);
-					return 3;
+					fprintf(stderr, "Option -P <placement> requires one of lowest, fastest, short or priority.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case OPT_CHECKPOINT_EVERY:
+				checkpoint_every = atoi(optarg);
+
+				if (checkpoint_every <= 0)
+				{
+					fprintf(stderr, "Option --checkpoint-every <time> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-			}
-		}
+				break;
 
+			case OPT_CHECKPOINT:
+				checkpoint_path = optarg;
+				break;
 
-		/*
-		 * 4. Run the time unit.
-		 */
-		char time_string[cores][11];
-		int cores_working = 0;
+			case OPT_RESUME:
+				resume_path = optarg;
+				break;
 
-		for (i = 0; i < cores; i++)
-			time_string[i][0] = '\0';
+			case OPT_SERIES_EVERY:
+				series_every = atoi(optarg);
 
-		for (i = 0; i < active_jobs; i++)
-		{
-			if (jobs[i].core_id != -1)
-			{
-				cores_working++;
-				jobs[i].run_time--;
-				quantum_clock[jobs[i].core_id]--;
-
-				assert(time_string[jobs[i].core_id][0] == '\0');
-
-				if (jobs[i].job_id < 10)
-					sprintf(time_string[jobs[i].core_id], "%d", jobs[i].job_id);
-				else if (jobs[i].job_id < 10 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 + 'a');
-				else if (jobs[i].job_id < 10 + 26 + 26)
-					sprintf(time_string[jobs[i].core_id], "%c", jobs[i].job_id - 10 - 26 + 'A');
-				else
-					snprintf(time_string[jobs[i].core_id], 10, "(%d)", jobs[i].job_id);
-			}
-		}
+				if (series_every <= 0)
+				{
+					fprintf(stderr, "Option --series-every <time> require a positive number.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
 
-		for (i = 0; i < cores; i++)
-		{
-			// If the core is idle, print a '-'
-			if (time_string[i][0] == '\0')
-				strcpy(time_string[i], "-");
+			case OPT_SERIES:
+				series_path = optarg;
+				break;
 
-			// Ensure we have enough memory
-			while (strlen(core_timing_diagram[i]) + strlen(time_string[i]) >= (unsigned int)core_timing_diagram_size)
-			{
-				core_timing_diagram_size *= 2;
+			case OPT_EVENTS:
+				events_path = optarg;
+				break;
+
+			case OPT_BOUNDS:
+				bounds = 1;
+				break;
 
-				for (j = 0; j < cores; j++)
+			case OPT_TUNE:
+				if (parse_tune(optarg, &objective, tune_schemes, &tune_schemes_ct) != 0)
 				{
-					core_timing_diagram[j] = realloc(core_timing_diagram[j], core_timing_diagram_size + 1);
+					fprintf(stderr, "Option --tune requires an objective, mean-response, p99-response, mean-turnaround or p99-turnaround,\n");
+					fprintf(stderr, "optionally followed by a colon and the schemes to search, such as rr,stride,fcfs, or all.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				tune = 1;
+				break;
 
-					if (core_timing_diagram[j] == NULL)
-					{
-						fprintf(stderr, "Out of memory.\n");
-						return 3;
-					}
+			case OPT_TUNE_QUANTA:
+				if (sscanf(optarg, "%d:%d", &min_quantum, &max_quantum) != 2 || min_quantum <= 0 || max_quantum < min_quantum)
+				{
+					fprintf(stderr, "Option --tune-quanta requires a range of positive quanta, such as 1:50.\n");
+					print_usage(argv[0]);
+					return 1;
 				}
-			}
+				break;
+
+			case OPT_GANG:
+				if (gang_parse_policy(optarg, &gang_policy) != 0)
+				{
+					fprintf(stderr, "Option --gang requires a policy, fcfs or easy.\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				gang = 1;
+				break;
 
-			strcat( core_timing_diagram[i], time_string[i] );
+			case '?':
+				print_usage(argv[0]);
+				return 1;
+
+			default:
+				printf("...\n");
+				break;
 		}
+	}
+
+	if (nodes_ct > 0 && (cores != 0 || scheme != -1))
+	{
+		fprintf(stderr, "Options -c <cores> and -s <scheme> cannot be combined with -N, which gives every node its own.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
+	if (resume_path != NULL && (cores != 0 || scheme != -1 || nodes_ct > 0 || admission.admission != ADMIT_ALL))
+	{
+		fprintf(stderr, "Options -c <cores>, -s <scheme>, -N and -A cannot be combined with --resume, which takes them from the snapshot.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
-		/*
-		 * 5. Print data!
-		 */
-		printf("At the end of time unit %d...\n", time);
+	if (nodes_ct > 0 && (checkpoint_every > 0 || series_every > 0 || events_path != NULL))
+	{
+		fprintf(stderr, "Options --checkpoint-every, --series-every and --events cannot be combined with -N.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
-		for (i = 0; i < cores; i++)
-			printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
+	if (bounds && (nodes_ct > 0 || resume_path != NULL || checkpoint_every > 0 || series_every > 0 || events_path != NULL || admission.admission != ADMIT_ALL))
+	{
+		fprintf(stderr, "Option --bounds cannot be combined with -N, --resume, --checkpoint-every, --series-every, --events or -A.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
-		printf("\n");
+	if (tune && (nodes_ct > 0 || scheme != -1 || resume_path != NULL || checkpoint_every > 0 || series_every > 0 || events_path != NULL || bounds
+			|| admission.admission != ADMIT_ALL))
+	{
+		fprintf(stderr, "Option --tune cannot be combined with -s, -N, --resume, --checkpoint-every, --series-every, --events, --bounds or -A.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
-		printf("  Queue: ");
-		scheduler_show_queue();
-		printf("\n");
-		printf("\n");
+	if (gang && (nodes_ct > 0 || scheme != -1 || resume_path != NULL || checkpoint_every > 0 || series_every > 0 || events_path != NULL || bounds
+			|| tune || admission.admission != ADMIT_ALL || per_core_queues || migration_cost > 0 || cache_penalty > 0 || affinity > 0
+			|| placement != PLACE_LOWEST || aging > 0 || weights != NULL))
+	{
+		fprintf(stderr, "Option --gang cannot be combined with -s, -N, --resume, --checkpoint-every, --series-every, --events, --bounds,\n");
+		fprintf(stderr, "--tune or the options of the per-core schedulers, -p, -m, -w, -a, -P, -g, -G and -A.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (gang && speeds != NULL)
+	{
+		fprintf(stderr, "Option --gang requires cores of a single speed.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
+	if (max_quantum > 0 && !tune)
+	{
+		fprintf(stderr, "Option --tune-quanta requires --tune.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
 
-		/*
-		 * 6. Sanity Checking
-		 *
-		 * - If there's a job alive (needing to be ran) and all CPUs are idle, the scheduler failed to schedule properly.
-		 */
-		if (jobs_alive > 0 && cores_working == 0)
-		{
-			printf("All cores are idle and at least one job remains unscheduled.\n");
-			print_available_jobs(jobs, active_jobs);
-			return 3;
-		}
+	if (series_every > 0 && (series = fopen(series_path, "w")) == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", series_path);
+		return 2;
+	}
+
+	if (resume_path != NULL && optind < argc - 1)
+	{
+		fprintf(stderr, "At most one input file may follow --resume.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (resume_path != NULL)
+	{
+		int status = resume(resume_path, (optind == argc - 1 ? argv[optind] : NULL), checkpoint_every, checkpoint_path, series, series_every, events_path);
+
+		if (series != NULL)
+			fclose(series);
+		free(node_specs);
+		free(weights);
+		return status;
+	}
+
+	if (nodes_ct == 0 && (cluster_only || (threads_set && !tune)))
+	{
+		fprintf(stderr, "Options -D, -j and -W require at least one -N <scheme>@<cores>, save -j with --tune.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (cores == 0 && nodes_ct == 0)
+	{
+		fprintf(stderr, "Required option -c <cores> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (scheme == -1 && nodes_ct == 0 && !bounds && !tune && !gang)
+	{
+		fprintf(stderr, "Required option -s <scheme> is not present.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (optind == argc - 1)
+		file_name = argv[optind];
+	else
+	{
+		fprintf(stderr, "A single input file is required.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+
+	/*
+	 * Open the file, read the file, and populate the jobs data structure.
+	 */
+	FILE *file = fopen(file_name, "r");
+	if (file == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", file_name);
+		return 2;
+	}
+
+
+	int i, jobs_ct;
+	simulator_job_t *jobs = simulator_read_jobs(file, &jobs_ct);
+
+	fclose(file);
+
+	if (jobs == NULL)
+	{
+		fprintf(stderr, (jobs_ct == -1 ? "Illegal file format.\n" : "Out of memory.\n"));
+		return 2;
+	}
 
+	if (gang)
+	{
+		int status = run_gang(gang_policy, cores, jobs, jobs_ct);
 
-		/*
-		 * 7. Increase time
-		 */
-		time++;
+		free(node_specs);
+		simulator_free_jobs(jobs, jobs_ct);
+		return status;
+	}
+
+	if (!check_single_core(jobs, jobs_ct))
+	{
+		free(node_specs);
+		free(speeds);
+		free(weights);
+		simulator_free_jobs(jobs, jobs_ct);
+		return 2;
 	}
 
 
-	printf("FINAL TIMING DIAGRAM:\n");
-	for (i = 0; i < cores; i++)
-		printf("  Core %2d: %s\n", i, core_timing_diagram[i]);
+	/*
+	 * Run the simulation.
+	 */
+	options.per_core_queues = per_core_queues;
+	options.migration_cost = migration_cost;
+	options.cache_penalty = cache_penalty;
+	options.affinity = affinity;
+	options.speeds = speeds;
+	options.placement = placement;
+	options.aging = aging;
+	options.admission = admission.admission;
+	options.admission_limit = admission.admission_limit;
+	options.admission_rate = admission.admission_rate;
+	options.admission_defer = admission.admission_defer;
+
+	// Every group of the workload gets a queue, weighing 1 unless listed.
+	int *group_weights = NULL;
+	if (weights != NULL)
+	{
+		options.groups = simulator_count_groups(jobs, jobs_ct);
+		if (options.groups < weights_ct)
+			options.groups = weights_ct;
+
+		group_weights = malloc(options.groups * sizeof(int));
+		for (i = 0; i < options.groups; i++)
+			group_weights[i] = (i < weights_ct ? weights[i] : 1);
+		options.group_weights = group_weights;
+	}
+
+	int status;
 
-	printf("\n");
-	printf("Average Waiting Time: %.2f\n", scheduler_average_waiting_time());
-	printf("Average Turnaround Time: %.2f\n", scheduler_average_turnaround_time());
-	printf("Average Response Time: %.2f\n", scheduler_average_response_time());
+	if (nodes_ct > 0)
+		status = run_cluster(node_specs, nodes_ct, &options, dispatch, seed, threads, window, jobs, jobs_ct);
+	else if (bounds && scheme_name != NULL)
+		status = run_bounds(&scheme_name, 1, &options, cores, jobs, jobs_ct);
+	else if (bounds)
+		status = run_bounds(all_schemes, sizeof(all_schemes) / sizeof(all_schemes[0]), &options, cores, jobs, jobs_ct);
+	else if (tune)
+		status = run_tune(objective, tune_schemes, tune_schemes_ct, min_quantum, max_quantum, threads, &options, cores, jobs, jobs_ct);
+	else
+	{
+		simulator_t *sim = simulator_create(cores, scheme, &options);
+		simulator_set_checkpoint(sim, checkpoint_every, checkpoint_path);
+		simulator_set_series(sim, series, series_every);
 
-	scheduler_clean_up();
+		for (i = 0; i < jobs_ct; i++)
+		{
+			if (simulator_add_job(sim, &jobs[i]) < 0)
+			{
+				fprintf(stderr, "Out of memory.\n");
+				return 2;
+			}
+		}
 
+		status = run_simulation(sim, events_path);
+		simulator_destroy(sim);
+	}
 
-	free(quantum_clock);
-	for (i=0; i < cores; i++)
-		free(core_timing_diagram[i]);
-	free(core_timing_diagram);
-	free(jobs);
+	if (series != NULL)
+		fclose(series);
+	free(node_specs);
+	free(speeds);
+	free(weights);
+	free(group_weights);
+	simulator_free_jobs(jobs, jobs_ct);
 
-	return 0;
+	return status;
 }
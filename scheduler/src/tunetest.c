@@ -0,0 +1,117 @@
+/** @file tunetest.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "libtune/libtune.h"
+
+#define JOBS 300
+
+
+/*
+ * Returns the average turnaround time of the jobs under a scheme, simulated
+ * on its own.
+ */
+double simulate(const char *name, simulator_job_t *jobs, int cores)
+{
+	scheme_t scheme;
+	scheduler_options_t options;
+
+	simulator_parse_scheme(name, &scheme, &options);
+	simulator_t *sim = simulator_create(cores, scheme, &options);
+	for (int i = 0; i < JOBS; i++)
+		simulator_add_job(sim, &jobs[i]);
+	simulator_run(sim);
+
+	double turnaround = scheduler_average_turnaround_time_r(simulator_scheduler(sim));
+	simulator_destroy(sim);
+	return turnaround;
+}
+
+int main()
+{
+	simulator_job_t *jobs = calloc(JOBS, sizeof(simulator_job_t));
+	scheduler_options_t common;
+	tune_objective_t objective;
+	tune_result_t results[LOTTERY + 1], again[LOTTERY + 1];
+	char label[32];
+	int failures = 0;
+	int i;
+
+	/* Objectives are parsed by name. */
+	int parsed = (tune_parse_objective("p99-turnaround", &objective) == 0 && objective == TUNE_P99_TURNAROUND);
+	printf("Objective p99-turnaround parsed: %s, median-response rejected: %s (expected yes yes).\n",
+			parsed ? "yes" : "no", tune_parse_objective("median-response", &objective) != 0 ? "yes" : "no");
+	if (!parsed || tune_parse_objective("median-response", &objective) == 0)
+		failures++;
+
+	/*
+	 * Populate some jobs, mostly short with a few long ones, so that the
+	 * quantum matters... No two arrive together.
+	 */
+	srand(241);
+	for (i = 0; i < JOBS; i++)
+	{
+		jobs[i].arrival_time = (i > 0 ? jobs[i - 1].arrival_time : 0) + 1 + rand() % 8;
+		jobs[i].run_time = (i % 7 == 0 ? 10 + rand() % 20 : 1 + rand() % 6);
+		jobs[i].priority = rand() % 5;
+		jobs[i].burst_ct = 1;
+	}
+	scheduler_options_init(&common);
+
+	/* The quantum found is as good as it says, and no worse than any point of the grid. */
+	scheme_t rr = RR;
+	int status = tune_search(jobs, JOBS, 2, &common, &rr, 1, TUNE_MEAN_TURNAROUND, 1, 40, 1, results);
+	tune_scheme_label(&results[0], label, sizeof(label));
+	double direct = simulate(label, jobs, 2);
+	printf("Tuned %s: %.2f, simulated on its own: %.2f (expected the same).\n", label, results[0].value, direct);
+	if (status != 0 || !results[0].exact || fabs(results[0].value - direct) > 0.01)
+		failures++;
+
+	int beaten = 0;
+	for (int q = 1; q <= 40; q = (q * 2 > 40 && q < 40 ? 40 : q * 2))
+	{
+		char name[16];
+
+		snprintf(name, sizeof(name), "rr%d", q);
+		if (simulate(name, jobs, 2) < results[0].value - 0.01)
+			beaten++;
+	}
+	printf("Points of the grid better than %s: %d (expected 0).\n", label, beaten);
+	if (beaten != 0)
+		failures++;
+
+	/* The threads do not change the outcome. */
+	scheme_t schemes[] = { RR, STRIDE, FCFS, PSJF };
+	tune_search(jobs, JOBS, 2, &common, schemes, 4, TUNE_P99_TURNAROUND, 1, 40, 1, results);
+	tune_search(jobs, JOBS, 2, &common, schemes, 4, TUNE_P99_TURNAROUND, 1, 40, 4, again);
+	int same = 1, stopped = 0;
+	for (i = 0; i < 4; i++)
+	{
+		if (tune_has_quantum(schemes[i]) &&
+				(results[i].quantum != again[i].quantum || results[i].value != again[i].value))
+			same = 0;
+		stopped += results[i].stopped;
+	}
+	printf("Quanta found with 1 and 4 threads the same: %s (expected yes).\n", same ? "yes" : "no");
+	if (!same)
+		failures++;
+
+	/* Runs sure to lose are stopped early, but never the best one. */
+	int best = 0;
+	for (i = 1; i < 4; i++)
+		if (results[i].exact && results[i].value < results[best].value)
+			best = i;
+	printf("Runs stopped early: %s, best run exact: %s (expected yes yes).\n",
+			stopped > 0 ? "yes" : "no", results[best].exact ? "yes" : "no");
+	if (stopped == 0 || !results[best].exact)
+		failures++;
+
+	free(jobs);
+
+	printf("\n%s\n", failures == 0 ? "All tests passed." : "Some tests FAILED.");
+	return failures != 0;
+}
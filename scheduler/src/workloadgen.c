@@ -0,0 +1,189 @@
+/** @file workloadgen.c
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <string.h>
+
+#include "libworkload/libworkload.h"
+
+#define OUTPUT_BUFFER_SIZE (1 << 20)
+
+
+void print_usage(char *program_name)
+{
+	fprintf(stderr, "Usage: %s -n <jobs> [options]\n", program_name);
+	fprintf(stderr, "       %s -n 1000 -c 2 -u 0.9 -a mmpp -r pareto:1.5 > trace.csv\n", program_name);
+	fprintf(stderr, "\n");
+	fprintf(stderr, "Options:\n");
+	fprintf(stderr, "  -n <jobs>        number of jobs to generate\n");
+	fprintf(stderr, "  -s <seed>        random seed (default 1)\n");
+	fprintf(stderr, "  -c <cores>       cores the utilization is relative to (default 1)\n");
+	fprintf(stderr, "  -u <util>        target utilization of the cores (default 0.7)\n");
+	fprintf(stderr, "  -m <mean>        mean running time (default 10)\n");
+	fprintf(stderr, "  -M <max>         cap on the running time (default none)\n");
+	fprintf(stderr, "  -a <arrivals>    poisson, or mmpp[:factor[:fraction[:length]]] (default poisson)\n");
+	fprintf(stderr, "  -r <run times>   exp, pareto[:alpha] or lognormal[:sigma] (default exp)\n");
+	fprintf(stderr, "  -p <mix>         priority mix as priority:weight,... (default 1,2,3,4,5)\n");
+	fprintf(stderr, "  -U               force strictly increasing arrival times\n");
+	fprintf(stderr, "  -o <file>        output file (default stdout)\n");
+}
+
+
+/*
+ * Writes the decimal representation of value at p and returns the position
+ * just past it. fprintf() dominates the run time of large traces otherwise.
+ */
+static char *put_int(char *p, int value)
+{
+	char digits[12];
+	int n = 0;
+	unsigned int v = (value < 0 ? -(unsigned int)value : (unsigned int)value);
+
+	if (value < 0)
+		*p++ = '-';
+
+	do
+	{
+		digits[n++] = '0' + v % 10;
+		v /= 10;
+	} while (v != 0);
+
+	while (n > 0)
+		*p++ = digits[--n];
+
+	return p;
+}
+
+
+int main(int argc, char **argv)
+{
+	int c;
+	char *output_name = NULL;
+	workload_config_t config;
+
+	workload_config_init(&config);
+
+	/*
+	 * Parse command line options.
+	 */
+	while ((c = getopt(argc, argv, "n:s:c:u:m:M:a:r:p:Uo:")) != -1)
+	{
+		switch (c)
+		{
+			case 'n': config.jobs = atoll(optarg); break;
+			case 's': config.seed = strtoull(optarg, NULL, 0); break;
+			case 'c': config.cores = atoi(optarg); break;
+			case 'u': config.utilization = atof(optarg); break;
+			case 'm': config.mean_run_time = atof(optarg); break;
+			case 'M': config.max_run_time = atoi(optarg); break;
+			case 'U': config.unique_arrivals = 1; break;
+			case 'o': output_name = optarg; break;
+
+			case 'a':
+				if (workload_parse_arrivals(&config, optarg) != 0)
+				{
+					fprintf(stderr, "Option -a <arrivals> requires poisson or mmpp[:factor[:fraction[:length]]].\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'r':
+				if (workload_parse_run_times(&config, optarg) != 0)
+				{
+					fprintf(stderr, "Option -r <run times> requires exp, pareto[:alpha] or lognormal[:sigma].\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			case 'p':
+				if (workload_parse_mix(&config, optarg) != 0)
+				{
+					fprintf(stderr, "Option -p <mix> requires a list of priority:weight pairs. (Eg: -p 1:10,2:30,3:60)\n");
+					print_usage(argv[0]);
+					return 1;
+				}
+				break;
+
+			default:
+				print_usage(argv[0]);
+				return 1;
+		}
+	}
+
+	if (config.jobs <= 0)
+	{
+		fprintf(stderr, "Required option -n <jobs> requires a positive number.\n");
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	if (optind != argc)
+	{
+		fprintf(stderr, "Unexpected argument \"%s\".\n", argv[optind]);
+		print_usage(argv[0]);
+		return 1;
+	}
+
+	workload_t workload;
+	if (workload_init(&workload, &config) != 0)
+	{
+		fprintf(stderr, "Invalid workload parameters. Utilization and cores must be positive, the mean\n"
+		                "running time at least 1, the Pareto alpha above 1 and MMPP fraction in (0, 1).\n");
+		return 1;
+	}
+
+	FILE *file = stdout;
+	if (output_name != NULL && (file = fopen(output_name, "w")) == NULL)
+	{
+		fprintf(stderr, "Unable to open file \"%s\".\n", output_name);
+		return 2;
+	}
+
+
+	/*
+	 * Stream the trace out in large blocks. Only one job is ever held in
+	 * memory, so the trace length is bounded by disk space alone.
+	 */
+	char *buffer = malloc(OUTPUT_BUFFER_SIZE);
+	char *p = buffer;
+	char *limit = buffer + OUTPUT_BUFFER_SIZE - 64;
+	workload_job_t job;
+
+	p += sprintf(p, "\"Arrival time\",\"Run time\",\"Priority\"\n");
+
+	while (workload_next(&workload, &job))
+	{
+		p = put_int(p, job.arrival_time);
+		*p++ = ',';
+		p = put_int(p, job.run_time);
+		*p++ = ',';
+		p = put_int(p, job.priority);
+		*p++ = '\n';
+
+		if (p >= limit)
+		{
+			if (fwrite(buffer, 1, p - buffer, file) != (size_t)(p - buffer))
+			{
+				fprintf(stderr, "Write error.\n");
+				return 2;
+			}
+			p = buffer;
+		}
+	}
+
+	if (fwrite(buffer, 1, p - buffer, file) != (size_t)(p - buffer) || fflush(file) != 0)
+	{
+		fprintf(stderr, "Write error.\n");
+		return 2;
+	}
+
+	if (file != stdout)
+		fclose(file);
+	free(buffer);
+
+	return 0;
+}